@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          gendata
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Generates reproducible line sets for benchmarking
+ *
+ * Description:
+ *    gendata writes a given number of lines drawn from one of several
+ *    distributions to standard output: Zipfian (a few very frequent
+ *    lines and a long tail, like words or URLs), uniform over a fixed
+ *    set of lines, uniform over a set of long lines, or nearly all
+ *    distinct lines.  The same seed always gives the same output, so
+ *    that benchmark runs on different builds or machines can be
+ *    compared.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file gendata.cpp
+ */
+
+#include <getopt.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+/**
+ * The Zipf exponent; about 1 for word frequencies.
+ */
+const double ZIPF_EXPONENT = 1.1;
+
+void
+printHelp()
+{
+    cout << "gendata - generates lines for benchmarking count" << endl << endl;
+    cout << "Writes LINES lines drawn from the distribution DIST to standard" << endl;
+    cout << "output; DIST is one of:" << endl;
+    cout << endl;
+    cout << "   zipf      Zipfian over D distinct lines (default 100000)" << endl;
+    cout << "   uniform   uniform over D distinct lines (default 100000)" << endl;
+    cout << "   longkey   uniform over D distinct lines of about 200 bytes" << endl;
+    cout << "             (default 10000)" << endl;
+    cout << "   highcard  nearly every line distinct" << endl;
+    cout << endl;
+    cout << "Syntax:" << endl;
+    cout << endl;
+    cout << "   gendata [OPTIONS] DIST" << endl;
+    cout << endl;
+    cout << "Options:" << endl;
+    cout << endl;
+    cout << "   -n LINES  number of lines to write (default 1000000)" << endl;
+    cout << "   -d D      number of distinct lines to draw from" << endl;
+    cout << "   -s SEED   random seed (default 1)" << endl;
+    cout << "   -?        display this help message" << endl;
+}
+
+/**
+ * The splitmix64 mixing function, used to turn a line number into the
+ * letters of the line.
+ */
+inline uint64_t
+Mix ( uint64_t n )
+{
+    n += 0x9e3779b97f4a7c15ULL;
+    n = (n ^ (n >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    n = (n ^ (n >> 27)) * 0x94d049bb133111ebULL;
+    return n ^ (n >> 31);
+}
+
+/**
+ * Appends the nRank-th distinct line to sLine: a word-like string of
+ * 6 to 15 letters, or a path-like string of about 200 bytes if fLong.
+ */
+void
+AppendLine ( uint64_t  nRank,
+             bool      fLong,
+             string   &sLine )
+{
+    uint64_t nBits   = Mix(nRank);
+    size_t   nLength = fLong ? 180 + nBits % 41 : 6 + nBits % 10;
+    for ( size_t i = 0; i < nLength; i++ )
+    {
+        if (i % 12 == 0)
+            nBits = Mix(nBits + nRank);
+        if (fLong && i % 16 == 15)
+            sLine += '/';
+        else
+            sLine += static_cast<char>('a' + (nBits >> (5 * (i % 12))) % 26);
+    }
+}
+
+int
+main ( int    argc,
+       char **argv )
+{
+    long long nLines    = 1000000;
+    long long nDistinct = 0;
+    uint64_t  nSeed     = 1;
+    int       c;
+    while ((c = getopt(argc, argv, "n:d:s:?")) != -1)
+    {
+        istringstream iss(optarg ? optarg : "");
+        switch(c)
+        {
+        case 'n':
+            iss >> nLines;
+            break;
+        case 'd':
+            iss >> nDistinct;
+            break;
+        case 's':
+            iss >> nSeed;
+            break;
+        default:
+            printHelp();
+            exit(1);
+        }
+        if (iss.fail() || nLines < 0 || nDistinct < 0)
+        {
+            cerr << "ERROR: Invalid argument " << optarg << endl;
+            exit(1);
+        }
+    }
+    if (argc - optind != 1)
+    {
+        printHelp();
+        exit(1);
+    }
+    string sDist  = argv[optind];
+    bool   fLong  = sDist == "longkey";
+    bool   fZipf  = sDist == "zipf";
+    if (sDist == "highcard")
+        nDistinct = 1LL << 40;
+    else if (!nDistinct)
+        nDistinct = fLong ? 10000 : 100000;
+    if (!fLong && !fZipf && sDist != "uniform" && sDist != "highcard")
+    {
+        cerr << "ERROR: Unknown distribution " << sDist << endl;
+        exit(1);
+    }
+
+    // the cumulative Zipf distribution over the ranks
+    vector<double> Cumulative;
+    if (fZipf)
+    {
+        Cumulative.resize(nDistinct);
+        double nTotal = 0;
+        for ( long long i = 0; i < nDistinct; i++ )
+        {
+            nTotal += 1.0 / pow(i + 1, ZIPF_EXPONENT);
+            Cumulative[i] = nTotal;
+        }
+    }
+
+    // mt19937_64 gives the same numbers everywhere, unlike the standard
+    // distributions, so the draws are made from its bits directly
+    mt19937_64 Random(nSeed);
+    string     sBuffer;
+    for ( long long i = 0; i < nLines; i++ )
+    {
+        uint64_t nRank;
+        if (fZipf)
+        {
+            double nUnit = (Random() >> 11) * 0x1.0p-53;
+            nRank = lower_bound(Cumulative.begin(), Cumulative.end(),
+                                nUnit * Cumulative.back()) -
+                    Cumulative.begin();
+        }
+        else
+        {
+            nRank = Random() % nDistinct;
+        }
+        AppendLine(nRank, fLong, sBuffer);
+        sBuffer += '\n';
+        if (sBuffer.size() >= (1 << 20))
+        {
+            cout.write(sBuffer.data(), sBuffer.size());
+            sBuffer.clear();
+        }
+    }
+    cout.write(sBuffer.data(), sBuffer.size());
+    return cout.good() ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#!/usr/bin/env python3
+#
+# runbench.py - benchmarks the count tools against sort | uniq -c and awk
+#
+# Author: wildwilhelm@gmail.com (WKR)
+# Creation Date: 17 October 2026
+#
+# Generates each data set with gendata, then times every benchmark case
+# on it a number of times.  Each run is written as one JSON object per
+# line, with its wall, user and system time, throughput and peak
+# resident memory (CPU time is that of the whole pipeline, and memory
+# that of its largest process, as measured by runtimed), so that result
+# files from different builds or machines can be compared with
+# --compare.  A table of the median of each case is printed as well.
+#
+# Revision Information:
+#
+#    (WKR) 17 October 2026
+#          - Initial version.
+#
+#    (WKR) 18 October 2026
+#          - Measure each case with runtimed, so that its peak memory
+#            is not that of the Python interpreter.
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+DATASETS = ['zipf', 'uniform', 'longkey', 'highcard']
+
+# The awk equivalent of sortalph, as given in README.md.
+AWK_SUM = ("awk 'BEGIN{{FS=OFS=\"\\t\"}} {{v=$1; $1=\"\"; "
+           "c[substr($0,2)]+=v}} END {{for (x in c) print c[x], x}}' "
+           "{files} | sort -k2")
+
+# Each case is (tool, name, command); commands are run by the shell,
+# with {bin} the directory of the tools, {data} the data set, {cnt} and
+# {cnt2} sorted count files of it and of a second data set, and {cat}
+# the two count files concatenated (unsorted).
+CASES = [
+    ('count', 'count', '{bin}/count {data}'),
+    ('count', 'count -f', '{bin}/count -f {data}'),
+    ('count', 'count stdin', '{bin}/count < {data}'),
+    ('count', 'sort | uniq -c', 'sort {data} | uniq -c'),
+    ('count', 'awk', "awk '{{c[$0]++}} END {{for (x in c) print c[x], x}}' "
+                     "{data} | sort -k2"),
+    ('sortalph', 'sortalph', '{bin}/sortalph {cat}'),
+    ('sortalph', 'awk', AWK_SUM.replace('{files}', '{cat}')),
+    ('addcount', 'addcount', '{bin}/addcount {cnt} {cnt2}'),
+    ('addcount', 'awk', AWK_SUM.replace('{files}', '{cnt} {cnt2}')),
+    ('threshcount', 'threshcount', '{bin}/threshcount 2 < {cnt}'),
+    ('threshcount', 'awk', "awk '{{if (2 < $1) print $0}}' {cnt}"),
+]
+
+
+def run_timed(runtimed, command):
+    """Runs command through the shell, under runtimed, with its output
+    discarded, and returns its wall, user and system time and peak
+    memory; runtimed includes the children that the shell waited for,
+    i.e. the whole pipeline.  It is not measured from here because a
+    process forked from Python starts with Python's peak memory."""
+    with open(os.devnull, 'wb') as devnull:
+        start = time.perf_counter()
+        process = subprocess.run([runtimed, command], stdout=devnull,
+                                 stderr=subprocess.PIPE)
+        wall = time.perf_counter() - start
+    lines = process.stderr.decode(errors='replace').splitlines()
+    report = lines.pop().split() if lines else []
+    sys.stderr.write(''.join(line + '\n' for line in lines))
+    if process.returncode != 0 or len(report) != 4 or \
+            report[0] != 'runtimed':
+        sys.exit('ERROR: benchmark command failed: ' + command)
+    return wall, float(report[1]), float(report[2]), int(report[3])
+
+
+def git_revision(directory):
+    try:
+        return subprocess.run(['git', '-C', directory, 'describe',
+                               '--always', '--dirty'],
+                              capture_output=True, text=True,
+                              check=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ''
+
+
+def make_inputs(args, dataset, workdir):
+    """Generates the data set and the count files the cases read."""
+    files = {name: os.path.join(workdir, dataset + '.' + name)
+             for name in ['data', 'data2', 'cnt', 'cnt2', 'cat']}
+    for name, seed in [('data', args.seed), ('data2', args.seed + 1)]:
+        with open(files[name], 'wb') as output:
+            subprocess.run([args.gendata, '-n', str(args.lines),
+                            '-s', str(seed), dataset],
+                           stdout=output, check=True)
+    for data, cnt in [('data', 'cnt'), ('data2', 'cnt2')]:
+        with open(files[cnt], 'wb') as output:
+            subprocess.run([os.path.join(args.bin, 'count'), files[data]],
+                           stdout=output, check=True)
+    with open(files['cat'], 'wb') as output:
+        for cnt in ['cnt2', 'cnt']:
+            with open(files[cnt], 'rb') as input_file:
+                shutil.copyfileobj(input_file, output)
+    return files
+
+
+def run_benchmarks(args):
+    revision = git_revision(os.path.dirname(os.path.abspath(__file__)))
+    host = platform.node()
+    workdir = tempfile.mkdtemp(prefix='countbench.', dir=args.tmpdir)
+    # sort compares bytes, as the tools do, rather than by locale
+    os.environ['LC_ALL'] = 'C'
+    records = []
+    try:
+        for dataset in args.datasets:
+            files = make_inputs(args, dataset, workdir)
+            for tool, name, template in CASES:
+                if args.tools and tool not in args.tools:
+                    continue
+                command = template.format(bin=args.bin, **files)
+                input_name = 'data' if tool == 'count' else (
+                    'cat' if tool == 'sortalph' else 'cnt')
+                nbytes = os.path.getsize(files[input_name])
+                if tool == 'addcount':
+                    nbytes += os.path.getsize(files['cnt2'])
+                for run in range(args.repeat):
+                    wall, user, system, max_rss = run_timed(
+                        args.runtimed, command)
+                    record = {
+                        'dataset': dataset,
+                        'lines': args.lines,
+                        'tool': tool,
+                        'case': name,
+                        'run': run,
+                        'input_bytes': nbytes,
+                        'wall_s': round(wall, 4),
+                        'user_s': round(user, 4),
+                        'sys_s': round(system, 4),
+                        'max_rss_kb': max_rss,
+                        'mb_per_s': round(nbytes / wall / 1e6, 2),
+                        'revision': revision,
+                        'host': host,
+                    }
+                    records.append(record)
+                    args.output.write(json.dumps(record) + '\n')
+                    args.output.flush()
+            for path in files.values():
+                os.unlink(path)
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+    return records
+
+
+def medians(records):
+    """Groups the runs by data set and case, and returns the median
+    wall time, CPU time, throughput and peak memory of each."""
+    groups = {}
+    for record in records:
+        key = (record['dataset'], record['tool'], record['case'])
+        groups.setdefault(key, []).append(record)
+    result = {}
+    for key, runs in groups.items():
+        result[key] = {
+            'wall_s': statistics.median(r['wall_s'] for r in runs),
+            'cpu_s': statistics.median(r['user_s'] + r['sys_s']
+                                       for r in runs),
+            'mb_per_s': statistics.median(r['mb_per_s'] for r in runs),
+            'max_rss_kb': max(r['max_rss_kb'] for r in runs),
+        }
+    return result
+
+
+def print_table(records, out):
+    out.write('%-9s %-12s %-16s %9s %9s %9s %10s\n' %
+              ('dataset', 'tool', 'case', 'wall s', 'cpu s', 'MB/s',
+               'rss KB'))
+    for (dataset, tool, case), m in medians(records).items():
+        out.write('%-9s %-12s %-16s %9.3f %9.3f %9.1f %10d\n' %
+                  (dataset, tool, case, m['wall_s'], m['cpu_s'],
+                   m['mb_per_s'], m['max_rss_kb']))
+
+
+def read_records(file_name):
+    with open(file_name) as input_file:
+        return [json.loads(line) for line in input_file if line.strip()]
+
+
+def compare(old_name, new_name, out):
+    """Prints the median wall time and peak memory of each case in two
+    result files, with the ratio of new to old."""
+    old = medians(read_records(old_name))
+    new = medians(read_records(new_name))
+    out.write('%-9s %-12s %-16s %9s %9s %7s %10s %10s\n' %
+              ('dataset', 'tool', 'case', 'old s', 'new s', 'ratio',
+               'old KB', 'new KB'))
+    for key in old:
+        if key not in new:
+            continue
+        o, n = old[key], new[key]
+        ratio = n['wall_s'] / o['wall_s'] if o['wall_s'] else float('nan')
+        out.write('%-9s %-12s %-16s %9.3f %9.3f %7.2f %10d %10d\n' %
+                  (key + (o['wall_s'], n['wall_s'], ratio,
+                          o['max_rss_kb'], n['max_rss_kb'])))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Benchmarks count, sortalph, addcount and threshcount '
+                    'against sort | uniq -c and awk.')
+    parser.add_argument('--bin', default='../src',
+                        help='directory holding the tools')
+    parser.add_argument('--gendata', default='./gendata',
+                        help='the data generator')
+    parser.add_argument('--runtimed', default='./runtimed',
+                        help='the program that measures each case')
+    parser.add_argument('--lines', type=int, default=1000000,
+                        help='lines per data set')
+    parser.add_argument('--datasets', default=','.join(DATASETS),
+                        help='comma-separated data sets to run')
+    parser.add_argument('--tools', default='',
+                        help='comma-separated tools to run (default all)')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='runs of each case')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--tmpdir', default=None,
+                        help='where to generate the data')
+    parser.add_argument('--output', default='-',
+                        help='file for the JSON results (default stdout)')
+    parser.add_argument('--compare', nargs=2, metavar=('OLD', 'NEW'),
+                        help='compare two result files instead')
+    args = parser.parse_args()
+
+    if args.compare:
+        compare(args.compare[0], args.compare[1], sys.stdout)
+        return
+    args.datasets = [d for d in args.datasets.split(',') if d]
+    for dataset in args.datasets:
+        if dataset not in DATASETS:
+            sys.exit('ERROR: Unknown data set ' + dataset)
+    args.tools = [t for t in args.tools.split(',') if t]
+    args.bin = os.path.abspath(args.bin)
+    args.gendata = os.path.abspath(args.gendata)
+    args.runtimed = os.path.abspath(args.runtimed)
+    to_stdout = args.output == '-'
+    args.output = sys.stdout if to_stdout else open(args.output, 'w')
+    records = run_benchmarks(args)
+    print_table(records, sys.stderr if to_stdout else sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          runtimed
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 18 October 2026
+ *
+ * Purpose:       Measures the CPU time and peak memory of a command
+ *
+ * Description:
+ *    runtimed runs a command through the shell, waits for it, and
+ *    writes the user and system time and the peak resident memory of
+ *    the command and all of the processes it waited for to standard
+ *    error, as the line "runtimed USER SYS MAXRSS_KB".  It exits with
+ *    the status of the command.
+ *
+ *    runbench.py runs every benchmark case through it rather than
+ *    forking the shell itself, because a process forked from the Python
+ *    interpreter starts with the interpreter's peak memory, which would
+ *    then be reported for any tool smaller than it.  runtimed is small,
+ *    and uses only the C library, so that the figure it reports is the
+ *    tool's own.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 18 October 2026
+ *          - Initial version.
+ *
+ * \file runtimed.cpp
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main ( int argc, char **argv )
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Syntax: runtimed COMMAND\n");
+        return 1;
+    }
+    pid_t nPid = fork();
+    if (nPid < 0)
+    {
+        fprintf(stderr, "ERROR: Could not run %s\n", argv[1]);
+        return 1;
+    }
+    if (nPid == 0)
+    {
+        execl("/bin/sh", "sh", "-c", argv[1], (char *) 0);
+        _exit(127);
+    }
+    int nStatus = 0;
+    while (waitpid(nPid, &nStatus, 0) < 0 && errno == EINTR)
+        ;
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    fprintf(stderr, "runtimed %ld.%06ld %ld.%06ld %ld\n",
+            (long) usage.ru_utime.tv_sec, (long) usage.ru_utime.tv_usec,
+            (long) usage.ru_stime.tv_sec, (long) usage.ru_stime.tv_usec,
+            usage.ru_maxrss);
+    return WIFEXITED(nStatus) ? WEXITSTATUS(nStatus) : 1;
+}
@@ -7,21 +7,39 @@
  * Author:        wildwilhelm@gmail.com (WKR)
  * Creation Date: 6 December 2013
  *
- * Purpose:       Sum two count files together
+ * Purpose:       Sum count files together
  *
  * Description:
- *    addcount sums the counts stored in two count files together,
- *    outputting the results to standard output (or to file, if
- *    specified).  The two input count files contain at least two
+ *    addcount sums the counts stored in two or more count files
+ *    together, outputting the results to standard output (or to file,
+ *    if specified).  The input count files contain at least two
  *    tab-separated columns; the first specifying the count and the
  *    second the value.  The files must be sorted in alphabetical
- *    order on the second (value) column.
+ *    order on the second (value) column.  All the inputs are merged in
+ *    a single pass.
  *
  * Revision Information:
  *
  *    (WKR) 6 December 2013
  *          - Initial version.
  *
+ *    (WKR) 17 October 2026
+ *          - ReadCountLine moved to countrun.cpp, to be shared with
+ *            the run merging in count and sortalph; integer counts
+ *            are read as long long.
+ *          - Binary count files are read transparently; -b writes
+ *            binary output.
+ *          - Read the inputs with CountReader.
+ *          - Write the output through a buffered OutputFile.
+ *          - Merge any number of inputs in one pass through a loser
+ *            tree; add -o OUTPUT.
+ *          - -j N merges mapped text inputs in key ranges on N
+ *            threads.
+ *          - Read compressed inputs; add -z to compress the output.
+ *          - Add --stats, --stats-json and --progress.
+ *          - Add --distinct to merge the cardinality sketches written
+ *            by count --sketch, with --sketch to save the result.
+ *
  * \file addcount.cpp
  */
 
@@ -29,121 +47,148 @@
 
 #include "config.h"
 #include <getopt.h>
-#include <fstream>
+#include <math.h>
+#include <stdlib.h>
 #include <iostream>
-#include <sstream>
+#include "bincount.h"
+#include "compression.h"
+#include "countrun.h"
+#include "hyperloglog.h"
+#include "inputfile.h"
+#include "outputfile.h"
+#include "rangemerge.h"
+#include "toolstats.h"
 using namespace std;
 
 void
 printHelp()
 {
     cout << "addcount - " << PACKAGE_STRING << endl << endl;
-    cout << "addcount sums the counts stored in two count files together," << endl;
+    cout << "addcount sums the counts stored in two or more count files together," << endl;
     cout << "outputting the results to standard output (or to the file OUTPUT, if" << endl;
-    cout << "this is specified).  The two input count files INPUT1 and INPUT2" << endl;
-    cout << "contain at least two tab-separated columns; the first specifying the" << endl;
-    cout << "count and the second the value.  The files must be sorted in" << endl;
-    cout << "alphabetical order on the second (value) column.  At most one of" << endl;
-    cout << "INPUT1 and INPUT2 can be the character \"-\", indicating that this" << endl;
-    cout << "stream should be read from standard input." << endl;
+    cout << "this is specified).  The input count files INPUT1, INPUT2, ... contain" << endl;
+    cout << "at least two tab-separated columns; the first specifying the count and" << endl;
+    cout << "the second the value.  The files must be sorted in alphabetical order" << endl;
+    cout << "on the second (value) column.  At most one of the inputs can be the" << endl;
+    cout << "character \"-\", indicating that this stream should be read from" << endl;
+    cout << "standard input.  Any input may be a binary count file.  All of the" << endl;
+    cout << "inputs are merged together in a single pass." << endl;
+    cout << endl;
+    cout << "Without -o, a third argument is taken to be OUTPUT, as in earlier" << endl;
+    cout << "versions; to sum exactly three files, give -o." << endl;
+    cout << endl;
+    cout << "With --distinct, the inputs are instead sketch files written by count" << endl;
+    cout << "--sketch (over different shards or days of input, say); addcount" << endl;
+    cout << "merges them and outputs an estimate of the number of distinct lines" << endl;
+    cout << "in all of them together.  A single input is allowed, and every" << endl;
+    cout << "argument is an input." << endl;
     cout << endl;
     cout << "Syntax:" << endl;
     cout << endl;
     cout << "   addcount [OPTIONS] INPUT1 INPUT2 [OUTPUT]" << endl;
+    cout << "   addcount [OPTIONS] [-o OUTPUT] INPUT1 INPUT2 INPUT3..." << endl;
+    cout << "   addcount --distinct [--sketch FILE] [-o OUTPUT] SKETCH1..." << endl;
     cout << endl;
     cout << "Options:" << endl;
     cout << endl;
+    cout << "   -b      write a binary count file (see countconv)" << endl;
     cout << "   -d      interpret counts as floating-point numbers" << endl;
+    cout << "   -j N    merge in parallel on N threads, splitting the values into" << endl;
+    cout << "           ranges; this needs all of the inputs to be text count files," << endl;
+    cout << "           and not standard input, and text output (default: 1)" << endl;
+    cout << "   -o OUTPUT" << endl;
+    cout << "           write the output to OUTPUT" << endl;
+    cout << "   -z FORMAT" << endl;
+    cout << "           compress the output with FORMAT: gzip, xz or zstd" << endl;
+    cout << "   --distinct" << endl;
+    cout << "           merge sketch files and output the estimated number of" << endl;
+    cout << "           distinct lines; sketches of different precisions are" << endl;
+    cout << "           merged at the lowest.  Cannot be combined with -b, -d," << endl;
+    cout << "           -j or -z" << endl;
+    cout << "   --sketch FILE" << endl;
+    cout << "           with --distinct, also write the merged sketch to FILE" << endl;
+    cout << "   --stats print statistics of the run to standard error: lines and" << endl;
+    cout << "           bytes read, distinct values, time in each phase, heap" << endl;
+    cout << "           allocations and peak memory" << endl;
+    cout << "   --stats-json FILE" << endl;
+    cout << "           write the statistics to FILE as a JSON object" << endl;
+    cout << "   --progress SECONDS" << endl;
+    cout << "           print the input read so far to standard error every" << endl;
+    cout << "           SECONDS seconds" << endl;
     cout << "   -?      display this help message" << endl;
 }
 
-void
-cleanup ( ifstream *inputFile1,
-          ifstream *inputFile2,
-          ofstream *outputFile )
+/**
+ * Writes one record of output: as a text line to output, or to
+ * binaryOutput if it is set.
+ */
+inline void
+WriteCount ( OutputFile        &output,
+             BinaryCountWriter *binaryOutput,
+             bool               fFloatingPoint,
+             long long          nCount,
+             double             nFloatCount,
+             string_view        Value )
 {
-    if (inputFile1)
-    {
-        inputFile1->close();
-        delete inputFile1;
-        inputFile1 = 0;
-    }
-    if (inputFile2)
-    {
-        inputFile2->close();
-        delete inputFile2;
-        inputFile2 = 0;
-    }
-    if (outputFile)
-    {
-        outputFile->close();
-        delete outputFile;
-        outputFile = 0;
-    }
+    if (binaryOutput)
+        binaryOutput->Write(Value, nCount, nFloatCount);
+    else if (fFloatingPoint)
+        output.WriteRecord(nFloatCount, Value);
+    else
+        output.WriteRecord(nCount, Value);
 }
 
-bool
-ReadCountLine ( const string &sFileName,
-                ifstream     *inputFile,
-                bool          fFloatingPoint,
-                bool         &fDidRead,
-                int          &nLinesRead,
-                int          &nCount,
-                double       &nFloatCount,
-                string       &sValue,
-                string       &sLastValue )
+/**
+ * Merges the sketch files InputNames, writes the estimated number of
+ * distinct values to sOutputFileName and, if sSketchFileName is not
+ * empty, the merged sketch to that file.  Returns the exit status.
+ */
+int
+MergeSketches ( const vector<string> &InputNames,
+                const string         &sSketchFileName,
+                const string         &sOutputFileName,
+                ToolStats            &Stats )
 {
-    fDidRead     = false;
-    string sLine = "";
-    if ((inputFile && *inputFile) ||
-        (!inputFile && cin))
+    Stats.Start("merge");
+    HyperLogLog Merged;
+    for ( size_t i = 0; i < InputNames.size(); i++ )
     {
-        fDidRead    = true;
-        nLinesRead += 1;
-        if (inputFile)
-            getline ( *inputFile, sLine );
+        HyperLogLog Sketch;
+        if (!Sketch.Load(InputNames[i]))
+            return 1;
+        if (i == 0)
+            Merged = Sketch;
         else
-            getline ( cin, sLine );
-        if (((inputFile && !*inputFile) ||
-             (!inputFile && !cin)) && sLine.length() == 0)
-        {
-            fDidRead = false;
-            return false;
-        }
-        size_t nFirstTab = sLine.find_first_of('\t');
-        if (nFirstTab == string::npos)
-        {
-            cerr << sFileName << ":" << nLinesRead
-                 << ": error: no tab character found on line" << endl;
-            return true;
-        }
-        sValue = sLine.substr(nFirstTab + 1);
-        istringstream iss(sLine.substr(0, nFirstTab));
-        if (fFloatingPoint)
-        {
-            iss >> nFloatCount;
-        }
-        else
-        {
-            iss >> nCount;
-        }
-        if (iss.fail())
-        {
-            cerr << sFileName << ":" << nLinesRead
-                 << ": error: could not read count field" << endl;
-            return true;
-        }
+            Merged.Merge(Sketch);
     }
-
-    if (nLinesRead > 1 && 0 <= sLastValue.compare(sValue))
+    long long nEstimate = llround(Merged.Estimate());
+    Stats.Set("distinct_estimate", nEstimate);
+    Stats.Phase("write");
+    if (!sSketchFileName.empty() && !Merged.Save(sSketchFileName))
+        return 1;
+    OutputFile output;
+    if (!output.Open(sOutputFileName))
     {
-        cerr << sFileName << ":" << nLinesRead
-             << ": error: file not sorted" << endl;
-        return true;
+        cerr << "ERROR: Could not open file " << sOutputFileName << endl;
+        return 1;
     }
-    sLastValue = sValue;
+    output.WriteNumber(nEstimate);
+    output.Put('\n');
+    if (!output.Close())
+    {
+        cerr << "ERROR: Could not write file " << output.Name() << endl;
+        return 1;
+    }
+    return Stats.Report() ? 0 : 1;
+}
 
-    return false;
+template<typename T>
+void
+cleanup ( vector<T *> &Inputs )
+{
+    for ( size_t i = 0; i < Inputs.size(); i++ )
+        delete Inputs[i];
+    Inputs.clear();
 }
 
 int main ( int argc, char **argv )
@@ -153,14 +198,63 @@ int main ( int argc, char **argv )
 #endif // DEBUG
 
     bool       fFloatingPoint      = false;
+    bool       fBinaryOutput       = false;
+    int        nThreads            = 1;
+    string     sOutputFileName     = "";
+    Compression OutputCompression  = COMPRESSION_NONE;
+    bool       fDistinct           = false;
+    string     sSketchFileName     = "";
+    ToolStats  Stats("addcount");
     int        c;
-    while ((c = getopt(argc, argv, "d?")) != -1)
+    static const struct option LongOptions[] =
+    {
+        { "distinct",   no_argument,       0, 'N' },
+        { "sketch",     required_argument, 0, 'W' },
+        { "stats",      no_argument,       0, STATS_OPTION },
+        { "stats-json", required_argument, 0, STATS_JSON_OPTION },
+        { "progress",   required_argument, 0, PROGRESS_OPTION },
+        { 0,            0,                 0, 0 }
+    };
+    while ((c = getopt_long(argc, argv, "bdj:o:z:?", LongOptions, 0)) != -1)
     {
         switch(c)
         {
+        case 'b':
+            fBinaryOutput = true;
+            break;
         case 'd':
             fFloatingPoint = true;
             break;
+        case 'j':
+            nThreads = atoi(optarg);
+            if (nThreads < 1)
+            {
+                cerr << "ERROR: -j needs a positive number of threads" << endl;
+                exit(1);
+            }
+            break;
+        case 'o':
+            sOutputFileName = optarg;
+            break;
+        case 'z':
+            if (!ParseCompression(optarg, OutputCompression))
+                exit(1);
+            break;
+        case 'N':
+            fDistinct = true;
+            break;
+        case 'W':
+            sSketchFileName = optarg;
+            break;
+        case STATS_OPTION:
+        case STATS_JSON_OPTION:
+        case PROGRESS_OPTION:
+            if (!Stats.ParseOption(c, optarg))
+            {
+                printHelp();
+                exit(1);
+            }
+            break;
         case '?':
             printHelp();
             exit(1);
@@ -170,318 +264,158 @@ int main ( int argc, char **argv )
         }
     }
 
-    string    sFile1Name      = "";
-    string    sFile2Name      = "";
-    string    sOutputFileName = "";
-
-    ifstream *inputFile1      = 0;
-    ifstream *inputFile2      = 0;
-    ofstream *outputFile      = 0;
-
-    if ((argc - optind) < 2)
+    vector<string> InputNames(argv + optind, argv + argc);
+    if (!sSketchFileName.empty() && !fDistinct)
     {
-        cerr << "ERROR: Missing input arguments." << endl;
-        printHelp();
+        cerr << "ERROR: --sketch requires --distinct" << endl;
         exit(1);
     }
-
-    sFile1Name = argv[optind];
-    if (sFile1Name.compare("-") == 0)
-    {
-#ifdef DEBUG
-        cout << "file1 stdin" << endl;
-#endif // DEBUG
-        inputFile1 = 0;
-        sFile1Name = "<stdin>";
-    }
-    else
+    if (fDistinct)
     {
-#ifdef DEBUG
-        cout << "file1 " << sFile1Name << endl;
-#endif // DEBUG
-        inputFile1 = new ifstream();
-        inputFile1->open(sFile1Name.c_str());
-        if (!*inputFile1)
+        if (fBinaryOutput || fFloatingPoint || nThreads > 1 ||
+            OutputCompression != COMPRESSION_NONE)
         {
-            cerr << "ERROR: Could not open file " << sFile1Name << endl;
+            cerr << "ERROR: --distinct cannot be combined with -b, -d, -j "
+                 << "or -z" << endl;
             exit(1);
         }
-    }
-
-    sFile2Name = argv[optind + 1];
-    if (sFile2Name.compare("-") == 0)
-    {
-        if (!inputFile1)
+        if (InputNames.empty())
         {
-            cerr << "ERROR: only one input file can be standard input" << endl;
-            cleanup(inputFile1, inputFile2, outputFile);
-            exit(1);
-        }
-#ifdef DEBUG
-        cout << "file2 stdin" << endl;
-#endif // DEBUG
-        inputFile2 = 0;
-        sFile2Name = "<stdin>";
-    }
-    else
-    {
-#ifdef DEBUG
-        cout << "file2 " << sFile2Name << endl;
-#endif // DEBUG
-        inputFile2 = new ifstream();
-        inputFile2->open(sFile2Name.c_str());
-        if (!*inputFile2)
-        {
-            cerr << "ERROR: Could not open file " << sFile2Name <<endl;
-            cleanup(inputFile1, inputFile2, outputFile);
-            exit(1);
-        }
-    }
-    if ((argc - optind) == 2)
-    {
-#ifdef DEBUG
-        cout << "output to stdout" << endl;
-#endif // DEBUG
-        outputFile      = 0;
-        sOutputFileName = "<stdout>";
-    }
-    else
-    {
-        sOutputFileName = argv[optind + 2];
-#ifdef DEBUG
-        cout << "output to " << sOutputFileName << endl;
-#endif // DEBUG
-        outputFile = new ofstream(sOutputFileName.c_str());
-        if (!*outputFile)
-        {
-            cerr << "ERROR: Could not open file " << sOutputFileName <<endl;
-            cleanup(inputFile1, inputFile2, outputFile);
+            cerr << "ERROR: Missing input arguments." << endl;
+            printHelp();
             exit(1);
         }
+        return MergeSketches(InputNames, sSketchFileName,
+                             sOutputFileName.empty() ? "-" : sOutputFileName,
+                             Stats);
     }
-
-    int    nLineNum1 = 0;
-    int    nLineNum2 = 0;
-    bool   fReadLine1;
-    int    nCount1;
-    double nFloatCount1;
-    string sValue1;
-    string sLastValue1;
-    bool   fReadLine2;
-    int    nCount2;
-    double nFloatCount2;
-    string sValue2;
-    string sLastValue2;
-    if (ReadCountLine ( sFile1Name,
-                        inputFile1,
-                        fFloatingPoint,
-                        fReadLine1,
-                        nLineNum1,
-                        nCount1,
-                        nFloatCount1,
-                        sValue1,
-                        sLastValue1 ))
-    {
-        cleanup(inputFile1, inputFile2, outputFile);
-        exit(1);
-    }
-    if (ReadCountLine ( sFile2Name,
-                        inputFile2,
-                        fFloatingPoint,
-                        fReadLine2,
-                        nLineNum2,
-                        nCount2,
-                        nFloatCount2,
-                        sValue2,
-                        sLastValue2 ))
+    if (InputNames.size() < 2)
     {
-        cleanup(inputFile1, inputFile2, outputFile);
+        cerr << "ERROR: Missing input arguments." << endl;
+        printHelp();
         exit(1);
     }
-
-#ifdef DEBUG
-    if (fReadLine1)
+    if (sOutputFileName.empty())
     {
-        cout << "nCount1 \"" << nCount1 << "\"" << endl;
-        cout << "sValue1 \"" << sValue1 << "\"" << endl;
-    }
-#endif // DEBUG
-
-    while (fReadLine1 && fReadLine2)
-    {
-        int nCompare = sValue1.compare(sValue2);
-        if (nCompare < 0)
+        if (InputNames.size() == 3)
         {
-            if (fFloatingPoint)
-            {
-                if (outputFile)
-                    *outputFile << nFloatCount1 << "\t" << sValue1 << endl;
-                else
-                    cout << nFloatCount1 << "\t" << sValue1 << endl;
-            }
-            else
-            {
-                if (outputFile)
-                    *outputFile << nCount1 << "\t" << sValue1 << endl;
-                else
-                    cout << nCount1 << "\t" << sValue1 << endl;
-            }
-            // process 1
-            if (ReadCountLine ( sFile1Name,
-                                inputFile1,
-                                fFloatingPoint,
-                                fReadLine1,
-                                nLineNum1,
-                                nCount1,
-                                nFloatCount1,
-                                sValue1,
-                                sLastValue1 ))
-            {
-                cleanup(inputFile1, inputFile2, outputFile);
-                exit(1);
-            }
+            sOutputFileName = InputNames.back();
+            InputNames.pop_back();
         }
-        else if (nCompare == 0)
+        else
         {
-            if (fFloatingPoint)
-            {
-                if (outputFile)
-                    *outputFile << nFloatCount1 + nFloatCount2 << "\t" << sValue1 << endl;
-                else
-                    cout << nFloatCount1 + nFloatCount2 << "\t" << sValue1 << endl;
-            }
-            else
-            {
-                if (outputFile)
-                    *outputFile << nCount1 + nCount2 << "\t" << sValue1 << endl;
-                else
-                    cout << nCount1 + nCount2 << "\t" << sValue1 << endl;
-            }
-            // process 1
-            if (ReadCountLine ( sFile1Name,
-                                inputFile1,
-                                fFloatingPoint,
-                                fReadLine1,
-                                nLineNum1,
-                                nCount1,
-                                nFloatCount1,
-                                sValue1,
-                                sLastValue1 ))
-            {
-                cleanup(inputFile1, inputFile2, outputFile);
-                exit(1);
-            }
-            // process 2
-            if (ReadCountLine ( sFile2Name,
-                                inputFile2,
-                                fFloatingPoint,
-                                fReadLine2,
-                                nLineNum2,
-                                nCount2,
-                                nFloatCount2,
-                                sValue2,
-                                sLastValue2 ))
-            {
-                cleanup(inputFile1, inputFile2, outputFile);
-                exit(1);
-            }
+            sOutputFileName = "-";
         }
-        else
+    }
+
+    // with several threads, mapped text inputs are merged in ranges;
+    // anything else falls back to the sequential merge below
+    vector<const InputFile *> Files;
+    for ( size_t i = 0; nThreads > 1 && !fBinaryOutput &&
+                        i < InputNames.size(); i++ )
+    {
+        InputFile *pFile = new InputFile();
+        Files.push_back(pFile);
+        if (InputNames[i].compare("-") == 0 || !pFile->Open(InputNames[i]) ||
+            !CanMergeInRanges(*pFile))
         {
-            if (fFloatingPoint)
-            {
-                if (outputFile)
-                    *outputFile << nFloatCount2 << "\t" << sValue2 << endl;
-                else
-                    cout << nFloatCount2 << "\t" << sValue2 << endl;
-            }
-            else
-            {
-                if (outputFile)
-                    *outputFile << nCount2 << "\t" << sValue2 << endl;
-                else
-                    cout << nCount2 << "\t" << sValue2 << endl;
-            }
-            // process 2
-            if (ReadCountLine ( sFile2Name,
-                                inputFile2,
-                                fFloatingPoint,
-                                fReadLine2,
-                                nLineNum2,
-                                nCount2,
-                                nFloatCount2,
-                                sValue2,
-                                sLastValue2 ))
-            {
-                cleanup(inputFile1, inputFile2, outputFile);
-                exit(1);
-            }
+            cleanup(Files);
+            break;
         }
     }
-    while (fReadLine1)
+    if (!Files.empty())
     {
-        if (fFloatingPoint)
+        OutputFile output;
+        if (!output.Open(sOutputFileName, OutputCompression))
         {
-            if (outputFile)
-                *outputFile << nFloatCount1 << "\t" << sValue1 << endl;
-            else
-                cout << nFloatCount1 << "\t" << sValue1 << endl;
+            cerr << "ERROR: Could not open file " << sOutputFileName <<endl;
+            cleanup(Files);
+            exit(1);
         }
-        else
+        Stats.Start("merge");
+        bool fMergeOk = ParallelMergeCountFiles(Files, fFloatingPoint,
+                                                nThreads, output, &Stats);
+        cleanup(Files);
+        if (!fMergeOk)
         {
-            if (outputFile)
-                *outputFile << nCount1 << "\t" << sValue1 << endl;
-            else
-                cout << nCount1 << "\t" << sValue1 << endl;
+            output.Close();
+            exit(1);
         }
-        // process 1
-        if (ReadCountLine ( sFile1Name,
-                            inputFile1,
-                            fFloatingPoint,
-                            fReadLine1,
-                            nLineNum1,
-                            nCount1,
-                            nFloatCount1,
-                            sValue1,
-                            sLastValue1 ))
+        if (!output.Close())
         {
-            cleanup(inputFile1, inputFile2, outputFile);
+            cerr << "ERROR: Could not write file " << output.Name() << endl;
             exit(1);
         }
+        return Stats.Report() ? 0 : 1;
     }
-    while (fReadLine2)
+
+    vector<CountStream *> Inputs;
+    size_t                nStdin = 0;
+    for ( size_t i = 0; i < InputNames.size(); i++ )
     {
-        if (fFloatingPoint)
-        {
-            if (outputFile)
-                *outputFile << nFloatCount2 << "\t" << sValue2 << endl;
-            else
-                cout << nFloatCount2 << "\t" << sValue2 << endl;
-        }
-        else
+        if (InputNames[i].compare("-") == 0 && ++nStdin > 1)
         {
-            if (outputFile)
-                *outputFile << nCount2 << "\t" << sValue2 << endl;
-            else
-                cout << nCount2 << "\t" << sValue2 << endl;
+            cerr << "ERROR: only one input file can be standard input" << endl;
+            cleanup(Inputs);
+            exit(1);
         }
-        // process 2
-        if (ReadCountLine ( sFile2Name,
-                            inputFile2,
-                            fFloatingPoint,
-                            fReadLine2,
-                            nLineNum2,
-                            nCount2,
-                            nFloatCount2,
-                            sValue2,
-                            sLastValue2 ))
+#ifdef DEBUG
+        cout << "file" << i + 1 << " " << InputNames[i] << endl;
+#endif // DEBUG
+        CountFileStream *pInput = new CountFileStream(InputNames[i],
+                                                      fFloatingPoint);
+        pInput->Reader().SetStats(&Stats);
+        Inputs.push_back(pInput);
+        if (pInput->Failed())
         {
-            cleanup(inputFile1, inputFile2, outputFile);
+            cleanup(Inputs);
             exit(1);
         }
     }
 
-    cleanup(inputFile1, inputFile2, outputFile);
+#ifdef DEBUG
+    cout << "output to " << sOutputFileName << endl;
+#endif // DEBUG
+    OutputFile output;
+    if (!output.Open(sOutputFileName, OutputCompression))
+    {
+        cerr << "ERROR: Could not open file " << sOutputFileName <<endl;
+        cleanup(Inputs);
+        exit(1);
+    }
+    BinaryCountWriter *binaryOutput = 0;
+    if (fBinaryOutput)
+        binaryOutput = new BinaryCountWriter(output, fFloatingPoint);
+
+    Stats.Start("merge");
+    long long nDistinct = 0;
+    bool      fMergeOk  = MergeCountStreams(
+        Inputs, fFloatingPoint,
+        [&output, binaryOutput, fFloatingPoint, &nDistinct](
+            long long   nCount,
+            double      nFloatCount,
+            string_view Value)
+        {
+            WriteCount(output, binaryOutput, fFloatingPoint,
+                       nCount, nFloatCount, Value);
+            nDistinct++;
+        });
+    Stats.Set("distinct_keys", nDistinct);
+    cleanup(Inputs);
+    if (!fMergeOk)
+    {
+        output.Close();
+        exit(1);
+    }
+
+    if (binaryOutput)
+        binaryOutput->Finish();
+    delete binaryOutput;
+    if (!output.Close())
+    {
+        cerr << "ERROR: Could not write file " << output.Name() << endl;
+        exit(1);
+    }
 
-    return 0;
+    return Stats.Report() ? 0 : 1;
 }
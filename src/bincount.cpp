@@ -0,0 +1,363 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          bincount
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Compact binary count-file format
+ *
+ * Description:
+ *    Implementation of the binary count-file reader and writer.  See
+ *    bincount.h for a description of the format.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Do not trust the block size before its bytes are read.
+ *
+ * \file bincount.cpp
+ */
+
+#include "config.h"
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include "bincount.h"
+using namespace std;
+
+/**
+ * Records are gathered into blocks of about this many bytes.
+ */
+const size_t BINCOUNT_BLOCK_SIZE = 16 << 10;
+
+static void
+AppendVarint ( string   &sOut,
+               uint64_t  nValue )
+{
+    while (nValue >= 0x80)
+    {
+        sOut.push_back(static_cast<char>((nValue & 0x7F) | 0x80));
+        nValue >>= 7;
+    }
+    sOut.push_back(static_cast<char>(nValue));
+}
+
+static void
+AppendFixed64 ( string   &sOut,
+                uint64_t  nValue )
+{
+    for ( int i = 0; i < 8; i++ )
+    {
+        sOut.push_back(static_cast<char>(nValue & 0xFF));
+        nValue >>= 8;
+    }
+}
+
+static uint64_t
+DoubleBits ( double nValue )
+{
+    uint64_t nBits;
+    memcpy(&nBits, &nValue, sizeof(nBits));
+    return nBits;
+}
+
+static double
+BitsDouble ( uint64_t nBits )
+{
+    double nValue;
+    memcpy(&nValue, &nBits, sizeof(nValue));
+    return nValue;
+}
+
+/**
+ * Decodes a varint from sIn at nPos, advancing nPos.  Returns false if
+ * the varint runs off the end of the buffer.
+ */
+static bool
+ParseVarint ( const string &sIn,
+              size_t       &nPos,
+              uint64_t     &nValue )
+{
+    nValue = 0;
+    for ( int nShift = 0; nShift < 64 && nPos < sIn.size(); nShift += 7 )
+    {
+        unsigned char c = sIn[nPos++];
+        nValue |= static_cast<uint64_t>(c & 0x7F) << nShift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static uint64_t
+ParseFixed64 ( const char *pData )
+{
+    uint64_t nValue = 0;
+    for ( int i = 7; i >= 0; i-- )
+        nValue = (nValue << 8) | static_cast<unsigned char>(pData[i]);
+    return nValue;
+}
+
+BinaryCountWriter::BinaryCountWriter ( OutputFile &output,
+                                       bool        fFloatingPoint )
+    : m_Output(output), m_fFloatingPoint(fFloatingPoint), m_fSorted(true),
+      m_nOffset(0), m_nBlockRecords(0), m_nBlocks(0), m_nDistinct(0),
+      m_nTotal(0), m_nFloatTotal(0)
+{
+    char Header[BINCOUNT_HEADER_SIZE] =
+        { BINCOUNT_MAGIC[0], BINCOUNT_MAGIC[1], BINCOUNT_MAGIC[2],
+          BINCOUNT_MAGIC[3], BINCOUNT_VERSION,
+          static_cast<char>(fFloatingPoint ? BINCOUNT_HEADER_FLOAT : 0),
+          0, 0 };
+    Emit(Header, sizeof(Header));
+}
+
+void
+BinaryCountWriter::Emit ( const char *pData,
+                          size_t      nLength )
+{
+    m_Output.Write(pData, nLength);
+    m_nOffset += nLength;
+}
+
+void
+BinaryCountWriter::Write ( string_view Value,
+                           long long   nCount,
+                           double      nFloatCount )
+{
+    size_t nShared = 0;
+    if (m_nBlockRecords == 0)
+    {
+        // each block starts with a complete value, which also goes in
+        // the index
+        AppendVarint(m_Index, Value.size());
+        m_Index.append(Value.data(), Value.size());
+        AppendVarint(m_Index, m_nOffset);
+    }
+    else
+    {
+        size_t nMax = min(Value.size(), m_sLastValue.size());
+        while (nShared < nMax && Value[nShared] == m_sLastValue[nShared])
+            nShared++;
+    }
+    if (m_nDistinct > 0 && m_fSorted && Value.compare(m_sLastValue) <= 0)
+        m_fSorted = false;
+
+    AppendVarint(m_Block, nShared);
+    AppendVarint(m_Block, Value.size() - nShared);
+    m_Block.append(Value.data() + nShared, Value.size() - nShared);
+    if (m_fFloatingPoint)
+    {
+        AppendFixed64(m_Block, DoubleBits(nFloatCount));
+        m_nFloatTotal += nFloatCount;
+    }
+    else
+    {
+        // zigzag encoding keeps small negative counts small
+        AppendVarint(m_Block, (static_cast<uint64_t>(nCount) << 1) ^
+                              static_cast<uint64_t>(nCount >> 63));
+        m_nTotal += nCount;
+    }
+    m_sLastValue.assign(Value.data(), Value.size());
+    m_nBlockRecords += 1;
+    m_nDistinct     += 1;
+    if (m_Block.size() >= BINCOUNT_BLOCK_SIZE)
+        FlushBlock();
+}
+
+void
+BinaryCountWriter::FlushBlock ()
+{
+    if (m_nBlockRecords == 0)
+        return;
+    string sBlockHeader;
+    AppendVarint(sBlockHeader, m_nBlockRecords);
+    AppendVarint(sBlockHeader, m_Block.size());
+    Emit(sBlockHeader.data(), sBlockHeader.size());
+    Emit(m_Block.data(), m_Block.size());
+    AppendVarint(m_Index, m_nBlockRecords);
+    m_Block.clear();
+    m_nBlockRecords  = 0;
+    m_nBlocks       += 1;
+}
+
+bool
+BinaryCountWriter::Finish ()
+{
+    FlushBlock();
+    string sTail;
+    AppendVarint(sTail, 0);
+    Emit(sTail.data(), sTail.size());
+
+    uint64_t nIndexOffset = m_nOffset;
+    Emit(m_Index.data(), m_Index.size());
+
+    string sFooter;
+    AppendFixed64(sFooter, nIndexOffset);
+    AppendFixed64(sFooter, m_nBlocks);
+    AppendFixed64(sFooter, m_nDistinct);
+    AppendFixed64(sFooter, m_fFloatingPoint ? DoubleBits(m_nFloatTotal) :
+                                              static_cast<uint64_t>(m_nTotal));
+    AppendFixed64(sFooter, m_fSorted ? BINCOUNT_FOOTER_SORTED : 0);
+    Emit(sFooter.data(), sFooter.size());
+    return m_Output.Flush();
+}
+
+BinaryCountReader::BinaryCountReader ( ByteSource &input )
+    : m_Input(input), m_fFloatingPoint(false), m_fDone(false),
+      m_fFailed(false), m_nPos(0), m_nBlockRecords(0)
+{
+}
+
+bool
+BinaryCountReader::ReadHeader ()
+{
+    char Header[BINCOUNT_HEADER_SIZE];
+    if (m_Input.Read(Header, sizeof(Header)) != sizeof(Header) || memcmp(Header, BINCOUNT_MAGIC, 4) != 0 ||
+        Header[4] != BINCOUNT_VERSION)
+    {
+        m_fFailed = true;
+        return false;
+    }
+    m_fFloatingPoint = (Header[5] & BINCOUNT_HEADER_FLOAT) != 0;
+    return true;
+}
+
+bool
+BinaryCountReader::ReadVarint ( uint64_t &nValue )
+{
+    nValue = 0;
+    for ( int nShift = 0; nShift < 64; nShift += 7 )
+    {
+        char c;
+        if (m_Input.Read(&c, 1) != 1)
+            return false;
+        nValue |= static_cast<uint64_t>(c & 0x7F) << nShift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool
+BinaryCountReader::ReadBlock ()
+{
+    uint64_t nRecords;
+    uint64_t nBytes;
+    if (!ReadVarint(nRecords))
+    {
+        m_fFailed = true;
+        return false;
+    }
+    if (nRecords == 0)
+    {
+        m_fDone = true;
+        return false;
+    }
+    if (!ReadVarint(nBytes))
+    {
+        m_fFailed = true;
+        return false;
+    }
+    // a block cannot hold more records than bytes; and it is grown as
+    // its bytes arrive, so that a corrupt size fails at the end of the
+    // input instead of being allocated
+    if (nRecords > nBytes)
+    {
+        m_fFailed = true;
+        return false;
+    }
+    m_Block.clear();
+    while (m_Block.size() < nBytes)
+    {
+        size_t nOld  = m_Block.size();
+        size_t nRead = min<uint64_t>(nBytes - nOld,
+                                     max(nOld, BINCOUNT_BLOCK_SIZE));
+        m_Block.resize(nOld + nRead);
+        if (m_Input.Read(&m_Block[nOld], nRead) != nRead)
+        {
+            m_fFailed = true;
+            return false;
+        }
+    }
+    m_nPos          = 0;
+    m_nBlockRecords = nRecords;
+    return true;
+}
+
+bool
+BinaryCountReader::Next ( string_view &Value,
+                          long long   &nCount,
+                          double      &nFloatCount )
+{
+    if (m_fDone || m_fFailed)
+        return false;
+    if (m_nBlockRecords == 0 && !ReadBlock())
+        return false;
+
+    uint64_t nShared;
+    uint64_t nSuffix;
+    if (!ParseVarint(m_Block, m_nPos, nShared) ||
+        !ParseVarint(m_Block, m_nPos, nSuffix) ||
+        nShared > m_sValue.size() || nSuffix > m_Block.size() - m_nPos)
+    {
+        m_fFailed = true;
+        return false;
+    }
+    m_sValue.resize(nShared);
+    m_sValue.append(m_Block, m_nPos, nSuffix);
+    m_nPos += nSuffix;
+    if (m_fFloatingPoint)
+    {
+        if (m_Block.size() - m_nPos < 8)
+        {
+            m_fFailed = true;
+            return false;
+        }
+        nFloatCount  = BitsDouble(ParseFixed64(m_Block.data() + m_nPos));
+        m_nPos      += 8;
+    }
+    else
+    {
+        uint64_t nZigzag;
+        if (!ParseVarint(m_Block, m_nPos, nZigzag))
+        {
+            m_fFailed = true;
+            return false;
+        }
+        nCount = static_cast<long long>((nZigzag >> 1) ^ -(nZigzag & 1));
+    }
+    m_nBlockRecords -= 1;
+    Value = m_sValue;
+    return true;
+}
+
+bool
+ReadBinaryCountSummary ( const string       &sFileName,
+                         BinaryCountSummary &Summary )
+{
+    ifstream input(sFileName.c_str(), ios::binary);
+    char     Header[BINCOUNT_HEADER_SIZE];
+    char     Footer[BINCOUNT_FOOTER_SIZE];
+    input.read(Header, sizeof(Header));
+    if (!input || memcmp(Header, BINCOUNT_MAGIC, 4) != 0 ||
+        Header[4] != BINCOUNT_VERSION)
+        return false;
+    input.seekg(-static_cast<streamoff>(BINCOUNT_FOOTER_SIZE), ios::end);
+    input.read(Footer, sizeof(Footer));
+    if (!input)
+        return false;
+    Summary.fFloatingPoint = (Header[5] & BINCOUNT_HEADER_FLOAT) != 0;
+    Summary.nBlocks        = ParseFixed64(Footer + 8);
+    Summary.nDistinct      = ParseFixed64(Footer + 16);
+    uint64_t nTotal        = ParseFixed64(Footer + 24);
+    Summary.nTotal         = static_cast<long long>(nTotal);
+    Summary.nFloatTotal    = BitsDouble(nTotal);
+    Summary.fSorted        = (ParseFixed64(Footer + 32) &
+                              BINCOUNT_FOOTER_SORTED) != 0;
+    return true;
+}
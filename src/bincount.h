@@ -0,0 +1,197 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          bincount
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Compact binary count-file format
+ *
+ * Description:
+ *    A binary count file holds the same records as a text count file
+ *    (a count and a value), without any text to parse.  All integers
+ *    are little-endian; "varint" means an unsigned LEB128 number.
+ *
+ *      header   4 bytes magic "\x89CNT", 1 byte version (1), 1 byte
+ *               flags (bit 0: floating-point counts), 2 bytes zero
+ *
+ *      blocks   each block is a varint record count (never zero), a
+ *               varint byte length, and that many bytes of records.
+ *               Each record is a varint number of leading bytes shared
+ *               with the previous value (zero for the first record in
+ *               a block), a varint suffix length, the suffix bytes, and
+ *               the count: a zigzag varint, or for floating-point files
+ *               an 8-byte IEEE double.  The blocks end with a varint
+ *               zero.
+ *
+ *      index    one entry per block: a varint length and the bytes of
+ *               the block's first value, the varint file offset of the
+ *               block, and its varint record count
+ *
+ *      footer   40 bytes: the index offset, the number of blocks, the
+ *               number of distinct values, the total of the counts
+ *               (an integer or a double) and a flags word (bit 0: the
+ *               values are in strictly increasing alphabetical order),
+ *               each 8 bytes
+ *
+ *    The totals live in a fixed-size footer rather than in the header
+ *    so that files can be written in one pass to a pipe; readers that
+ *    want them seek to the end of the file.  Binary files are detected
+ *    (by CountReader) by their first byte, which can never begin a
+ *    text count line.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Write through OutputFile.
+ *
+ * \file bincount.h
+ */
+
+#ifndef BINCOUNT_H
+#define BINCOUNT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "outputfile.h"
+
+const char   BINCOUNT_MAGIC[4]      = { '\x89', 'C', 'N', 'T' };
+const int    BINCOUNT_VERSION       = 1;
+const size_t BINCOUNT_HEADER_SIZE   = 8;
+const size_t BINCOUNT_FOOTER_SIZE   = 40;
+const int    BINCOUNT_HEADER_FLOAT  = 1;
+const int    BINCOUNT_FOOTER_SORTED = 1;
+
+/**
+ * The summary stored in the footer of a binary count file.
+ */
+struct BinaryCountSummary
+{
+    bool      fFloatingPoint;
+    bool      fSorted;
+    uint64_t  nBlocks;
+    uint64_t  nDistinct;
+    long long nTotal;
+    double    nFloatTotal;
+};
+
+/**
+ * A source of raw bytes for BinaryCountReader.
+ */
+class ByteSource
+{
+public:
+    virtual ~ByteSource () {}
+
+    /**
+     * Reads up to nLength bytes into pData, returning the number read;
+     * fewer than nLength only at the end of the input.
+     */
+    virtual size_t Read ( char   *pData,
+                          size_t  nLength ) = 0;
+};
+
+/**
+ * Writes a binary count file to an OutputFile.
+ */
+class BinaryCountWriter
+{
+public:
+    BinaryCountWriter ( OutputFile &output,
+                        bool        fFloatingPoint );
+
+    /**
+     * Appends a record; only the count matching the file's type is
+     * used.
+     */
+    void Write ( std::string_view Value,
+                 long long        nCount,
+                 double           nFloatCount );
+
+    /**
+     * Writes the final block, the index and the footer, and flushes the
+     * output.  Returns false if writing failed.
+     */
+    bool Finish ();
+
+private:
+    void FlushBlock ();
+    void Emit ( const char *pData,
+                size_t      nLength );
+
+    OutputFile   &m_Output;
+    bool          m_fFloatingPoint;
+    bool          m_fSorted;
+    uint64_t      m_nOffset;
+    std::string   m_Block;
+    size_t        m_nBlockRecords;
+    std::string   m_sLastValue;
+    std::string   m_Index;
+    uint64_t      m_nBlocks;
+    uint64_t      m_nDistinct;
+    long long     m_nTotal;
+    double        m_nFloatTotal;
+};
+
+/**
+ * Reads the records of a binary count file, in order.
+ */
+class BinaryCountReader
+{
+public:
+    explicit BinaryCountReader ( ByteSource &input );
+
+    /**
+     * Reads and checks the header.  Returns false if the stream is not
+     * a binary count file of a supported version.
+     */
+    bool ReadHeader ();
+
+    bool
+    FloatingPoint () const
+    {
+        return m_fFloatingPoint;
+    }
+
+    /**
+     * Reads the next record; Value stays valid until the next call.
+     * Returns false at the end of the records, or if the file is
+     * corrupt, in which case Failed() returns true.
+     */
+    bool Next ( std::string_view &Value,
+                long long        &nCount,
+                double           &nFloatCount );
+
+    bool
+    Failed () const
+    {
+        return m_fFailed;
+    }
+
+private:
+    bool ReadBlock ();
+    bool ReadVarint ( uint64_t &nValue );
+
+    ByteSource   &m_Input;
+    bool          m_fFloatingPoint;
+    bool          m_fDone;
+    bool          m_fFailed;
+    std::string   m_Block;
+    size_t        m_nPos;
+    uint64_t      m_nBlockRecords;
+    std::string   m_sValue;
+};
+
+/**
+ * Reads the footer of the named binary count file.  Returns false if
+ * the file cannot be read or is not a binary count file.
+ */
+bool ReadBinaryCountSummary ( const std::string  &sFileName,
+                              BinaryCountSummary &Summary );
+
+#endif // BINCOUNT_H
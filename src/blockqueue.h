@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          blockqueue
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Bounded producer/consumer queue
+ *
+ * Description:
+ *    BlockQueue hands work items (typically large input blocks) from
+ *    one producer thread to any number of consumer threads.  Push()
+ *    blocks while the queue is full, which keeps a fast reader from
+ *    buffering the whole input ahead of slower workers; Pop() blocks
+ *    until an item is available or the producer has called Close().
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file blockqueue.h
+ */
+
+#ifndef BLOCKQUEUE_H
+#define BLOCKQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+template<typename T>
+class BlockQueue
+{
+public:
+    explicit BlockQueue ( size_t nCapacity )
+        : m_nCapacity(nCapacity), m_fClosed(false)
+    {
+    }
+
+    void
+    Push ( T &&item )
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_NotFull.wait(lock, [this] { return m_Items.size() < m_nCapacity; });
+        m_Items.push_back(std::move(item));
+        m_NotEmpty.notify_one();
+    }
+
+    /**
+     * Takes the next item off the queue.  Returns false once the queue
+     * is closed and empty.
+     */
+    bool
+    Pop ( T &item )
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_NotEmpty.wait(lock, [this] { return !m_Items.empty() || m_fClosed; });
+        if (m_Items.empty())
+            return false;
+        item = std::move(m_Items.front());
+        m_Items.pop_front();
+        m_NotFull.notify_one();
+        return true;
+    }
+
+    /**
+     * Signals that no more items will be pushed.
+     */
+    void
+    Close ()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_fClosed = true;
+        m_NotEmpty.notify_all();
+    }
+
+private:
+    std::mutex              m_Mutex;
+    std::condition_variable m_NotEmpty;
+    std::condition_variable m_NotFull;
+    std::deque<T>           m_Items;
+    size_t                  m_nCapacity;
+    bool                    m_fClosed;
+};
+
+#endif // BLOCKQUEUE_H
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          blockreader
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Reads an input stream in newline-aligned blocks
+ *
+ * Description:
+ *    Implementation of BlockReader.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Read through InputFile.
+ *
+ * \file blockreader.cpp
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <unistd.h>
+#include "blockreader.h"
+using namespace std;
+
+BlockReader::BlockReader ( InputFile &input,
+                           size_t     nBlockSize )
+    : m_Input(input), m_nBlockSize(nBlockSize), m_fDone(false), m_nError(0)
+{
+}
+
+bool
+BlockReader::ReadBlock ( vector<char> &Block,
+                         bool         &fFinal )
+{
+    fFinal = false;
+    if (m_fDone)
+        return false;
+
+    // the carried-over partial line contains no newline, so only the
+    // newly read bytes need to be searched
+    Block.swap(m_Carry);
+    m_Carry.clear();
+    size_t nSearchFrom = Block.size();
+    while (true)
+    {
+        size_t nOldSize = Block.size();
+        Block.resize(nOldSize + m_nBlockSize);
+        ssize_t nRead = m_Input.Read(Block.data() + nOldSize, m_nBlockSize);
+        if (nRead < 0)
+        {
+            Block.resize(nOldSize);
+            if (errno == EINTR)
+                continue;
+            m_nError = errno;
+            m_fDone  = true;
+            return false;
+        }
+        Block.resize(nOldSize + nRead);
+        if (nRead == 0)
+        {
+            fFinal  = true;
+            m_fDone = true;
+            return true;
+        }
+        if (Block.size() < m_nBlockSize)
+            continue;
+
+        size_t nEnd = Block.size();
+        while (nEnd > nSearchFrom && Block[nEnd - 1] != '\n')
+            nEnd--;
+        if (nEnd > nSearchFrom)
+        {
+            m_Carry.assign(Block.begin() + nEnd, Block.end());
+            Block.resize(nEnd);
+            return true;
+        }
+        // a single line longer than the block size; keep reading
+        nSearchFrom = Block.size();
+    }
+}
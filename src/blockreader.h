@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          blockreader
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Reads an input stream in newline-aligned blocks
+ *
+ * Description:
+ *    BlockReader reads an unmapped input with large read() calls and
+ *    hands out blocks that always end just after a newline character,
+ *    so that each block can be split into lines independently of its
+ *    neighbours (for instance, by different worker threads).  Only the
+ *    final block of the stream may end in an unterminated line.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Read through InputFile, so that compressed inputs are
+ *            decompressed.
+ *
+ * \file blockreader.h
+ */
+
+#ifndef BLOCKREADER_H
+#define BLOCKREADER_H
+
+#include <cstddef>
+#include <vector>
+#include "inputfile.h"
+
+class BlockReader
+{
+public:
+    explicit BlockReader ( InputFile &input,
+                           size_t     nBlockSize = 4 << 20 );
+
+    /**
+     * Fills Block with the next run of complete lines.  When the end of
+     * the input is reached, the remaining bytes are returned with
+     * fFinal set; this last block may be empty, and may end without a
+     * newline.  Returns false after the final block has been returned,
+     * or if reading failed (in which case Error() is non-zero).
+     */
+    bool ReadBlock ( std::vector<char> &Block,
+                     bool              &fFinal );
+
+    /**
+     * The errno value of the failed read, or zero.
+     */
+    int
+    Error () const
+    {
+        return m_nError;
+    }
+
+private:
+    InputFile        &m_Input;
+    size_t            m_nBlockSize;
+    std::vector<char> m_Carry;
+    bool              m_fDone;
+    int               m_nError;
+};
+
+#endif // BLOCKREADER_H
@@ -0,0 +1,722 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          compression
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Decompresses input and compresses output on a thread
+ *
+ * Description:
+ *    Implementation of StreamCodec, with zlib, liblzma and libzstd.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file compression.cpp
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <iostream>
+#include <vector>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBLZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+#include "compression.h"
+using namespace std;
+
+/**
+ * The size of the buffers on either side of a (de)compressor, and of
+ * the pipe between it and the tool.
+ */
+const size_t CODEC_BUFFER_SIZE = 1 << 18;
+const int    CODEC_PIPE_SIZE   = 1 << 20;
+
+static const unsigned char GZIP_MAGIC[] = { 0x1f, 0x8b };
+static const unsigned char XZ_MAGIC[]   = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+static const unsigned char ZSTD_MAGIC[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+/**
+ * Compares the nSize bytes at pData with the start of a magic number,
+ * over the length of the shorter of the two.
+ */
+static bool
+MatchesMagic ( const char          *pData,
+               size_t               nSize,
+               const unsigned char *pMagic,
+               size_t               nMagicSize )
+{
+    return memcmp(pData, pMagic, min(nSize, nMagicSize)) == 0;
+}
+
+Compression
+DetectCompression ( const char *pData,
+                    size_t      nSize )
+{
+    if (nSize >= sizeof(GZIP_MAGIC) &&
+        MatchesMagic(pData, nSize, GZIP_MAGIC, sizeof(GZIP_MAGIC)))
+        return COMPRESSION_GZIP;
+    if (nSize >= sizeof(XZ_MAGIC) &&
+        MatchesMagic(pData, nSize, XZ_MAGIC, sizeof(XZ_MAGIC)))
+        return COMPRESSION_XZ;
+    if (nSize >= sizeof(ZSTD_MAGIC) &&
+        MatchesMagic(pData, nSize, ZSTD_MAGIC, sizeof(ZSTD_MAGIC)))
+        return COMPRESSION_ZSTD;
+    return COMPRESSION_NONE;
+}
+
+bool
+IsCompressionMagicPrefix ( const char *pData,
+                           size_t      nSize )
+{
+    return (nSize < sizeof(GZIP_MAGIC) &&
+            MatchesMagic(pData, nSize, GZIP_MAGIC, sizeof(GZIP_MAGIC))) ||
+           (nSize < sizeof(XZ_MAGIC) &&
+            MatchesMagic(pData, nSize, XZ_MAGIC, sizeof(XZ_MAGIC))) ||
+           (nSize < sizeof(ZSTD_MAGIC) &&
+            MatchesMagic(pData, nSize, ZSTD_MAGIC, sizeof(ZSTD_MAGIC)));
+}
+
+const char *
+CompressionName ( Compression format )
+{
+    switch (format)
+    {
+    case COMPRESSION_GZIP:
+        return "gzip";
+    case COMPRESSION_XZ:
+        return "xz";
+    case COMPRESSION_ZSTD:
+        return "zstd";
+    default:
+        return "uncompressed";
+    }
+}
+
+/**
+ * Returns true if this build can read and write format.
+ */
+static bool
+IsSupported ( Compression format )
+{
+    switch (format)
+    {
+#ifdef HAVE_LIBZ
+    case COMPRESSION_GZIP:
+        return true;
+#endif
+#ifdef HAVE_LIBLZMA
+    case COMPRESSION_XZ:
+        return true;
+#endif
+#ifdef HAVE_LIBZSTD
+    case COMPRESSION_ZSTD:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool
+ParseCompression ( const string &sName,
+                   Compression  &format )
+{
+    if (sName == "gzip" || sName == "gz")
+        format = COMPRESSION_GZIP;
+    else if (sName == "xz")
+        format = COMPRESSION_XZ;
+    else if (sName == "zstd" || sName == "zst")
+        format = COMPRESSION_ZSTD;
+    else
+    {
+        cerr << "ERROR: Unknown compression format " << sName << endl;
+        return false;
+    }
+    if (!IsSupported(format))
+    {
+        cerr << "ERROR: This build has no " << CompressionName(format)
+             << " support" << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * The two ends of a (de)compressor: reads its input (sPrefix first,
+ * then nInputFd) and writes its output to nOutputFd.
+ */
+class CodecIo
+{
+public:
+    CodecIo ( int           nInputFd,
+              const string &sPrefix,
+              int           nOutputFd )
+        : m_nInputFd(nInputFd), m_sPrefix(sPrefix), m_nPrefixUsed(0),
+          m_nOutputFd(nOutputFd)
+    {
+    }
+
+    ssize_t
+    Read ( char   *pBuffer,
+           size_t  nSize )
+    {
+        if (m_nPrefixUsed < m_sPrefix.size())
+        {
+            size_t nCopy = min(nSize, m_sPrefix.size() - m_nPrefixUsed);
+            memcpy(pBuffer, m_sPrefix.data() + m_nPrefixUsed, nCopy);
+            m_nPrefixUsed += nCopy;
+            return nCopy;
+        }
+        ssize_t nRead;
+        do
+        {
+            nRead = read(m_nInputFd, pBuffer, nSize);
+        } while (nRead < 0 && errno == EINTR);
+        return nRead;
+    }
+
+    bool
+    Write ( const char *pData,
+            size_t      nLength )
+    {
+        while (nLength > 0)
+        {
+            ssize_t nWritten = write(m_nOutputFd, pData, nLength);
+            if (nWritten < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            pData   += nWritten;
+            nLength -= nWritten;
+        }
+        return true;
+    }
+
+private:
+    int    m_nInputFd;
+    string m_sPrefix;
+    size_t m_nPrefixUsed;
+    int    m_nOutputFd;
+};
+
+/**
+ * The result of running a (de)compressor: finished, stopped because
+ * its output could not be written, or failed on its input.
+ */
+enum CodecResult
+{
+    CODEC_DONE,
+    CODEC_WRITE_FAILED,
+    CODEC_FAILED
+};
+
+#ifdef HAVE_LIBZ
+static CodecResult
+Gunzip ( CodecIo &io,
+         string  &sError )
+{
+    z_stream Stream;
+    memset(&Stream, 0, sizeof(Stream));
+    // 16 + MAX_WBITS: gzip format only
+    if (inflateInit2(&Stream, 16 + MAX_WBITS) != Z_OK)
+    {
+        sError = "could not start gzip decompression";
+        return CODEC_FAILED;
+    }
+    vector<char> In(CODEC_BUFFER_SIZE);
+    vector<char> Out(CODEC_BUFFER_SIZE);
+    bool         fEof        = false;
+    bool         fOutputFull = false;
+    bool         fInStream   = false;
+    CodecResult  result      = CODEC_DONE;
+    while (true)
+    {
+        if (Stream.avail_in == 0 && !fEof && !fOutputFull)
+        {
+            ssize_t nRead = io.Read(In.data(), In.size());
+            if (nRead < 0)
+            {
+                sError = "could not read input";
+                result = CODEC_FAILED;
+                break;
+            }
+            fEof            = nRead == 0;
+            Stream.next_in  = reinterpret_cast<Bytef *>(In.data());
+            Stream.avail_in = nRead;
+        }
+        if (Stream.avail_in == 0 && fEof && !fOutputFull)
+            break;
+        if (Stream.avail_in > 0)
+            fInStream = true;
+        Stream.next_out  = reinterpret_cast<Bytef *>(Out.data());
+        Stream.avail_out = Out.size();
+        int nResult = inflate(&Stream, Z_NO_FLUSH);
+        if (nResult != Z_OK && nResult != Z_STREAM_END &&
+            nResult != Z_BUF_ERROR)
+        {
+            sError = "invalid gzip data";
+            result = CODEC_FAILED;
+            break;
+        }
+        size_t nOut = Out.size() - Stream.avail_out;
+        fOutputFull = Stream.avail_out == 0;
+        if (!io.Write(Out.data(), nOut))
+        {
+            result = CODEC_WRITE_FAILED;
+            break;
+        }
+        // a concatenation of gzip files is a gzip file too
+        if (nResult == Z_STREAM_END)
+        {
+            fInStream = false;
+            inflateReset(&Stream);
+        }
+    }
+    if (result == CODEC_DONE && fInStream)
+    {
+        sError = "unexpected end of gzip data";
+        result = CODEC_FAILED;
+    }
+    inflateEnd(&Stream);
+    return result;
+}
+
+static CodecResult
+Gzip ( CodecIo &io,
+       string  &sError )
+{
+    z_stream Stream;
+    memset(&Stream, 0, sizeof(Stream));
+    if (deflateInit2(&Stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                     16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        sError = "could not start gzip compression";
+        return CODEC_FAILED;
+    }
+    vector<char> In(CODEC_BUFFER_SIZE);
+    vector<char> Out(CODEC_BUFFER_SIZE);
+    bool         fEof   = false;
+    CodecResult  result = CODEC_DONE;
+    while (true)
+    {
+        if (Stream.avail_in == 0 && !fEof)
+        {
+            ssize_t nRead = io.Read(In.data(), In.size());
+            if (nRead < 0)
+            {
+                sError = "could not read output";
+                result = CODEC_FAILED;
+                break;
+            }
+            fEof            = nRead == 0;
+            Stream.next_in  = reinterpret_cast<Bytef *>(In.data());
+            Stream.avail_in = nRead;
+        }
+        Stream.next_out  = reinterpret_cast<Bytef *>(Out.data());
+        Stream.avail_out = Out.size();
+        int nResult = deflate(&Stream, fEof ? Z_FINISH : Z_NO_FLUSH);
+        if (!io.Write(Out.data(), Out.size() - Stream.avail_out))
+        {
+            result = CODEC_WRITE_FAILED;
+            break;
+        }
+        if (nResult == Z_STREAM_END)
+            break;
+    }
+    deflateEnd(&Stream);
+    return result;
+}
+#endif // HAVE_LIBZ
+
+#ifdef HAVE_LIBLZMA
+/**
+ * Runs an xz decoder or encoder over the whole of io.
+ */
+static CodecResult
+RunLzma ( lzma_stream &Stream,
+          CodecIo     &io,
+          string      &sError )
+{
+    vector<char> In(CODEC_BUFFER_SIZE);
+    vector<char> Out(CODEC_BUFFER_SIZE);
+    bool         fEof        = false;
+    bool         fOutputFull = false;
+    CodecResult  result      = CODEC_DONE;
+    while (true)
+    {
+        if (Stream.avail_in == 0 && !fEof && !fOutputFull)
+        {
+            ssize_t nRead = io.Read(In.data(), In.size());
+            if (nRead < 0)
+            {
+                sError = "could not read input";
+                result = CODEC_FAILED;
+                break;
+            }
+            fEof            = nRead == 0;
+            Stream.next_in  = reinterpret_cast<uint8_t *>(In.data());
+            Stream.avail_in = nRead;
+        }
+        Stream.next_out  = reinterpret_cast<uint8_t *>(Out.data());
+        Stream.avail_out = Out.size();
+        lzma_ret nResult = lzma_code(&Stream, fEof ? LZMA_FINISH : LZMA_RUN);
+        fOutputFull = Stream.avail_out == 0;
+        if (!io.Write(Out.data(), Out.size() - Stream.avail_out))
+        {
+            result = CODEC_WRITE_FAILED;
+            break;
+        }
+        if (nResult == LZMA_STREAM_END)
+            break;
+        if (nResult == LZMA_BUF_ERROR)
+        {
+            sError = "unexpected end of xz data";
+            result = CODEC_FAILED;
+            break;
+        }
+        if (nResult != LZMA_OK)
+        {
+            sError = "invalid xz data";
+            result = CODEC_FAILED;
+            break;
+        }
+    }
+    lzma_end(&Stream);
+    return result;
+}
+
+static CodecResult
+Unxz ( CodecIo &io,
+       string  &sError )
+{
+    lzma_stream Stream = LZMA_STREAM_INIT;
+    if (lzma_stream_decoder(&Stream, UINT64_MAX, LZMA_CONCATENATED) !=
+        LZMA_OK)
+    {
+        sError = "could not start xz decompression";
+        return CODEC_FAILED;
+    }
+    return RunLzma(Stream, io, sError);
+}
+
+static CodecResult
+Xz ( CodecIo &io,
+     string  &sError )
+{
+    lzma_stream Stream = LZMA_STREAM_INIT;
+    if (lzma_easy_encoder(&Stream, LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC64) !=
+        LZMA_OK)
+    {
+        sError = "could not start xz compression";
+        return CODEC_FAILED;
+    }
+    return RunLzma(Stream, io, sError);
+}
+#endif // HAVE_LIBLZMA
+
+#ifdef HAVE_LIBZSTD
+static CodecResult
+Unzstd ( CodecIo &io,
+         string  &sError )
+{
+    ZSTD_DStream *pStream = ZSTD_createDStream();
+    if (!pStream)
+    {
+        sError = "could not start zstd decompression";
+        return CODEC_FAILED;
+    }
+    vector<char>   In(CODEC_BUFFER_SIZE);
+    vector<char>   Out(CODEC_BUFFER_SIZE);
+    ZSTD_inBuffer  Input       = { In.data(), 0, 0 };
+    bool           fEof        = false;
+    bool           fOutputFull = false;
+    bool           fInFrame    = false;
+    CodecResult    result      = CODEC_DONE;
+    while (true)
+    {
+        if (Input.pos == Input.size && !fEof && !fOutputFull)
+        {
+            ssize_t nRead = io.Read(In.data(), In.size());
+            if (nRead < 0)
+            {
+                sError = "could not read input";
+                result = CODEC_FAILED;
+                break;
+            }
+            fEof       = nRead == 0;
+            Input.size = nRead;
+            Input.pos  = 0;
+        }
+        if (Input.pos == Input.size && fEof && !fOutputFull)
+            break;
+        ZSTD_outBuffer Output = { Out.data(), Out.size(), 0 };
+        size_t nResult = ZSTD_decompressStream(pStream, &Output, &Input);
+        if (ZSTD_isError(nResult))
+        {
+            sError = string("invalid zstd data: ") +
+                     ZSTD_getErrorName(nResult);
+            result = CODEC_FAILED;
+            break;
+        }
+        // a result of zero means that a frame has just been completed
+        fInFrame    = nResult != 0;
+        fOutputFull = Output.pos == Output.size;
+        if (!io.Write(Out.data(), Output.pos))
+        {
+            result = CODEC_WRITE_FAILED;
+            break;
+        }
+    }
+    if (result == CODEC_DONE && fInFrame)
+    {
+        sError = "unexpected end of zstd data";
+        result = CODEC_FAILED;
+    }
+    ZSTD_freeDStream(pStream);
+    return result;
+}
+
+static CodecResult
+Zstd ( CodecIo &io,
+       string  &sError )
+{
+    ZSTD_CCtx *pContext = ZSTD_createCCtx();
+    if (!pContext)
+    {
+        sError = "could not start zstd compression";
+        return CODEC_FAILED;
+    }
+    vector<char>   In(CODEC_BUFFER_SIZE);
+    vector<char>   Out(CODEC_BUFFER_SIZE);
+    ZSTD_inBuffer  Input  = { In.data(), 0, 0 };
+    bool           fEof   = false;
+    CodecResult    result = CODEC_DONE;
+    while (true)
+    {
+        if (Input.pos == Input.size && !fEof)
+        {
+            ssize_t nRead = io.Read(In.data(), In.size());
+            if (nRead < 0)
+            {
+                sError = "could not read output";
+                result = CODEC_FAILED;
+                break;
+            }
+            fEof       = nRead == 0;
+            Input.size = nRead;
+            Input.pos  = 0;
+        }
+        ZSTD_outBuffer Output = { Out.data(), Out.size(), 0 };
+        size_t nRemaining = ZSTD_compressStream2(
+            pContext, &Output, &Input, fEof ? ZSTD_e_end : ZSTD_e_continue);
+        if (ZSTD_isError(nRemaining))
+        {
+            sError = ZSTD_getErrorName(nRemaining);
+            result = CODEC_FAILED;
+            break;
+        }
+        if (!io.Write(Out.data(), Output.pos))
+        {
+            result = CODEC_WRITE_FAILED;
+            break;
+        }
+        if (fEof && nRemaining == 0)
+            break;
+    }
+    ZSTD_freeCCtx(pContext);
+    return result;
+}
+#endif // HAVE_LIBZSTD
+
+/**
+ * Creates the pipe between a (de)compressor and the tool.
+ */
+static bool
+MakeCodecPipe ( int Fds[2] )
+{
+    if (pipe2(Fds, O_CLOEXEC) != 0)
+        return false;
+#ifdef F_SETPIPE_SZ
+    // a larger pipe holds more blocks, so that the two sides wait on
+    // each other less; failing to grow it is harmless
+    fcntl(Fds[1], F_SETPIPE_SZ, CODEC_PIPE_SIZE);
+#endif
+    return true;
+}
+
+/**
+ * Blocks SIGPIPE on the calling thread, so that writing to a pipe whose
+ * reader has gone away fails with EPIPE rather than ending the process.
+ */
+static void
+BlockSigPipe ()
+{
+    sigset_t Signals;
+    sigemptyset(&Signals);
+    sigaddset(&Signals, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &Signals, 0);
+}
+
+StreamCodec::StreamCodec ()
+    : m_Format(COMPRESSION_NONE), m_nSourceFd(-1), m_nTargetFd(-1)
+{
+}
+
+StreamCodec::~StreamCodec ()
+{
+    if (m_Thread.joinable())
+        m_Thread.join();
+}
+
+bool
+StreamCodec::StartDecompressing ( Compression   format,
+                                  int           nInputFd,
+                                  const string &sPrefix,
+                                  const string &sName,
+                                  int          &nReadFd )
+{
+    if (!IsSupported(format))
+    {
+        cerr << "ERROR: " << sName << " is " << CompressionName(format)
+             << "-compressed, but this build has no "
+             << CompressionName(format) << " support" << endl;
+        return false;
+    }
+    int Fds[2];
+    if (!MakeCodecPipe(Fds))
+    {
+        cerr << "ERROR: Could not create a pipe to decompress " << sName
+             << endl;
+        return false;
+    }
+    m_Format    = format;
+    m_nSourceFd = nInputFd;
+    m_nTargetFd = Fds[1];
+    m_sPrefix   = sPrefix;
+    m_sName     = sName;
+    m_Thread    = thread(&StreamCodec::Decompress, this);
+    nReadFd     = Fds[0];
+    return true;
+}
+
+bool
+StreamCodec::StartCompressing ( Compression   format,
+                                int           nOutputFd,
+                                const string &sName,
+                                int          &nWriteFd )
+{
+    int Fds[2];
+    if (!MakeCodecPipe(Fds))
+    {
+        cerr << "ERROR: Could not create a pipe to compress " << sName
+             << endl;
+        return false;
+    }
+    m_Format    = format;
+    m_nSourceFd = Fds[0];
+    m_nTargetFd = nOutputFd;
+    m_sName     = sName;
+    m_Thread    = thread(&StreamCodec::Compress, this);
+    nWriteFd    = Fds[1];
+    return true;
+}
+
+bool
+StreamCodec::Finish ()
+{
+    if (m_Thread.joinable())
+        m_Thread.join();
+    if (m_sError.empty())
+        return true;
+    cerr << "ERROR: " << m_sName << ": " << m_sError << endl;
+    m_sError.clear();
+    return false;
+}
+
+void
+StreamCodec::Decompress ()
+{
+    BlockSigPipe();
+    CodecIo io(m_nSourceFd, m_sPrefix, m_nTargetFd);
+    switch (m_Format)
+    {
+#ifdef HAVE_LIBZ
+    case COMPRESSION_GZIP:
+        Gunzip(io, m_sError);
+        break;
+#endif
+#ifdef HAVE_LIBLZMA
+    case COMPRESSION_XZ:
+        Unxz(io, m_sError);
+        break;
+#endif
+#ifdef HAVE_LIBZSTD
+    case COMPRESSION_ZSTD:
+        Unzstd(io, m_sError);
+        break;
+#endif
+    default:
+        break;
+    }
+    // the reader sees the end of the input once the pipe is closed; if
+    // it stopped reading early, the output could not be written, which
+    // is not an error
+    m_sPrefix.clear();
+    close(m_nTargetFd);
+}
+
+void
+StreamCodec::Compress ()
+{
+    BlockSigPipe();
+    CodecIo     io(m_nSourceFd, "", m_nTargetFd);
+    CodecResult result = CODEC_DONE;
+    switch (m_Format)
+    {
+#ifdef HAVE_LIBZ
+    case COMPRESSION_GZIP:
+        result = Gzip(io, m_sError);
+        break;
+#endif
+#ifdef HAVE_LIBLZMA
+    case COMPRESSION_XZ:
+        result = Xz(io, m_sError);
+        break;
+#endif
+#ifdef HAVE_LIBZSTD
+    case COMPRESSION_ZSTD:
+        result = Zstd(io, m_sError);
+        break;
+#endif
+    default:
+        break;
+    }
+    if (result == CODEC_WRITE_FAILED)
+    {
+        // keep draining the pipe, so that the tool can finish and
+        // report the error rather than block or die of SIGPIPE
+        m_sError = "could not write output";
+        char Discard[4096];
+        while (io.Read(Discard, sizeof(Discard)) > 0)
+            ;
+    }
+    close(m_nSourceFd);
+}
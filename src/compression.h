@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          compression
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Decompresses input and compresses output on a thread
+ *
+ * Description:
+ *    Compressed inputs are recognised by their magic bytes: gzip, xz
+ *    and zstd are supported, as far as the libraries were found when
+ *    the package was configured.  A StreamCodec runs the (de)compressor
+ *    on a thread of its own, connected to the reading or writing side
+ *    of the tool by a pipe, so that decompression overlaps with parsing
+ *    and counting, and compression with formatting.  The pipe acts as
+ *    a bounded queue of blocks between the two threads, and lets the
+ *    tools read a compressed input through exactly the same code (and
+ *    file descriptor) as a plain one.
+ *
+ *    Concatenated compressed streams (as made by cat file1.gz
+ *    file2.gz) are decompressed as one.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file compression.h
+ */
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <string>
+#include <thread>
+
+enum Compression
+{
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_XZ,
+    COMPRESSION_ZSTD
+};
+
+/**
+ * The number of bytes needed to recognise any compressed format.
+ */
+const size_t COMPRESSION_MAGIC_SIZE = 6;
+
+/**
+ * Returns the format whose magic bytes start pData, or COMPRESSION_NONE.
+ */
+Compression DetectCompression ( const char *pData,
+                                size_t      nSize );
+
+/**
+ * Returns true if the nSize bytes at pData are too few to tell whether
+ * they begin a compressed stream, i.e. they are a proper prefix of the
+ * magic bytes of some format.
+ */
+bool IsCompressionMagicPrefix ( const char *pData,
+                                size_t      nSize );
+
+/**
+ * Sets format from its name ("gzip", "xz" or "zstd").  Returns false,
+ * after printing a message, if the name is unknown or the format is
+ * not supported by this build.
+ */
+bool ParseCompression ( const std::string &sName,
+                        Compression       &format );
+
+/**
+ * The name of format, for messages.
+ */
+const char *CompressionName ( Compression format );
+
+class StreamCodec
+{
+public:
+    StreamCodec ();
+    ~StreamCodec ();
+
+    StreamCodec ( const StreamCodec & ) = delete;
+    StreamCodec &operator= ( const StreamCodec & ) = delete;
+
+    /**
+     * Starts decompressing sPrefix followed by the rest of nInputFd,
+     * which is in the given format, and sets nReadFd to a pipe from
+     * which the decompressed data can be read.  sName names the input
+     * in messages.  Returns false, after printing a message, if the
+     * format is not supported or the thread could not be started.
+     */
+    bool StartDecompressing ( Compression        format,
+                              int                nInputFd,
+                              const std::string &sPrefix,
+                              const std::string &sName,
+                              int               &nReadFd );
+
+    /**
+     * Starts compressing into nOutputFd in the given format, and sets
+     * nWriteFd to a pipe into which the data to compress is written.
+     * The output is complete once nWriteFd is closed and Finish() has
+     * returned.
+     */
+    bool StartCompressing ( Compression        format,
+                            int                nOutputFd,
+                            const std::string &sName,
+                            int               &nWriteFd );
+
+    /**
+     * Waits for the thread to finish.  Returns false, after printing a
+     * message, if (de)compression failed.  When decompressing, the
+     * read end of the pipe must be closed first if it has not been
+     * read to the end.
+     */
+    bool Finish ();
+
+    bool
+    IsRunning () const
+    {
+        return m_Thread.joinable();
+    }
+
+private:
+    void Decompress ();
+    void Compress ();
+
+    Compression m_Format;
+    int         m_nSourceFd;
+    int         m_nTargetFd;
+    std::string m_sPrefix;
+    std::string m_sName;
+    std::string m_sError;
+    std::thread m_Thread;
+};
+
+#endif // COMPRESSION_H
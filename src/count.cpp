@@ -20,16 +20,109 @@
  *    (WKR) 11 November 2008
  *          - Initial version.
  *
+ *    (WKR) 17 October 2026
+ *          - Count into an arena-backed hash table instead of a
+ *            std::map; sort only once, at output time.
+ *          - Read input in large newline-aligned blocks; add -j to
+ *            count blocks on several worker threads.
+ *          - Accept input file arguments; regular files are mapped
+ *            into memory and counted without copying their lines.
+ *          - Add -S to spill sorted runs to disk under a memory
+ *            budget, merging them at the end.
+ *          - Add -k K --approx: fixed-memory approximate top-K using
+ *            the Space-Saving algorithm.
+ *          - Add exact -k K; -f now lists every line, breaking ties
+ *            in count alphabetically, instead of only the first line
+ *            with each count.
+ *          - Add -b to write a binary count file.
+ *          - Write the output through a buffered OutputFile.
+ *          - Add --snapshot PREFIX, with --every, --every-lines, --delta
+ *            and --keep, and on SIGUSR1: periodic snapshots of the
+ *            counts of an unbounded stream, written without pausing
+ *            the counting.
+ *          - Add --update DIR to add the counts to a count store (see
+ *            countstore) instead of writing them out.
+ *          - Add -F, -d, -w, -r and -g to count a field, a range of
+ *            fields or a regular expression match instead of the whole
+ *            line.
+ *          - Read compressed inputs; add -z to compress the output.
+ *          - Add --stats, --stats-json and --progress.
+ *          - -S can be combined with -f and -k: the merged counts are
+ *            sorted by count with CountOrderSorter.
+ *          - Add --trie to count into a TrieCountTable.
+ *          - Add --distinct, --sketch and --precision: estimate the
+ *            number of distinct lines in fixed memory with a
+ *            HyperLogLog sketch, which can be saved and merged.
+ *          - Count sorted input by runs of equal lines, in constant
+ *            memory: always with --sorted, which checks the order, and
+ *            otherwise for as long as the input turns out to be sorted.
+ *
  * \file count.cpp
  */
 
 #include "config.h"
+#include <errno.h>
 #include <getopt.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
-#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "bincount.h"
+#include "blockqueue.h"
+#include "blockreader.h"
+#include "compression.h"
+#include "countorder.h"
+#include "countrun.h"
+#include "counttable.h"
+#include "hyperloglog.h"
+#include "inputfile.h"
+#include "keyselect.h"
+#include "outputfile.h"
+#include "runstore.h"
+#include "snapshot.h"
+#include "spacesaving.h"
+#include "toolstats.h"
+#include "trietable.h"
 using namespace std;
 
+typedef HashCountTable<long long> LineTable;
+typedef TrieCountTable<long long> LineTrie;
+
+/**
+ * The number of values monitored per requested top-K value in --approx
+ * mode, and the minimum number monitored; more counters give tighter
+ * error bounds.
+ */
+const size_t APPROX_COUNTERS_PER_KEY = 4;
+const size_t APPROX_MIN_COUNTERS     = 1024;
+
+/**
+ * The number of runs of equal lines held back before deciding that the
+ * input is sorted, and streaming the runs out instead.
+ */
+const size_t SORTED_PROBE_RUNS = 4096;
+
+/**
+ * The size of the reads of a stream counted with snapshots; a read
+ * returns as soon as any input is available.
+ */
+const size_t SNAPSHOT_READ_SIZE = 1 << 20;
+
+/**
+ * How long to wait before trying again to hand over a snapshot that is
+ * due while the previous one is still being written, in milliseconds.
+ */
+const int SNAPSHOT_RETRY_MS = 10;
+
 void
 printHelp()
 {
@@ -39,31 +132,948 @@ printHelp()
     cout << "output of the program can be sort it in order of descending frequency" << endl;
     cout << "using the -f option or by piping through sort -nr." << endl;
     cout << endl;
+    cout << "If one or more FILE arguments are given, the lines of all of these files" << endl;
+    cout << "are counted together instead; a FILE of \"-\" stands for standard input." << endl;
+    cout << "The last line of each file is treated as the end of the input for the" << endl;
+    cout << "purposes of the -e option." << endl;
+    cout << endl;
+    cout << "With -F or -r, count counts only part of each line (its key) rather than" << endl;
+    cout << "the whole line.  Lines without a key (with too few fields, or not" << endl;
+    cout << "matching) are skipped, unlike in cut, which passes a line without the" << endl;
+    cout << "delimiter through whole and gives an empty field for a missing one." << endl;
+    cout << endl;
     cout << "Syntax:" << endl;
     cout << endl;
-    cout << "   count [OPTIONS]" << endl;
+    cout << "   count [OPTIONS] [FILE...]" << endl;
     cout << endl;
     cout << "Options:" << endl;
     cout << endl;
+    cout << "   -b      write a binary count file (see countconv)" << endl;
     cout << "   -e      always count the last line of the input, even if it is" << endl;
     cout << "           empty" << endl;
-    cout << "   -f      sort output in order of descending frequency" << endl;
+    cout << "   -f      sort output in order of descending frequency; lines with" << endl;
+    cout << "           equal counts are in alphabetical order" << endl;
+    cout << "   -j N    count with N worker threads" << endl;
+    cout << "   -S SIZE use at most about SIZE bytes of memory (e.g. 512M, 4G)" << endl;
+    cout << "           for the tables, spilling sorted runs to disk when they" << endl;
+    cout << "           are full; with -f or -k, the merged counts are sorted" << endl;
+    cout << "           in runs of about SIZE bytes too" << endl;
+    cout << "   -T DIR  write temporary runs under DIR (default $TMPDIR or /tmp)" << endl;
+    cout << "   -k K    output only the K most frequent lines (implies -f)" << endl;
+    cout << "   -F LIST count field N (LIST is N), fields N to M (N-M) or fields N" << endl;
+    cout << "           onwards (N-) of each line, numbering fields from 1; a range" << endl;
+    cout << "           of fields keeps the separators between them" << endl;
+    cout << "   -d CHAR separate fields with CHAR instead of a tab" << endl;
+    cout << "   -w      separate fields with runs of spaces and tabs, ignoring" << endl;
+    cout << "           leading and trailing ones (as awk does)" << endl;
+    cout << "   -r REGEX" << endl;
+    cout << "           count the part of each line matching the POSIX extended" << endl;
+    cout << "           regular expression REGEX: its first parenthesized group," << endl;
+    cout << "           or the whole match if it has no groups" << endl;
+    cout << "   -g N    with -r, count group N of the match instead (0 for the" << endl;
+    cout << "           whole match)" << endl;
+    cout << "   --approx" << endl;
+    cout << "           estimate the K most frequent lines in fixed memory; the" << endl;
+    cout << "           output has three columns: the estimated count, the" << endl;
+    cout << "           largest possible overestimate of that count, and the" << endl;
+    cout << "           line" << endl;
+    cout << "   --snapshot PREFIX" << endl;
+    cout << "           while counting, write snapshots of the counts so far to" << endl;
+    cout << "           the files PREFIX.1, PREFIX.2, ..., as set by the options" << endl;
+    cout << "           below, and whenever count receives the signal SIGUSR1;" << endl;
+    cout << "           the final counts are still written to standard output" << endl;
+    cout << "           at the end of the input.  Cannot be combined with -j," << endl;
+    cout << "           -S or --approx" << endl;
+    cout << "   --every SECONDS" << endl;
+    cout << "           write a snapshot every SECONDS seconds" << endl;
+    cout << "   --every-lines N" << endl;
+    cout << "           write a snapshot after every N lines" << endl;
+    cout << "   --delta write only the counts since the previous snapshot to each" << endl;
+    cout << "           snapshot; addcount sums them back together" << endl;
+    cout << "   --keep N" << endl;
+    cout << "           keep only the N most recent snapshots" << endl;
+    cout << "   --trie  count in a trie that stores prefixes shared by lines only" << endl;
+    cout << "           once, and is written out in order without sorting;" << endl;
+    cout << "           much smaller on lines such as URLs and file paths" << endl;
+    cout << "   --sorted" << endl;
+    cout << "           the input is sorted (in byte order, as by LC_ALL=C sort):" << endl;
+    cout << "           count runs of equal lines, as uniq -c does, in constant" << endl;
+    cout << "           memory, stopping with an error at the first line out of" << endl;
+    cout << "           order; cannot be combined with -j, --approx, --distinct," << endl;
+    cout << "           --snapshot or --trie.  Without these options, count also" << endl;
+    cout << "           counts by runs for as long as its input turns out to be" << endl;
+    cout << "           sorted" << endl;
+    cout << "   --distinct" << endl;
+    cout << "           print only an estimate of the number of distinct lines," << endl;
+    cout << "           made in fixed memory with a HyperLogLog sketch; cannot be" << endl;
+    cout << "           combined with -b, -f, -k, -S, -z, --approx, --snapshot," << endl;
+    cout << "           --trie or --update" << endl;
+    cout << "   --sketch FILE" << endl;
+    cout << "           with --distinct, also write the sketch to FILE, for" << endl;
+    cout << "           addcount --distinct to merge with others" << endl;
+    cout << "   --precision P" << endl;
+    cout << "           with --distinct, use 2^P one-byte registers, for a" << endl;
+    cout << "           relative error of about 1.04 / sqrt(2^P); P is from 4" << endl;
+    cout << "           to 18 (default: 14, or 0.8% in 16K)" << endl;
+    cout << "   --update DIR" << endl;
+    cout << "           add the counts to the count store DIR (see countstore)" << endl;
+    cout << "           instead of writing them to standard output; cannot be" << endl;
+    cout << "           combined with -b, -f, -k, -z or --approx" << endl;
+    cout << "   -z FORMAT" << endl;
+    cout << "           compress the output with FORMAT: gzip, xz or zstd" << endl;
+    cout << "   --stats print statistics of the run to standard error: lines and" << endl;
+    cout << "           bytes read, distinct lines, time in each phase, table" << endl;
+    cout << "           size, heap allocations and peak memory" << endl;
+    cout << "   --stats-json FILE" << endl;
+    cout << "           write the statistics to FILE as a JSON object" << endl;
+    cout << "   --progress SECONDS" << endl;
+    cout << "           print the input read so far to standard error every" << endl;
+    cout << "           SECONDS seconds" << endl;
     cout << "   -?      display this help message and exit" << endl;
 }
 
-template<typename A, typename B>
-pair<B,A> flip_pair(const pair<A,B> &p)
+/**
+ * Settings shared by all of the counting threads.
+ */
+struct CountSettings
 {
-    return pair<B,A>(p.second, p.first);
+    bool         fIncludeLastLine;
+    size_t       nTableBudget;       // bytes per table, or 0 for no limit
+    RunSpiller  *pSpiller;
+    atomic<bool> fFailed;            // set to stop counting, on error
+    const KeySelector *pSelector;
+    ToolStats   *pStats;
+};
+
+/**
+ * Adds a line to LineDict (a LineTable or a LineTrie), spilling the
+ * table to a run if it has grown past its budget.
+ */
+template<typename TTable>
+inline void
+CountLine ( const char    *pLine,
+            size_t         nLength,
+            bool           fCopyKey,
+            CountSettings &Settings,
+            TTable        &LineDict )
+{
+    if (fCopyKey)
+        LineDict.Add(pLine, nLength);
+    else
+        LineDict.AddBorrowed(pLine, nLength);
+    if (Settings.nTableBudget &&
+        LineDict.MemoryUsage() >= Settings.nTableBudget &&
+        !Settings.pSpiller->Spill(LineDict))
+    {
+        Settings.fFailed = true;
+    }
+}
+
+/**
+ * Adds a line to an approximate summary.
+ */
+inline void
+CountLine ( const char    *pLine,
+            size_t         nLength,
+            bool           ,
+            CountSettings &,
+            SpaceSaving   &Summary )
+{
+    Summary.Add(pLine, nLength);
+}
+
+/**
+ * Adds a line to a cardinality sketch.
+ */
+inline void
+CountLine ( const char    *pLine,
+            size_t         nLength,
+            bool           ,
+            CountSettings &,
+            HyperLogLog   &Sketch )
+{
+    Sketch.Add(pLine, nLength);
 }
 
-template<typename A, typename B>
-map<B,A> flip_map(const map<A,B> &src)
+/**
+ * Counts the key of a line, if it has one.
+ */
+template<typename TTable>
+inline void
+CountKey ( const KeySelector &Selector,
+           const char        *pLine,
+           size_t             nLength,
+           bool               fCopyKey,
+           CountSettings     &Settings,
+           TTable            &LineDict )
 {
-    map<B,A> dst;
-    transform(src.begin(), src.end(), inserter(dst, dst.begin()),
-              flip_pair<A,B>);
-    return dst;
+    const char *pKey;
+    size_t      nKeyLength;
+    if (Selector.Select(pLine, nLength, pKey, nKeyLength))
+        CountLine(pKey, nKeyLength, fCopyKey, Settings, LineDict);
+}
+
+/**
+ * The state of counting input that is sorted, or may be: lines are
+ * counted by runs of equal lines, as uniq -c counts them, and each run
+ * is emitted as soon as the next one starts, so memory does not grow
+ * with the number of distinct lines.
+ *
+ * With --sorted (fForced), the runs go to Emit, and input out of order
+ * is an error.  Otherwise the first SORTED_PROBE_RUNS runs are held
+ * back; if the input goes out of order before then, they are added to
+ * LineDict, and the input is counted there as usual.  After that, the
+ * runs are added to LineDict as they end, with one lookup for each run
+ * rather than for each line, or, with -S, streamed to a spilled run
+ * instead; if the input goes out of order later on, the rest of it is
+ * counted in LineDict, and merged with the run at the end.
+ */
+struct SortedState
+{
+    SortedState ()
+        : fForced(false), fUnsorted(false), fHaveRun(false), nRunCount(0),
+          nLines(0), nRuns(0), pLineDict(0)
+    {
+    }
+
+    bool                                   fForced;
+    bool                                   fUnsorted;
+    bool                                   fHaveRun;
+    string                                 sRunKey;
+    long long                              nRunCount;
+    string                                 sInputName;
+    long long                              nLines;    // of this input
+    long long                              nRuns;     // runs emitted
+    vector<pair<string, long long> >       Held;
+    function<bool(long long, string_view)> Emit;
+    string                                 sRunName;
+    OutputFile                             runFile;
+    LineTable                             *pLineDict;
+};
+
+/**
+ * Emits the current run: to Emit if it is set, or else to the runs
+ * held back, sending them on to LineDict or (with -S) to a spilled run
+ * once there are enough of them.  Returns false, after printing a
+ * message, on failure.
+ */
+bool
+EmitRun ( SortedState   &State,
+          CountSettings &Settings )
+{
+    State.nRuns++;
+    if (State.Emit)
+        return State.Emit(State.nRunCount, State.sRunKey);
+    State.Held.emplace_back(State.sRunKey, State.nRunCount);
+    if (State.Held.size() < SORTED_PROBE_RUNS)
+        return true;
+    if (!Settings.nTableBudget)
+    {
+        LineTable &LineDict = *State.pLineDict;
+        for ( size_t i = 0; i < State.Held.size(); i++ )
+        {
+            LineDict.Add(State.Held[i].first.data(),
+                         State.Held[i].first.size(), State.Held[i].second);
+        }
+        vector<pair<string, long long> >().swap(State.Held);
+        State.Emit = [&LineDict](long long   nCount,
+                                 string_view Value)
+        {
+            LineDict.Add(Value.data(), Value.size(), nCount);
+            return true;
+        };
+        return true;
+    }
+    if (!Settings.pSpiller->CreateRun(State.sRunName, State.runFile))
+        return false;
+    OutputFile &runFile = State.runFile;
+    for ( size_t i = 0; i < State.Held.size(); i++ )
+        runFile.WriteRecord(State.Held[i].second, State.Held[i].first);
+    vector<pair<string, long long> >().swap(State.Held);
+    State.Emit = [&runFile](long long   nCount,
+                            string_view Value)
+    {
+        runFile.WriteRecord(nCount, Value);
+        return true;
+    };
+    return true;
+}
+
+/**
+ * Ends the runs: emits the last one and, if they were being streamed
+ * to a spilled run, finishes it.  Runs still held back are added to
+ * LineDict.  Returns false, after printing a message, on failure.
+ */
+bool
+EndSortedRuns ( SortedState   &State,
+                CountSettings &Settings )
+{
+    bool fOk = !State.fHaveRun || EmitRun(State, Settings);
+    State.fHaveRun = false;
+    if (!State.sRunName.empty())
+    {
+        fOk = Settings.pSpiller->FinishRun(State.sRunName, State.runFile) &&
+              fOk;
+        State.sRunName.clear();
+    }
+    for ( size_t i = 0; i < State.Held.size(); i++ )
+    {
+        State.pLineDict->Add(State.Held[i].first.data(),
+                             State.Held[i].first.size(),
+                             State.Held[i].second);
+    }
+    vector<pair<string, long long> >().swap(State.Held);
+    return fOk;
+}
+
+/**
+ * Starts a new run with a line that differs from the current run's.
+ */
+void
+StartRun ( const char    *pLine,
+           size_t         nLength,
+           bool           fCopyKey,
+           CountSettings &Settings,
+           SortedState   &State )
+{
+    if (State.fHaveRun &&
+        CompareKeys(State.sRunKey.data(), State.sRunKey.size(),
+                    pLine, nLength) > 0)
+    {
+        if (State.fForced)
+        {
+            cerr << State.sInputName << ":" << State.nLines
+                 << ": error: file not sorted" << endl;
+            Settings.fFailed = true;
+            return;
+        }
+        State.fUnsorted = true;
+        if (!EndSortedRuns(State, Settings))
+        {
+            Settings.fFailed = true;
+            return;
+        }
+        CountLine(pLine, nLength, fCopyKey, Settings, *State.pLineDict);
+        return;
+    }
+    if (State.fHaveRun && !EmitRun(State, Settings))
+    {
+        Settings.fFailed = true;
+        return;
+    }
+    State.sRunKey.assign(pLine, nLength);
+    State.nRunCount = 1;
+    State.fHaveRun  = true;
+}
+
+/**
+ * Counts a line of input that may be sorted.
+ */
+inline void
+CountLine ( const char    *pLine,
+            size_t         nLength,
+            bool           fCopyKey,
+            CountSettings &Settings,
+            SortedState   &State )
+{
+    if (State.fUnsorted)
+    {
+        CountLine(pLine, nLength, fCopyKey, Settings, *State.pLineDict);
+    }
+    else if (State.fHaveRun && State.sRunKey.size() == nLength &&
+             memcmp(State.sRunKey.data(), pLine, nLength) == 0)
+    {
+        State.nRunCount++;
+    }
+    else
+    {
+        StartRun(pLine, nLength, fCopyKey, Settings, State);
+    }
+}
+
+/**
+ * Counts the key of a line of input that may be sorted, numbering the
+ * lines for messages.
+ */
+inline void
+CountKey ( const KeySelector &Selector,
+           const char        *pLine,
+           size_t             nLength,
+           bool               fCopyKey,
+           CountSettings     &Settings,
+           SortedState       &State )
+{
+    const char *pKey;
+    size_t      nKeyLength;
+    State.nLines++;
+    if (Selector.Select(pLine, nLength, pKey, nKeyLength))
+        CountLine(pKey, nKeyLength, fCopyKey, Settings, State);
+}
+
+/**
+ * Counts the lines in a block of input.  Every newline-terminated line
+ * is counted; the unterminated tail of the final block of the input is
+ * counted if it is non-empty, or if fIncludeLastLine is set.  If
+ * fCopyKeys is false, the table may refer to the lines in place, so the
+ * block must outlive it.
+ */
+template<typename TTable>
+void
+CountBlock ( const char    *pData,
+             size_t         nLength,
+             bool           fFinal,
+             bool           fCopyKeys,
+             CountSettings &Settings,
+             TTable        &LineDict )
+{
+    // a copy, so that threads never share a compiled expression
+    KeySelector Selector(*Settings.pSelector);
+    const char *pEnd      = pData + nLength;
+    const char *pReported = pData;
+    long long   nLines    = 0;
+    while (pData < pEnd && !Settings.fFailed)
+    {
+        const char *pNewline =
+            static_cast<const char *>(memchr(pData, '\n', pEnd - pData));
+        if (!pNewline)
+            break;
+        CountKey(Selector, pData, pNewline - pData, fCopyKeys, Settings,
+                 LineDict);
+        pData = pNewline + 1;
+        if (++nLines == STATS_INPUT_BATCH)
+        {
+            Settings.pStats->AddInput(nLines, pData - pReported);
+            pReported = pData;
+            nLines    = 0;
+        }
+    }
+    if (fFinal && !Settings.fFailed &&
+        (Settings.fIncludeLastLine || pData < pEnd))
+    {
+        CountKey(Selector, pData, pEnd - pData, fCopyKeys, Settings,
+                 LineDict);
+        nLines++;
+    }
+    Settings.pStats->AddInput(nLines, pEnd - pReported);
+}
+
+struct InputBlock
+{
+    vector<char> Data;
+    bool         fFinal;
+};
+
+/**
+ * Reads an unmapped input in blocks and counts them into WorkerDicts.
+ * With more than one table, the blocks are read on the calling thread
+ * and counted on one worker thread per table.  Returns false on a read
+ * error.
+ */
+template<typename TTable>
+bool
+CountFd ( InputFile      &input,
+          CountSettings  &Settings,
+          vector<TTable> &WorkerDicts )
+{
+    BlockReader reader(input);
+    InputBlock  block;
+    if (WorkerDicts.size() == 1)
+    {
+        while (reader.ReadBlock(block.Data, block.fFinal))
+        {
+            CountBlock(block.Data.data(), block.Data.size(), block.fFinal,
+                       true, Settings, WorkerDicts[0]);
+        }
+        return reader.Error() == 0;
+    }
+
+    BlockQueue<InputBlock> Queue(2 * WorkerDicts.size());
+    vector<thread>         Workers;
+    for ( size_t i = 0; i < WorkerDicts.size(); i++ )
+    {
+        Workers.emplace_back([&Queue, &WorkerDicts, &Settings, i]
+        {
+            InputBlock block;
+            while (Queue.Pop(block))
+            {
+                CountBlock(block.Data.data(), block.Data.size(),
+                           block.fFinal, true, Settings, WorkerDicts[i]);
+            }
+        });
+    }
+    while (reader.ReadBlock(block.Data, block.fFinal))
+    {
+        Queue.Push(std::move(block));
+        block = InputBlock();
+    }
+    Queue.Close();
+    for (thread &worker : Workers)
+        worker.join();
+    return reader.Error() == 0;
+}
+
+/**
+ * Counts the lines of a memory-mapped file into WorkerDicts without
+ * copying them.  With more than one table, the mapping is cut into one
+ * newline-aligned range per table, and the ranges are counted in
+ * parallel.
+ */
+template<typename TTable>
+void
+CountMapped ( const char     *pData,
+              size_t          nLength,
+              CountSettings  &Settings,
+              vector<TTable> &WorkerDicts )
+{
+    size_t nThreads = WorkerDicts.size();
+    if (nThreads == 1)
+    {
+        CountBlock(pData, nLength, true, false, Settings, WorkerDicts[0]);
+        return;
+    }
+
+    vector<thread> Workers;
+    size_t         nStart = 0;
+    for ( size_t i = 0; i < nThreads; i++ )
+    {
+        size_t nEnd = nLength;
+        if (i + 1 < nThreads)
+        {
+            nEnd = max(nStart, nLength / nThreads * (i + 1));
+            const char *pNewline = static_cast<const char *>(
+                memchr(pData + nEnd, '\n', nLength - nEnd));
+            nEnd = pNewline ? pNewline + 1 - pData : nLength;
+        }
+        bool fFinal = nEnd == nLength;
+        Workers.emplace_back([=, &Settings, &WorkerDicts]
+        {
+            CountBlock(pData + nStart, nEnd - nStart, fFinal, false,
+                       Settings, WorkerDicts[i]);
+        });
+        if (fFinal)
+            break;
+        nStart = nEnd;
+    }
+    for (thread &worker : Workers)
+        worker.join();
+}
+
+/**
+ * Prepares WorkerDicts to count the input that has just been opened.
+ */
+template<typename TTable>
+inline void
+StartInput ( const InputFile &,
+             vector<TTable>  & )
+{
+}
+
+/**
+ * Numbers the lines of each input from 1, for messages.
+ */
+inline void
+StartInput ( const InputFile     &input,
+             vector<SortedState> &States )
+{
+    States[0].sInputName = input.Name();
+    States[0].nLines     = 0;
+}
+
+/**
+ * Opens and counts each of the named inputs into WorkerDicts.  The
+ * inputs are kept open in Inputs, since the tables may point into their
+ * mappings.  Returns false on error, after printing a message and
+ * removing any spilled runs.
+ */
+template<typename TTable>
+bool
+CountInputs ( const vector<string> &InputNames,
+              vector<InputFile>    &Inputs,
+              CountSettings        &Settings,
+              vector<TTable>       &WorkerDicts )
+{
+    for ( size_t i = 0; i < Inputs.size(); i++ )
+    {
+        InputFile &input = Inputs[i];
+        if (!input.Open(InputNames[i]))
+        {
+            cerr << "ERROR: Could not open file " << InputNames[i] << endl;
+            Settings.pSpiller->Remove();
+            return false;
+        }
+        StartInput(input, WorkerDicts);
+        if (input.IsMapped())
+        {
+            CountMapped(input.Data(), input.Size(), Settings, WorkerDicts);
+        }
+        else if (!CountFd(input, Settings, WorkerDicts))
+        {
+            cerr << "ERROR: Could not read " << input.Name() << endl;
+            Settings.pSpiller->Remove();
+            return false;
+        }
+        if (Settings.fFailed)
+        {
+            Settings.pSpiller->Remove();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Set by SIGUSR1 to ask for a snapshot.
+ */
+static volatile sig_atomic_t g_fSnapshotRequested = 0;
+
+static void
+RequestSnapshot ( int )
+{
+    g_fSnapshotRequested = 1;
+}
+
+/**
+ * The state of counting with snapshots: the table of counts since the
+ * last snapshot, and when the next snapshot is due.
+ */
+struct LiveState
+{
+    LineTable                          *pLineDict;
+    const KeySelector                  *pSelector;
+    ToolStats                          *pStats;
+    long long                           nLines;
+    chrono::steady_clock::time_point    Deadline;
+};
+
+/**
+ * Adds the key of a line, if it has one, to the table of counts since
+ * the last snapshot.
+ */
+inline void
+CountLiveLine ( LiveState  &State,
+                const char *pLine,
+                size_t      nLength )
+{
+    const char *pKey;
+    size_t      nKeyLength;
+    if (State.pSelector->Select(pLine, nLength, pKey, nKeyLength))
+        State.pLineDict->Add(pKey, nKeyLength);
+}
+
+/**
+ * Hands the counts since the last snapshot over to writer, if a
+ * snapshot is due and the writer is free; otherwise counting carries on
+ * into the same table.
+ */
+void
+SnapshotIfDue ( const SnapshotSettings &Snapshots,
+                SnapshotWriter         &writer,
+                LiveState              &State )
+{
+    chrono::steady_clock::time_point Now = chrono::steady_clock::now();
+    bool fDue = g_fSnapshotRequested ||
+                (Snapshots.nLines && State.nLines >= Snapshots.nLines) ||
+                (Snapshots.nSeconds && Now >= State.Deadline);
+    if (!fDue || !writer.Ready())
+        return;
+    g_fSnapshotRequested = 0;
+    writer.Submit(State.pLineDict);
+    State.pLineDict = new LineTable();
+    State.nLines    = 0;
+    State.Deadline  = Now + chrono::duration_cast<chrono::steady_clock::duration>(
+        chrono::duration<double>(Snapshots.nSeconds));
+}
+
+/**
+ * Counts an unmapped input line by line as it arrives, taking
+ * snapshots as they fall due; waiting for input never delays a
+ * snapshot.  Returns false on a read error.
+ */
+bool
+CountLive ( InputFile              &input,
+            bool                    fIncludeLastLine,
+            const SnapshotSettings &Snapshots,
+            SnapshotWriter         &writer,
+            LiveState              &State )
+{
+    vector<char> Buffer(SNAPSHOT_READ_SIZE);
+    size_t       nUsed = 0;
+    while (true)
+    {
+        int nTimeout = -1;
+        if (Snapshots.nSeconds)
+        {
+            nTimeout = max<long long>(0, chrono::duration_cast<
+                chrono::milliseconds>(State.Deadline -
+                                      chrono::steady_clock::now()).count());
+        }
+        if (!writer.Ready())
+            nTimeout = SNAPSHOT_RETRY_MS;
+        struct pollfd Poll;
+        Poll.fd     = input.Fd();
+        Poll.events = POLLIN;
+        int nReady  = poll(&Poll, 1, nTimeout);
+        if (nReady < 0 && errno != EINTR)
+            return false;
+        if (nReady > 0)
+        {
+            if (nUsed == Buffer.size())
+                Buffer.resize(Buffer.size() * 2);
+            ssize_t nRead = input.Read(Buffer.data() + nUsed,
+                                       Buffer.size() - nUsed);
+            if (nRead < 0)
+                return false;
+            if (nRead == 0)
+            {
+                if (fIncludeLastLine || nUsed > 0)
+                {
+                    CountLiveLine(State, Buffer.data(), nUsed);
+                    State.pStats->AddInput(1, 0);
+                }
+                return true;
+            }
+            if (nRead > 0)
+            {
+                // the carried-over partial line has no newline
+                const char *pLine   = Buffer.data();
+                const char *pSearch = pLine + nUsed;
+                const char *pEnd    = pSearch + nRead;
+                const char *pNewline;
+                long long   nLines  = 0;
+                while ((pNewline = static_cast<const char *>(
+                            memchr(pSearch, '\n', pEnd - pSearch))))
+                {
+                    CountLiveLine(State, pLine, pNewline - pLine);
+                    State.nLines++;
+                    nLines++;
+                    pLine = pSearch = pNewline + 1;
+                    if (Snapshots.nLines && State.nLines >= Snapshots.nLines)
+                        SnapshotIfDue(Snapshots, writer, State);
+                }
+                State.pStats->AddInput(nLines, nRead);
+                nUsed = pEnd - pLine;
+                memmove(Buffer.data(), pLine, nUsed);
+            }
+        }
+        SnapshotIfDue(Snapshots, writer, State);
+    }
+}
+
+/**
+ * Counts each of the named inputs into LineDict with snapshots.
+ * Returns false, after printing a message, on error.
+ */
+bool
+CountInputsLive ( const vector<string>   &InputNames,
+                  bool                    fIncludeLastLine,
+                  const SnapshotSettings &Snapshots,
+                  const KeySelector      &Selector,
+                  ToolStats              &Stats,
+                  LineTable              &LineDict )
+{
+    struct sigaction Action;
+    memset(&Action, 0, sizeof(Action));
+    Action.sa_handler = RequestSnapshot;
+    sigemptyset(&Action.sa_mask);
+    sigaction(SIGUSR1, &Action, 0);
+
+    SnapshotWriter writer(Snapshots);
+    LiveState      State;
+    State.pLineDict = new LineTable();
+    State.pSelector = &Selector;
+    State.pStats    = &Stats;
+    State.nLines    = 0;
+    State.Deadline  = chrono::steady_clock::now() +
+        chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double>(Snapshots.nSeconds));
+    for ( size_t i = 0; i < InputNames.size(); i++ )
+    {
+        InputFile input;
+        if (!input.Open(InputNames[i]))
+        {
+            cerr << "ERROR: Could not open file " << InputNames[i] << endl;
+            delete State.pLineDict;
+            return false;
+        }
+        if (!CountLive(input, fIncludeLastLine, Snapshots, writer,
+                       State))
+        {
+            cerr << "ERROR: Could not read " << input.Name() << endl;
+            delete State.pLineDict;
+            return false;
+        }
+    }
+
+    // a last snapshot holds the rest of the input
+    writer.Submit(State.pLineDict);
+    bool fOk = writer.Finish();
+    LineDict.Absorb(writer.Total());
+    return fOk;
+}
+
+/**
+ * Writes one record of output: as a text line to output, or to
+ * binaryOutput if it is set.
+ */
+inline void
+WriteCount ( OutputFile        &output,
+             BinaryCountWriter *binaryOutput,
+             long long          nCount,
+             string_view        Value )
+{
+    if (binaryOutput)
+        binaryOutput->Write(Value, nCount, 0);
+    else
+        output.WriteRecord(nCount, Value);
+}
+
+inline CountStream *
+NewTableStream ( const LineTable &LineDict )
+{
+    return new TableStream<long long>(LineDict);
+}
+
+inline CountStream *
+NewTableStream ( const LineTrie &LineDict )
+{
+    return new TrieStream<long long>(LineDict);
+}
+
+/**
+ * Merges the spilled runs with what is left in every worker's table and
+ * writes the result: in alphabetical order or, if fSortDecreasingFreq
+ * is set, the nTopK highest counts in descending order.  Returns false
+ * on failure.
+ */
+template<typename TTable>
+bool
+WriteMergedTables ( RunSpiller        &spiller,
+                    vector<TTable>    &WorkerDicts,
+                    bool               fSortDecreasingFreq,
+                    size_t             nTopK,
+                    size_t             nMemoryBudget,
+                    const string      &sTempDir,
+                    OutputFile        &output,
+                    BinaryCountWriter *binaryOutput,
+                    ToolStats         &Stats )
+{
+    if (!spiller.Consolidate(MAX_MERGE_FAN_IN))
+        return false;
+    vector<CountStream *> Streams;
+    for ( size_t i = 0; i < spiller.Runs().size(); i++ )
+        Streams.push_back(new CountFileStream(spiller.Runs()[i], false));
+    for ( size_t i = 0; i < WorkerDicts.size(); i++ )
+        Streams.push_back(NewTableStream(WorkerDicts[i]));
+    // with -f, the merged counts come out alphabetically, so sorting
+    // them stably by count breaks ties alphabetically, as TopEntries()
+    // does
+    CountOrderSorter sorter(false, nMemoryBudget, sTempDir);
+    bool             fSortOk   = true;
+    long long        nDistinct = 0;
+    bool             fMergeOk  = MergeCountStreams(
+        Streams, false,
+        [&](long long   nCount,
+            double,
+            string_view Value)
+        {
+            nDistinct++;
+            if (!fSortDecreasingFreq)
+                WriteCount(output, binaryOutput, nCount, Value);
+            else if (fSortOk)
+                fSortOk = sorter.Add(nCount, 0, Value);
+        }) && fSortOk;
+    Stats.Set("distinct_keys", nDistinct);
+    for ( size_t i = 0; i < Streams.size(); i++ )
+        delete Streams[i];
+    if (fMergeOk && fSortDecreasingFreq)
+    {
+        Stats.Phase("sort");
+        fMergeOk = sorter.Write(
+            nTopK,
+            [&output, binaryOutput](long long   nCount,
+                                    double,
+                                    string_view Value)
+            {
+                WriteCount(output, binaryOutput, nCount, Value);
+            });
+    }
+    return fMergeOk;
+}
+
+/**
+ * Counts the named inputs, which must be sorted (with --sorted), by
+ * runs of equal lines, and writes the counts: each as its run ends or,
+ * if fSortDecreasingFreq is set, the nTopK highest counts in descending
+ * order.  Returns false, after printing a message, if an input cannot
+ * be read or is out of order, or on any other failure.
+ */
+bool
+WriteSortedInput ( const vector<string> &InputNames,
+                   vector<InputFile>    &Inputs,
+                   CountSettings        &Settings,
+                   bool                  fSortDecreasingFreq,
+                   size_t                nTopK,
+                   size_t                nMemoryBudget,
+                   const string         &sTempDir,
+                   OutputFile           &output,
+                   BinaryCountWriter    *binaryOutput,
+                   ToolStats            &Stats )
+{
+    CountOrderSorter    sorter(false, nMemoryBudget, sTempDir);
+    vector<SortedState> States(1);
+    SortedState        &State = States[0];
+    State.fForced = true;
+    State.Emit    = [&](long long   nCount,
+                        string_view Value)
+    {
+        if (fSortDecreasingFreq)
+            return sorter.Add(nCount, 0, Value);
+        WriteCount(output, binaryOutput, nCount, Value);
+        return true;
+    };
+    if (!CountInputs(InputNames, Inputs, Settings, States))
+        return false;
+    bool fOk = EndSortedRuns(State, Settings);
+    Stats.Set("distinct_keys", State.nRuns);
+    if (fOk && fSortDecreasingFreq)
+    {
+        Stats.Phase("sort");
+        fOk = sorter.Write(
+            nTopK,
+            [&output, binaryOutput](long long   nCount,
+                                    double,
+                                    string_view Value)
+            {
+                WriteCount(output, binaryOutput, nCount, Value);
+            });
+    }
+    return fOk;
+}
+
+/**
+ * Counts each of the named inputs into LineDict on one thread, by runs
+ * of equal lines for as long as the input is sorted (see SortedState).
+ * Returns false on error, after printing a message and removing any
+ * spilled runs.
+ */
+bool
+CountInputsSorted ( const vector<string> &InputNames,
+                    vector<InputFile>    &Inputs,
+                    CountSettings        &Settings,
+                    ToolStats            &Stats,
+                    LineTable            &LineDict )
+{
+    vector<SortedState> States(1);
+    States[0].pLineDict = &LineDict;
+    if (!CountInputs(InputNames, Inputs, Settings, States))
+        return false;
+    if (!EndSortedRuns(States[0], Settings))
+    {
+        Settings.pSpiller->Remove();
+        return false;
+    }
+    Stats.Set("input_sorted", States[0].fUnsorted ? 0 : 1);
+    return true;
 }
 
 int
@@ -72,17 +1082,234 @@ main ( int    argc,
 {
     bool       fIncludeLastLine    = false;
     bool       fSortDecreasingFreq = false;
+    int        nThreads            = 1;
+    size_t     nMemoryBudget       = 0;
+    string     sTempDir            = "";
+    size_t     nTopK               = 0;
+    bool       fApproximate        = false;
+    bool       fBinaryOutput       = false;
+    bool       fSnapshots          = false;
+    bool       fTrie               = false;
+    bool       fSorted             = false;
+    bool       fDistinct           = false;
+    string     sSketchFileName     = "";
+    int        nPrecision          = HLL_DEFAULT_PRECISION;
+    bool       fPrecision          = false;
+    string     sStoreDir           = "";
+    bool       fFields             = false;
+    bool       fDelimiter          = false;
+    bool       fWhitespace         = false;
+    string     sPattern            = "";
+    int        nGroup              = -1;
+    Compression OutputCompression  = COMPRESSION_NONE;
     int        c;
-    while ((c = getopt(argc, argv, "ef?")) != -1)
+
+    KeySelector      Selector;
+    ToolStats        Stats("count");
+    SnapshotSettings Snapshots;
+    Snapshots.nSeconds = 0;
+    Snapshots.nLines   = 0;
+    Snapshots.fDelta   = false;
+    Snapshots.nKeep    = 0;
+
+    static const struct option LongOptions[] =
+    {
+        { "approx",      no_argument,       0, 'a' },
+        { "snapshot",    required_argument, 0, 'P' },
+        { "every",       required_argument, 0, 'I' },
+        { "every-lines", required_argument, 0, 'L' },
+        { "delta",       no_argument,       0, 'D' },
+        { "keep",        required_argument, 0, 'K' },
+        { "update",      required_argument, 0, 'U' },
+        { "trie",        no_argument,       0, 'R' },
+        { "sorted",      no_argument,       0, 'O' },
+        { "distinct",    no_argument,       0, 'N' },
+        { "sketch",      required_argument, 0, 'W' },
+        { "precision",   required_argument, 0, 'Q' },
+        { "stats",       no_argument,       0, STATS_OPTION },
+        { "stats-json",  required_argument, 0, STATS_JSON_OPTION },
+        { "progress",    required_argument, 0, PROGRESS_OPTION },
+        { 0,             0,                 0, 0   }
+    };
+    while ((c = getopt_long(argc, argv, "befj:k:S:T:F:d:wr:g:z:?",
+                            LongOptions, 0)) != -1)
     {
         switch(c)
         {
+        case 'b':
+            fBinaryOutput = true;
+            break;
         case 'e':
             fIncludeLastLine = true;
             break;
         case 'f':
             fSortDecreasingFreq = true;
             break;
+        case 'j':
+        {
+            istringstream iss(optarg);
+            iss >> nThreads;
+            if (iss.fail() || nThreads <= 0)
+            {
+                cerr << "ERROR: Invalid thread count " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            break;
+        }
+        case 'S':
+            if (!ParseMemorySize(optarg, nMemoryBudget))
+            {
+                cerr << "ERROR: Invalid memory size " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            break;
+        case 'T':
+            sTempDir = optarg;
+            break;
+        case 'k':
+        {
+            long long     nValue = 0;
+            istringstream iss(optarg);
+            iss >> nValue;
+            if (iss.fail() || nValue <= 0)
+            {
+                cerr << "ERROR: Invalid number of lines " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            nTopK = nValue;
+            break;
+        }
+        case 'a':
+            fApproximate = true;
+            break;
+        case 'P':
+            fSnapshots        = true;
+            Snapshots.sPrefix = optarg;
+            break;
+        case 'I':
+        {
+            istringstream iss(optarg);
+            iss >> Snapshots.nSeconds;
+            if (iss.fail() || Snapshots.nSeconds <= 0)
+            {
+                cerr << "ERROR: Invalid snapshot interval " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            break;
+        }
+        case 'L':
+        {
+            istringstream iss(optarg);
+            iss >> Snapshots.nLines;
+            if (iss.fail() || Snapshots.nLines <= 0)
+            {
+                cerr << "ERROR: Invalid number of lines " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            break;
+        }
+        case 'D':
+            Snapshots.fDelta = true;
+            break;
+        case 'K':
+        {
+            long long     nValue = 0;
+            istringstream iss(optarg);
+            iss >> nValue;
+            if (iss.fail() || nValue <= 0)
+            {
+                cerr << "ERROR: Invalid number of snapshots " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            Snapshots.nKeep = nValue;
+            break;
+        }
+        case 'U':
+            sStoreDir = optarg;
+            break;
+        case 'R':
+            fTrie = true;
+            break;
+        case 'O':
+            fSorted = true;
+            break;
+        case 'N':
+            fDistinct = true;
+            break;
+        case 'W':
+            sSketchFileName = optarg;
+            break;
+        case 'Q':
+        {
+            istringstream iss(optarg);
+            iss >> nPrecision;
+            if (iss.fail() || nPrecision < HLL_MIN_PRECISION ||
+                nPrecision > HLL_MAX_PRECISION)
+            {
+                cerr << "ERROR: Invalid precision " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            fPrecision = true;
+            break;
+        }
+        case 'F':
+            if (!Selector.SetFields(optarg))
+            {
+                cerr << "ERROR: Invalid field list " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            fFields = true;
+            break;
+        case 'd':
+            if (strlen(optarg) != 1)
+            {
+                cerr << "ERROR: The delimiter must be a single character"
+                     << endl;
+                exit(1);
+            }
+            Selector.SetDelimiter(optarg[0]);
+            fDelimiter = true;
+            break;
+        case 'w':
+            Selector.SetWhitespace();
+            fWhitespace = true;
+            break;
+        case 'r':
+            sPattern = optarg;
+            break;
+        case 'g':
+        {
+            istringstream iss(optarg);
+            iss >> nGroup;
+            if (iss.fail() || nGroup < 0)
+            {
+                cerr << "ERROR: Invalid group number " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            break;
+        }
+        case 'z':
+            if (!ParseCompression(optarg, OutputCompression))
+                exit(1);
+            break;
+        case STATS_OPTION:
+        case STATS_JSON_OPTION:
+        case PROGRESS_OPTION:
+            if (!Stats.ParseOption(c, optarg))
+            {
+                printHelp();
+                exit(1);
+            }
+            break;
         case '?':
             printHelp();
             exit(1);
@@ -92,41 +1319,278 @@ main ( int    argc,
         }
     }
 
-    int             nNumLines = 0;
-    map<string,int> LineDict;
-    while ( cin.good() )
+    if (nTopK)
+        fSortDecreasingFreq = true;
+    if (fApproximate && !nTopK)
+    {
+        cerr << "ERROR: --approx requires -k" << endl;
+        exit(1);
+    }
+    if (fApproximate && fBinaryOutput)
+    {
+        cerr << "ERROR: --approx cannot be combined with -b" << endl;
+        exit(1);
+    }
+    if (!fSnapshots && (Snapshots.nSeconds || Snapshots.nLines ||
+                        Snapshots.fDelta || Snapshots.nKeep))
+    {
+        cerr << "ERROR: --every, --every-lines, --delta and --keep "
+             << "require --snapshot" << endl;
+        exit(1);
+    }
+    if (fSnapshots && (nThreads > 1 || nMemoryBudget || fApproximate))
+    {
+        cerr << "ERROR: --snapshot cannot be combined with -j, -S or --approx"
+             << endl;
+        exit(1);
+    }
+    if (fTrie && (fSnapshots || fApproximate))
+    {
+        cerr << "ERROR: --trie cannot be combined with --snapshot or --approx"
+             << endl;
+        exit(1);
+    }
+    if (fSorted && (nThreads > 1 || fApproximate || fDistinct ||
+                    fSnapshots || fTrie))
+    {
+        cerr << "ERROR: --sorted cannot be combined with -j, --approx, "
+             << "--distinct, --snapshot or --trie" << endl;
+        exit(1);
+    }
+    if ((!sSketchFileName.empty() || fPrecision) && !fDistinct)
+    {
+        cerr << "ERROR: --sketch and --precision require --distinct" << endl;
+        exit(1);
+    }
+    if (fDistinct && (fBinaryOutput || fSortDecreasingFreq ||
+                      nMemoryBudget || OutputCompression != COMPRESSION_NONE ||
+                      fApproximate || fSnapshots || fTrie ||
+                      !sStoreDir.empty()))
+    {
+        cerr << "ERROR: --distinct cannot be combined with -b, -f, -k, -S, "
+             << "-z, --approx, --snapshot, --trie or --update" << endl;
+        exit(1);
+    }
+    if (!sStoreDir.empty() && (fBinaryOutput || fSortDecreasingFreq ||
+                               OutputCompression != COMPRESSION_NONE ||
+                               fApproximate))
+    {
+        cerr << "ERROR: --update cannot be combined with -b, -f, -k, -z or "
+             << "--approx" << endl;
+        exit(1);
+    }
+    if ((fDelimiter || fWhitespace) && !fFields)
+    {
+        cerr << "ERROR: -d and -w require -F" << endl;
+        exit(1);
+    }
+    if (fDelimiter && fWhitespace)
+    {
+        cerr << "ERROR: -d cannot be combined with -w" << endl;
+        exit(1);
+    }
+    if (nGroup >= 0 && sPattern.empty())
+    {
+        cerr << "ERROR: -g requires -r" << endl;
+        exit(1);
+    }
+    if (!sPattern.empty())
+    {
+        if (fFields)
+        {
+            cerr << "ERROR: -r cannot be combined with -F" << endl;
+            exit(1);
+        }
+        if (!Selector.SetRegex(sPattern, nGroup))
+            exit(1);
+    }
+    Snapshots.fBinary = fBinaryOutput;
+
+    vector<string> InputNames(argv + optind, argv + argc);
+    if (InputNames.empty())
+        InputNames.push_back("-");
+
+    RunSpiller    spiller(sTempDir, false);
+    CountSettings Settings;
+    Settings.fIncludeLastLine = fIncludeLastLine;
+    Settings.nTableBudget     = nMemoryBudget ?
+        TableBudget(nMemoryBudget, nThreads) : 0;
+    Settings.pSpiller         = &spiller;
+    Settings.fFailed          = false;
+    Settings.pSelector        = &Selector;
+    Settings.pStats           = &Stats;
+
+    vector<InputFile> Inputs(InputNames.size());
+    OutputFile        output;
+    CountStore        store(sStoreDir);
+    string            sRunName;
+    if (sStoreDir.empty())
     {
-        string sLine;
-        getline ( cin, sLine );
-        if (fIncludeLastLine || !cin.eof() || sLine.length() != 0)
+        if (!output.Open("-", OutputCompression))
+            exit(1);
+    }
+    else if (!store.Open(true) || !store.CreateRun(sRunName, output))
+        exit(1);
+    Stats.Start("count");
+    if (fApproximate)
+    {
+        size_t nCounters = max(nTopK * APPROX_COUNTERS_PER_KEY,
+                               APPROX_MIN_COUNTERS);
+        vector<SpaceSaving> Summaries(nThreads, SpaceSaving(nCounters));
+        if (!CountInputs(InputNames, Inputs, Settings, Summaries))
+            exit(1);
+        Stats.Phase("merge");
+        for ( size_t i = 1; i < Summaries.size(); i++ )
+            Summaries[0].Merge(Summaries[i]);
+        Stats.Phase("sort");
+        vector<const SpaceSaving::Counter *> Counters;
+        Summaries[0].TopK(nTopK, Counters);
+        Stats.Set("counters", nCounters);
+        Stats.Phase("write");
+        for ( size_t i = 0; i < Counters.size(); i++ )
         {
-            LineDict[sLine] += 1;
+            output.WriteNumber(Counters[i]->nCount);
+            output.Put('\t');
+            output.WriteRecord(Counters[i]->nError, Counters[i]->sValue);
         }
-        nNumLines       += 1;
+        if (!output.Close())
+        {
+            cerr << "ERROR: Could not write to standard output" << endl;
+            exit(1);
+        }
+        return Stats.Report() ? 0 : 1;
     }
-    //int nWidth = 0;
-    //while ( nNumLines > 0 )
-    //{
-    //    nWidth++;
-    //    nNumLines /= 10;
-    //}
-    if (fSortDecreasingFreq)
+    if (fDistinct)
     {
-        map<int,string> FlippedLineDict = flip_map(LineDict);
-        for ( map<int,string>::reverse_iterator iterator =
-                  FlippedLineDict.rbegin();
-              iterator != FlippedLineDict.rend(); iterator++ )
+        vector<HyperLogLog> Sketches(nThreads, HyperLogLog(nPrecision));
+        if (!CountInputs(InputNames, Inputs, Settings, Sketches))
+            exit(1);
+        Stats.Phase("merge");
+        for ( size_t i = 1; i < Sketches.size(); i++ )
+            Sketches[0].Merge(Sketches[i]);
+        long long nEstimate = llround(Sketches[0].Estimate());
+        Stats.Set("distinct_estimate", nEstimate);
+        Stats.Phase("write");
+        if (!sSketchFileName.empty() && !Sketches[0].Save(sSketchFileName))
+            exit(1);
+        output.WriteNumber(nEstimate);
+        output.Put('\n');
+        if (!output.Close())
         {
-            cout << iterator->first << "\t" << iterator->second << endl;
+            cerr << "ERROR: Could not write to standard output" << endl;
+            exit(1);
         }
+        return Stats.Report() ? 0 : 1;
+    }
+
+    BinaryCountWriter *binaryOutput = 0;
+    if (fBinaryOutput)
+        binaryOutput = new BinaryCountWriter(output, false);
+
+    bool fMergeOk = true;
+    if (fSorted)
+    {
+        fMergeOk = WriteSortedInput(InputNames, Inputs, Settings,
+                                    fSortDecreasingFreq, nTopK, nMemoryBudget,
+                                    sTempDir, output, binaryOutput, Stats);
+    }
+    else if (fTrie)
+    {
+        // a trie is walked in alphabetical order, so it is merged just
+        // as a run is, with no sort
+        vector<LineTrie> TrieDicts(nThreads);
+        fMergeOk = CountInputs(InputNames, Inputs, Settings, TrieDicts);
+        Stats.Phase("merge");
+        if (!spiller.Runs().empty())
+            Stats.Set("runs_spilled", spiller.Runs().size());
+        else if (TrieDicts.size() == 1)
+            Stats.SetTable(TrieDicts[0]);
+        fMergeOk = fMergeOk &&
+            WriteMergedTables(spiller, TrieDicts, fSortDecreasingFreq, nTopK,
+                              nMemoryBudget, sTempDir, output, binaryOutput,
+                              Stats);
     }
     else
     {
-        for ( map<string,int>::iterator iterator = LineDict.begin();
-              iterator != LineDict.end(); iterator++ )
+        vector<LineTable> WorkerDicts(nThreads);
+        if (nMemoryBudget)
+        {
+            for ( size_t i = 0; i < WorkerDicts.size(); i++ )
+                WorkerDicts[i].SetArenaBlockSize(
+                    ArenaBlockSizeForBudget(Settings.nTableBudget));
+        }
+        if (fSnapshots)
+            fMergeOk = CountInputsLive(InputNames, fIncludeLastLine,
+                                       Snapshots, Selector, Stats,
+                                       WorkerDicts[0]);
+        else if (nThreads == 1)
+            fMergeOk = CountInputsSorted(InputNames, Inputs, Settings, Stats,
+                                         WorkerDicts[0]);
+        else
+            fMergeOk = CountInputs(InputNames, Inputs, Settings, WorkerDicts);
+        LineTable &LineDict = WorkerDicts[0];
+        Stats.Phase("merge");
+        if (fMergeOk && !spiller.Runs().empty())
+        {
+            // merge the runs with what is left in every worker's table
+            Stats.Set("runs_spilled", spiller.Runs().size());
+            fMergeOk = WriteMergedTables(spiller, WorkerDicts,
+                                         fSortDecreasingFreq, nTopK,
+                                         nMemoryBudget, sTempDir, output,
+                                         binaryOutput, Stats);
+        }
+        else if (fMergeOk)
+        {
+            for ( size_t i = 1; i < WorkerDicts.size(); i++ )
+                LineDict.Absorb(WorkerDicts[i]);
+            Stats.SetTable(LineDict);
+
+            Stats.Phase("sort");
+            vector<const LineTable::Entry *> Entries;
+            if (fSortDecreasingFreq)
+                LineDict.TopEntries(nTopK, Entries);
+            else
+                LineDict.SortedEntries(Entries);
+            Stats.Phase("write");
+            for ( size_t i = 0; i < Entries.size(); i++ )
+            {
+                WriteCount(output, binaryOutput, Entries[i]->nCount,
+                           Entries[i]->Key());
+            }
+        }
+    }
+    if (!fMergeOk)
+    {
+        delete binaryOutput;
+        spiller.Remove();
+        output.Close();
+        if (!sStoreDir.empty())
+            store.AbortRun(sRunName);
+        exit(1);
+    }
+    if (binaryOutput)
+        binaryOutput->Finish();
+    delete binaryOutput;
+    if (!sStoreDir.empty())
+    {
+        if (!output.Close())
         {
-            cout << iterator->second << "\t" << iterator->first << endl;
+            cerr << "ERROR: Could not write file " << output.Name() << endl;
+            store.AbortRun(sRunName);
+            exit(1);
         }
+        if (!store.CommitRun(sRunName))
+        {
+            store.AbortRun(sRunName);
+            exit(1);
+        }
+        store.CompactInBackground();
+        return Stats.Report() ? 0 : 1;
+    }
+    if (!output.Close())
+    {
+        cerr << "ERROR: Could not write to standard output" << endl;
+        exit(1);
     }
-    return 0;
+    return Stats.Report() ? 0 : 1;
 }
@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countconv
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Converts count files between text and binary
+ *
+ * Description:
+ *    countconv reads a count file and writes it out in the other
+ *    format: a text count file becomes a binary count file, and a
+ *    binary count file becomes a text count file.  The input format is
+ *    detected from the first byte of the input.  With -i, countconv
+ *    prints the summary stored in the footer of a binary count file
+ *    instead.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Read compressed inputs; add -z to compress the output.
+ *
+ * \file countconv.cpp
+ */
+
+//#define DEBUG
+
+#include "config.h"
+#include <getopt.h>
+#include <iostream>
+#include "bincount.h"
+#include "compression.h"
+#include "countreader.h"
+#include "outputfile.h"
+using namespace std;
+
+void
+printHelp()
+{
+    cout << "countconv - " << PACKAGE_STRING << endl << endl;
+    cout << "countconv converts a count file between the text and the binary count" << endl;
+    cout << "file formats, writing the result to standard output (or to the file" << endl;
+    cout << "OUTPUT, if this is specified).  A text INPUT is converted to binary, and" << endl;
+    cout << "a binary INPUT to text.  If INPUT is not specified, or is given as the" << endl;
+    cout << "character \"-\", countconv will read from standard input." << endl;
+    cout << endl;
+    cout << "Binary count files hold the same records as text count files, with" << endl;
+    cout << "values prefix-compressed in blocks, followed by a block index and a" << endl;
+    cout << "footer giving the number of distinct values and the total count.  All" << endl;
+    cout << "of the count tools read binary count files, and write them with -b." << endl;
+    cout << endl;
+    cout << "Syntax:" << endl;
+    cout << endl;
+    cout << "   countconv [OPTIONS] [INPUT [OUTPUT]]" << endl;
+    cout << endl;
+    cout << "Options:" << endl;
+    cout << endl;
+    cout << "   -d      interpret counts in a text INPUT as floating-point numbers" << endl;
+    cout << "   -i      print the summary of the binary count file INPUT" << endl;
+    cout << "   -z FORMAT" << endl;
+    cout << "           compress the output with FORMAT: gzip, xz or zstd" << endl;
+    cout << "   -?      display this help message" << endl;
+}
+
+/**
+ * Prints the footer summary of the binary count file sFileName.
+ */
+int
+printSummary ( const string &sFileName )
+{
+    BinaryCountSummary Summary;
+    if (!ReadBinaryCountSummary(sFileName, Summary))
+    {
+        cerr << "ERROR: " << sFileName << " is not a binary count file" << endl;
+        return 1;
+    }
+    cout << "counts\t" << (Summary.fFloatingPoint ? "float" : "integer") << endl;
+    cout << "sorted\t" << (Summary.fSorted ? "yes" : "no") << endl;
+    cout << "values\t" << Summary.nDistinct << endl;
+    if (Summary.fFloatingPoint)
+        cout << "total\t" << Summary.nFloatTotal << endl;
+    else
+        cout << "total\t" << Summary.nTotal << endl;
+    cout << "blocks\t" << Summary.nBlocks << endl;
+    return 0;
+}
+
+int main ( int argc, char **argv )
+{
+    bool       fFloatingPoint      = false;
+    bool       fSummary            = false;
+    Compression OutputCompression  = COMPRESSION_NONE;
+    int        c;
+    while ((c = getopt(argc, argv, "diz:?")) != -1)
+    {
+        switch(c)
+        {
+        case 'd':
+            fFloatingPoint = true;
+            break;
+        case 'i':
+            fSummary = true;
+            break;
+        case 'z':
+            if (!ParseCompression(optarg, OutputCompression))
+                exit(1);
+            break;
+        case '?':
+            printHelp();
+            exit(1);
+            break;
+        default:
+            break;
+        }
+    }
+
+    string      sInputFileName  = "";
+    string      sOutputFileName = "";
+
+    CountReader input;
+    OutputFile  output;
+
+    if ((argc - optind) < 1)
+    {
+        sInputFileName = "-";
+    }
+    else
+    {
+        sInputFileName = argv[optind++];
+    }
+
+    if (fSummary)
+    {
+        if (sInputFileName.compare("-") == 0)
+        {
+            cerr << "ERROR: -i needs an INPUT file" << endl;
+            exit(1);
+        }
+        return printSummary(sInputFileName);
+    }
+
+    if (!input.Open(sInputFileName))
+    {
+        cerr << "ERROR: Could not open file " << sInputFileName << endl;
+        exit(1);
+    }
+
+    if ((argc - optind) == 0)
+    {
+        sOutputFileName = "-";
+    }
+    else
+    {
+        sOutputFileName = argv[optind];
+    }
+    if (!output.Open(sOutputFileName, OutputCompression))
+    {
+        cerr << "ERROR: Could not open file " << sOutputFileName << endl;
+        exit(1);
+    }
+
+    // a binary input is written out as text, with whatever kind of
+    // counts it holds
+    BinaryCountWriter *binaryOutput = 0;
+    input.SetFloatingPoint(true);
+    if (input.IsBinary())
+        fFloatingPoint = input.IsFloatingPointBinary();
+    else
+        binaryOutput = new BinaryCountWriter(output, fFloatingPoint);
+    input.SetFloatingPoint(fFloatingPoint);
+
+    while (input.Next())
+    {
+        if (binaryOutput)
+            binaryOutput->Write(input.Value, input.nCount, input.nFloatCount);
+        else if (fFloatingPoint)
+            output.WriteRecord(input.nFloatCount, input.Value);
+        else
+            output.WriteRecord(input.nCount, input.Value);
+    }
+    if (input.Failed())
+    {
+        output.Close();
+        exit(1);
+    }
+
+    if (binaryOutput)
+        binaryOutput->Finish();
+    delete binaryOutput;
+    if (!output.Close())
+    {
+        cerr << "ERROR: Could not write file " << output.Name() << endl;
+        exit(1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countfilter
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Conditions on the counts and values of count records
+ *
+ * Description:
+ *    Implementation of ValueFilter.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version, moved from threshcount.cpp.
+ *
+ * \file countfilter.cpp
+ */
+
+#include "config.h"
+#include <iostream>
+#include "countfilter.h"
+using namespace std;
+
+ValueFilter::~ValueFilter ()
+{
+    for ( size_t i = 0; i < m_Regexes.size(); i++ )
+    {
+        regfree(m_Regexes[i]);
+        delete m_Regexes[i];
+    }
+}
+
+bool
+ValueFilter::AddRegex ( const string &sRegex )
+{
+    regex_t *pRegex = new regex_t;
+    int      nError = regcomp(pRegex, sRegex.c_str(), REG_EXTENDED | REG_NOSUB);
+    if (nError != 0)
+    {
+        char pMessage[256];
+        regerror(nError, pRegex, pMessage, sizeof(pMessage));
+        cerr << "ERROR: Invalid regular expression " << sRegex << ": "
+             << pMessage << endl;
+        delete pRegex;
+        return false;
+    }
+    m_Regexes.push_back(pRegex);
+    return true;
+}
+
+bool
+ValueFilter::Keep ( string_view Value )
+{
+    if (!m_Prefixes.empty())
+    {
+        size_t i = 0;
+        while (i < m_Prefixes.size() &&
+               Value.compare(0, m_Prefixes[i].size(), m_Prefixes[i]) != 0)
+            i++;
+        if (i == m_Prefixes.size())
+            return false;
+    }
+    for ( size_t i = 0; i < m_Regexes.size(); i++ )
+    {
+#ifdef REG_STARTEND
+        // match the value in place
+        regmatch_t Match;
+        Match.rm_so = 0;
+        Match.rm_eo = Value.size();
+        if (regexec(m_Regexes[i], Value.data(), 1, &Match, REG_STARTEND) != 0)
+            return false;
+#else
+        m_sValue.assign(Value.data(), Value.size());
+        if (regexec(m_Regexes[i], m_sValue.c_str(), 0, 0, 0) != 0)
+            return false;
+#endif
+    }
+    return true;
+}
@@ -0,0 +1,186 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countfilter
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Conditions on the counts and values of count records
+ *
+ * Description:
+ *    CountFilter keeps the range of counts allowed by a set of
+ *    conditions such as ">=10" or "10:99", and ValueFilter a set of
+ *    alternative prefixes and regular expressions that a value must
+ *    match.  They select the records kept by threshcount and by
+ *    CountTable::Filter().
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version, moved from threshcount.cpp.
+ *
+ * \file countfilter.h
+ */
+
+#ifndef COUNTFILTER_H
+#define COUNTFILTER_H
+
+#include <regex.h>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Parses the whole of sNumber into nValue.
+ */
+template<typename TCount>
+bool
+ParseCountNumber ( const std::string &sNumber,
+                   TCount            &nValue )
+{
+    std::istringstream iss(sNumber);
+    iss >> nValue;
+    return !sNumber.empty() && !iss.fail() && iss.peek() == EOF;
+}
+
+/**
+ * The range of counts allowed by a set of conditions: every count
+ * between nLow and nHigh, excluding either end if it is strict.
+ */
+template<typename TCount>
+class CountFilter
+{
+public:
+    CountFilter ()
+        : m_nLow(std::numeric_limits<TCount>::lowest()),
+          m_nHigh(std::numeric_limits<TCount>::max()),
+          m_fLowStrict(false), m_fHighStrict(false)
+    {
+    }
+
+    /**
+     * Narrows the range by the condition sCondition: one of >N, >=N,
+     * <N, <=N, =N, or N:M (between N and M, inclusive).  Returns false
+     * if it is not a valid condition.
+     */
+    bool Add ( const std::string &sCondition );
+
+    bool
+    Keep ( TCount nCount ) const
+    {
+        return (m_fLowStrict ? m_nLow < nCount : m_nLow <= nCount) &&
+               (m_fHighStrict ? nCount < m_nHigh : nCount <= m_nHigh);
+    }
+
+    void
+    AtLeast ( TCount nLow,
+              bool   fStrict )
+    {
+        if (nLow > m_nLow || (nLow == m_nLow && fStrict))
+        {
+            m_nLow       = nLow;
+            m_fLowStrict = fStrict;
+        }
+    }
+
+    void
+    AtMost ( TCount nHigh,
+             bool   fStrict )
+    {
+        if (nHigh < m_nHigh || (nHigh == m_nHigh && fStrict))
+        {
+            m_nHigh       = nHigh;
+            m_fHighStrict = fStrict;
+        }
+    }
+
+private:
+    TCount m_nLow;
+    TCount m_nHigh;
+    bool   m_fLowStrict;
+    bool   m_fHighStrict;
+};
+
+template<typename TCount>
+bool
+CountFilter<TCount>::Add ( const std::string &sCondition )
+{
+    TCount nValue;
+    TCount nHigh;
+    size_t nColon = sCondition.find(':');
+    if (sCondition.compare(0, 2, ">=") == 0 &&
+        ParseCountNumber(sCondition.substr(2), nValue))
+        AtLeast(nValue, false);
+    else if (sCondition.compare(0, 2, "<=") == 0 &&
+             ParseCountNumber(sCondition.substr(2), nValue))
+        AtMost(nValue, false);
+    else if (sCondition.compare(0, 1, ">") == 0 &&
+             ParseCountNumber(sCondition.substr(1), nValue))
+        AtLeast(nValue, true);
+    else if (sCondition.compare(0, 1, "<") == 0 &&
+             ParseCountNumber(sCondition.substr(1), nValue))
+        AtMost(nValue, true);
+    else if (sCondition.compare(0, 1, "=") == 0 &&
+             ParseCountNumber(sCondition.substr(1), nValue))
+    {
+        AtLeast(nValue, false);
+        AtMost(nValue, false);
+    }
+    else if (nColon != std::string::npos &&
+             ParseCountNumber(sCondition.substr(0, nColon), nValue) &&
+             ParseCountNumber(sCondition.substr(nColon + 1), nHigh))
+    {
+        AtLeast(nValue, false);
+        AtMost(nHigh, false);
+    }
+    else
+        return false;
+    return true;
+}
+
+/**
+ * The conditions on the value: a set of alternative prefixes, and
+ * regular expressions that must all match.
+ */
+class ValueFilter
+{
+public:
+    ValueFilter () {}
+
+    ~ValueFilter ();
+
+    ValueFilter ( const ValueFilter & ) = delete;
+    ValueFilter &operator= ( const ValueFilter & ) = delete;
+
+    void
+    AddPrefix ( const std::string &sPrefix )
+    {
+        m_Prefixes.push_back(sPrefix);
+    }
+
+    /**
+     * Adds the extended regular expression sRegex.  Returns false,
+     * after printing a message, if it does not compile.
+     */
+    bool AddRegex ( const std::string &sRegex );
+
+    bool
+    Empty () const
+    {
+        return m_Prefixes.empty() && m_Regexes.empty();
+    }
+
+    bool Keep ( std::string_view Value );
+
+private:
+    std::vector<std::string> m_Prefixes;
+    std::vector<regex_t*>    m_Regexes;
+    std::string              m_sValue;
+};
+
+#endif // COUNTFILTER_H
@@ -0,0 +1,259 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countorder
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Sorts count records by descending count
+ *
+ * Description:
+ *    Implementation of CountOrderSorter.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file countorder.cpp
+ */
+
+#include "config.h"
+#include <string.h>
+#include <unistd.h>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include "countorder.h"
+using namespace std;
+
+/**
+ * Maps a count to a key that sorts (as an unsigned number) before the
+ * keys of all smaller counts.
+ */
+static inline uint64_t
+DescendingKey ( bool      fFloatingPoint,
+                long long nCount,
+                double    nFloatCount )
+{
+    uint64_t nBits;
+    if (fFloatingPoint)
+    {
+        // IEEE doubles order like sign-magnitude integers: flipping
+        // every bit of a negative number, and the sign bit of a
+        // positive one, makes their order that of unsigned integers
+        memcpy(&nBits, &nFloatCount, sizeof(nBits));
+        nBits = (nBits >> 63) ? ~nBits : nBits | (1ULL << 63);
+    }
+    else
+    {
+        nBits = static_cast<uint64_t>(nCount) ^ (1ULL << 63);
+    }
+    return ~nBits;
+}
+
+CountOrderSorter::CountOrderSorter ( bool          fFloatingPoint,
+                                     size_t        nMemoryBudget,
+                                     const string &sTempDir )
+    : m_fFloatingPoint(fFloatingPoint), m_nMemoryBudget(nMemoryBudget),
+      m_Spiller(sTempDir, fFloatingPoint), m_nRunsWritten(0)
+{
+    if (m_nMemoryBudget)
+        m_Arena.SetBlockSize(ArenaBlockSizeForBudget(m_nMemoryBudget));
+}
+
+bool
+CountOrderSorter::Add ( long long   nCount,
+                        double      nFloatCount,
+                        const char *pValue,
+                        size_t      nLength )
+{
+    Record record;
+    record.nKey        = DescendingKey(m_fFloatingPoint, nCount, nFloatCount);
+    record.pValue      = pValue;
+    record.nLength     = nLength;
+    record.nCount      = nCount;
+    record.nFloatCount = nFloatCount;
+    m_Records.push_back(record);
+    // the radix sort needs a second array of records as large again
+    if (m_nMemoryBudget &&
+        2 * m_Records.capacity() * sizeof(Record) + m_Arena.BytesAllocated()
+        >= m_nMemoryBudget)
+    {
+        return Spill();
+    }
+    return true;
+}
+
+void
+CountOrderSorter::Sort ()
+{
+    size_t nRecords = m_Records.size();
+    if (nRecords < 2)
+        return;
+    // only the bytes in which some keys differ need a pass
+    uint64_t nAll = ~0ULL;
+    uint64_t nAny = 0;
+    for ( size_t i = 0; i < nRecords; i++ )
+    {
+        nAll &= m_Records[i].nKey;
+        nAny |= m_Records[i].nKey;
+    }
+    uint64_t       nDiffer = nAll ^ nAny;
+    vector<Record> Buffer(nRecords);
+    Record        *pFrom   = m_Records.data();
+    Record        *pTo     = Buffer.data();
+    for ( int nShift = 0; nShift < 64; nShift += 8 )
+    {
+        if (((nDiffer >> nShift) & 0xFF) == 0)
+            continue;
+        size_t Offsets[256] = { 0 };
+        for ( size_t i = 0; i < nRecords; i++ )
+            Offsets[(pFrom[i].nKey >> nShift) & 0xFF]++;
+        size_t nTotal = 0;
+        for ( size_t b = 0; b < 256; b++ )
+        {
+            size_t nCount = Offsets[b];
+            Offsets[b]    = nTotal;
+            nTotal       += nCount;
+        }
+        for ( size_t i = 0; i < nRecords; i++ )
+            pTo[Offsets[(pFrom[i].nKey >> nShift) & 0xFF]++] = pFrom[i];
+        swap(pFrom, pTo);
+    }
+    if (pFrom != m_Records.data())
+        m_Records.swap(Buffer);
+}
+
+bool
+CountOrderSorter::Spill ()
+{
+    Sort();
+    string     sRunName;
+    OutputFile runFile;
+    if (!m_Spiller.CreateRun(sRunName, runFile))
+        return false;
+    for ( size_t i = 0; i < m_Records.size(); i++ )
+    {
+        string_view Value(m_Records[i].pValue, m_Records[i].nLength);
+        if (m_fFloatingPoint)
+            runFile.WriteRecord(m_Records[i].nFloatCount, Value);
+        else
+            runFile.WriteRecord(m_Records[i].nCount, Value);
+    }
+    vector<Record>().swap(m_Records);
+    m_Arena.Clear();
+    m_Runs.push_back(sRunName);
+    m_nRunsWritten++;
+    return m_Spiller.FinishRun(sRunName, runFile);
+}
+
+bool
+CountOrderSorter::MergeRuns ( const vector<string> &Runs,
+                              size_t                nK,
+                              const function<void(long long,
+                                                  double,
+                                                  string_view)> &Output )
+{
+    vector<unique_ptr<CountReader> > Readers;
+    vector<uint64_t>                 Keys(Runs.size());
+    // the run whose record comes first is on top: the one with the
+    // smallest key, or the earliest run among equal keys
+    auto fnAfter = [&Keys](size_t a, size_t b)
+    {
+        return Keys[a] != Keys[b] ? Keys[a] > Keys[b] : a > b;
+    };
+    priority_queue<size_t, vector<size_t>, decltype(fnAfter)> Heap(fnAfter);
+    for ( size_t i = 0; i < Runs.size(); i++ )
+    {
+        Readers.emplace_back(new CountReader());
+        CountReader &reader = *Readers.back();
+        if (!reader.Open(Runs[i]))
+        {
+            cerr << "ERROR: Could not open file " << Runs[i] << endl;
+            return false;
+        }
+        reader.SetFloatingPoint(m_fFloatingPoint);
+        if (reader.Next())
+        {
+            Keys[i] = DescendingKey(m_fFloatingPoint, reader.nCount,
+                                    reader.nFloatCount);
+            Heap.push(i);
+        }
+        else if (reader.Failed())
+            return false;
+    }
+    for ( size_t nWritten = 0; !Heap.empty() && (!nK || nWritten < nK);
+          nWritten++ )
+    {
+        size_t       i      = Heap.top();
+        CountReader &reader = *Readers[i];
+        Heap.pop();
+        Output(reader.nCount, reader.nFloatCount, reader.Value);
+        if (reader.Next())
+        {
+            Keys[i] = DescendingKey(m_fFloatingPoint, reader.nCount,
+                                    reader.nFloatCount);
+            Heap.push(i);
+        }
+        else if (reader.Failed())
+            return false;
+    }
+    return true;
+}
+
+bool
+CountOrderSorter::Write ( size_t nK,
+                          const function<void(long long,
+                                              double,
+                                              string_view)> &Output )
+{
+    if (m_Runs.empty())
+    {
+        Sort();
+        size_t nRecords = nK ? min(nK, m_Records.size()) : m_Records.size();
+        for ( size_t i = 0; i < nRecords; i++ )
+        {
+            Output(m_Records[i].nCount, m_Records[i].nFloatCount,
+                   string_view(m_Records[i].pValue, m_Records[i].nLength));
+        }
+        return true;
+    }
+
+    bool fOk = m_Records.empty() || Spill();
+    // merge the oldest runs into one until few enough remain; they are
+    // replaced by the merged run, so the runs stay in order
+    while (fOk && m_Runs.size() > MAX_MERGE_FAN_IN)
+    {
+        vector<string> Inputs(m_Runs.begin(),
+                              m_Runs.begin() + MAX_MERGE_FAN_IN);
+        string         sRunName;
+        OutputFile     runFile;
+        fOk = m_Spiller.CreateRun(sRunName, runFile);
+        if (!fOk)
+            break;
+        bool fFloatingPoint = m_fFloatingPoint;
+        fOk = MergeRuns(Inputs, 0,
+                        [&runFile, fFloatingPoint](long long   nCount,
+                                                   double      nFloatCount,
+                                                   string_view Value)
+                        {
+                            if (fFloatingPoint)
+                                runFile.WriteRecord(nFloatCount, Value);
+                            else
+                                runFile.WriteRecord(nCount, Value);
+                        });
+        fOk = m_Spiller.FinishRun(sRunName, runFile) && fOk;
+        for ( size_t i = 0; i < Inputs.size(); i++ )
+            unlink(Inputs[i].c_str());
+        m_Runs.erase(m_Runs.begin(), m_Runs.begin() + MAX_MERGE_FAN_IN);
+        m_Runs.insert(m_Runs.begin(), sRunName);
+    }
+    if (fOk)
+        fOk = MergeRuns(m_Runs, nK, Output);
+    m_Spiller.Remove();
+    m_Runs.clear();
+    return fOk;
+}
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countorder
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Sorts count records by descending count
+ *
+ * Description:
+ *    CountOrderSorter collects count records and gives them back in
+ *    order of descending count, with records of equal count in the
+ *    order they were added; since count files are in alphabetical
+ *    order, ties come out alphabetically, as with count -f.
+ *
+ *    Counts are turned into unsigned 64-bit keys whose order is that
+ *    of the counts, integer or floating point, reversed, and the
+ *    records are sorted on their keys with a least-significant-digit
+ *    radix sort, which is stable and costs a few linear passes over
+ *    the keys, skipping the bytes that every key shares (the high
+ *    bytes of small counts).  No value is ever compared.
+ *
+ *    Under a memory budget, records that do not fit are sorted and
+ *    written out to temporary runs in count order, and the runs are
+ *    merged at the end, on count and then on the order in which they
+ *    were written, so ties still keep their order.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file countorder.h
+ */
+
+#ifndef COUNTORDER_H
+#define COUNTORDER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "countrun.h"
+#include "counttable.h"
+
+class CountOrderSorter
+{
+public:
+    /**
+     * Records are kept in about nMemoryBudget bytes (or without limit,
+     * if it is zero), with runs written under sTempDir (see
+     * RunSpiller).
+     */
+    CountOrderSorter ( bool               fFloatingPoint,
+                       size_t             nMemoryBudget,
+                       const std::string &sTempDir );
+
+    /**
+     * Adds a record, copying its value.  Returns false, after printing
+     * a message, if a run could not be written.
+     */
+    bool
+    Add ( long long        nCount,
+          double           nFloatCount,
+          std::string_view Value )
+    {
+        return Add(nCount, nFloatCount,
+                   m_Arena.Store(Value.data(), Value.size()), Value.size());
+    }
+
+    /**
+     * Like Add(), but keeps a pointer to the caller's value, which must
+     * stay valid until the records have been written.
+     */
+    bool
+    AddBorrowed ( long long        nCount,
+                  double           nFloatCount,
+                  std::string_view Value )
+    {
+        return Add(nCount, nFloatCount, Value.data(), Value.size());
+    }
+
+    /**
+     * Calls Output with each record in order of descending count,
+     * stopping after nK records if nK is not zero, and removes any
+     * runs.  Returns false, after printing a message, on failure.
+     */
+    bool Write ( size_t nK,
+                 const std::function<void(long long,
+                                          double,
+                                          std::string_view)> &Output );
+
+    /**
+     * The number of runs written so far.
+     */
+    size_t
+    RunCount () const
+    {
+        return m_nRunsWritten;
+    }
+
+private:
+    struct Record
+    {
+        uint64_t    nKey;
+        const char *pValue;
+        size_t      nLength;
+        long long   nCount;
+        double      nFloatCount;
+    };
+
+    bool Add ( long long   nCount,
+               double      nFloatCount,
+               const char *pValue,
+               size_t      nLength );
+    void Sort ();
+    bool Spill ();
+    bool MergeRuns ( const std::vector<std::string> &Runs,
+                     size_t                          nK,
+                     const std::function<void(long long,
+                                              double,
+                                              std::string_view)> &Output );
+
+    bool                     m_fFloatingPoint;
+    size_t                   m_nMemoryBudget;
+    std::vector<Record>      m_Records;
+    KeyArena                 m_Arena;
+    RunSpiller               m_Spiller;
+    std::vector<std::string> m_Runs;
+    size_t                   m_nRunsWritten;
+};
+
+#endif // COUNTORDER_H
@@ -0,0 +1,329 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countreader
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Fast reader for count files, shared by all the tools
+ *
+ * Description:
+ *    Implementation of CountReader.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Range reading, for parallel merging.
+ *          - Read through InputFile, so that compressed inputs are
+ *            decompressed.
+ *          - Report the input read to a ToolStats.
+ *
+ * \file countreader.cpp
+ */
+
+#include "config.h"
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <charconv>
+#include <iostream>
+#include "countreader.h"
+using namespace std;
+
+/**
+ * The initial size of the read buffer for input that is not mapped; it
+ * grows to hold longer lines.
+ */
+const size_t COUNTREADER_BUFFER_SIZE = 1 << 20;
+
+static inline bool
+IsSpace ( char c )
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+           c == '\f';
+}
+
+/**
+ * Parses the count field [pBegin, pEnd) the way istream's operator>>
+ * does: leading white space and a plus sign are skipped, and anything
+ * after the number is ignored.  Returns false if there is no number, or
+ * if it is out of range.
+ */
+static bool
+ParseCountField ( const char *pBegin,
+                  const char *pEnd,
+                  bool        fFloatingPoint,
+                  long long  &nCount,
+                  double     &nFloatCount )
+{
+    while (pBegin < pEnd && IsSpace(*pBegin))
+        pBegin++;
+    if (pBegin < pEnd && *pBegin == '+')
+    {
+        pBegin++;
+        if (pBegin < pEnd && *pBegin == '-')
+            return false;
+    }
+    from_chars_result result;
+    if (fFloatingPoint)
+    {
+        // from_chars also takes "inf" and "nan", which istream does not
+        const char *pDigits = pBegin;
+        if (pDigits < pEnd && *pDigits == '-')
+            pDigits++;
+        if (pDigits == pEnd || !(isdigit(static_cast<unsigned char>(*pDigits))
+                                 || *pDigits == '.'))
+            return false;
+        result = from_chars(pBegin, pEnd, nFloatCount);
+    }
+    else
+    {
+        result = from_chars(pBegin, pEnd, nCount);
+    }
+    return result.ec == errc();
+}
+
+CountReader::CountReader ()
+    : nCount(0), nFloatCount(0), m_fFloatingPoint(false),
+      m_fCheckSorted(false), m_fAllowMissingTab(false), m_fQuiet(false),
+      m_fStarted(false), m_fFailed(false), m_fEof(false), m_nLinesRead(0),
+      m_pCur(0), m_pEnd(0), m_fHaveLastValue(false), m_pStats(0),
+      m_nBytesTotal(0), m_nLinesReported(0), m_nBytesReported(0)
+{
+}
+
+CountReader::~CountReader ()
+{
+}
+
+bool
+CountReader::Open ( const string &sFileName )
+{
+    if (!m_Input.Open(sFileName))
+        return false;
+    m_sName = m_Input.Name();
+    return true;
+}
+
+void
+CountReader::OpenRange ( const char *pBegin,
+                         const char *pEnd )
+{
+    m_pCur        = pBegin;
+    m_pEnd        = pEnd;
+    m_nBytesTotal = pEnd - pBegin;
+    m_fEof        = true;
+    m_fStarted    = true;
+}
+
+bool
+CountReader::IsMapped ()
+{
+    Start();
+    return m_Input.IsMapped() && !m_pBinary;
+}
+
+bool
+CountReader::IsBinary ()
+{
+    Start();
+    return m_pBinary != nullptr;
+}
+
+bool
+CountReader::Start ()
+{
+    if (m_fStarted)
+        return !m_fFailed;
+    m_fStarted = true;
+    if (m_Input.IsMapped())
+    {
+        m_pCur        = m_Input.Data();
+        m_pEnd        = m_pCur + m_Input.Size();
+        m_nBytesTotal = m_Input.Size();
+        m_fEof        = true;
+    }
+    else
+    {
+        m_Buffer.resize(COUNTREADER_BUFFER_SIZE);
+        m_pCur = m_pEnd = m_Buffer.data();
+        Fill();
+        if (m_fFailed)
+            return false;
+    }
+
+    if (m_pCur < m_pEnd && *m_pCur == BINCOUNT_MAGIC[0])
+    {
+        m_pBinary.reset(new BinaryCountReader(*this));
+        if (!m_pBinary->ReadHeader())
+            return Fail(0, "not a valid binary count file");
+        if (m_pBinary->FloatingPoint() && !m_fFloatingPoint)
+            return Fail(0, "file has floating-point counts; use -d");
+    }
+    return true;
+}
+
+bool
+CountReader::Fill ()
+{
+    if (m_fEof)
+        return false;
+    size_t nKeep = m_pEnd - m_pCur;
+    if (nKeep > 0 && m_pCur != m_Buffer.data())
+        memmove(m_Buffer.data(), m_pCur, nKeep);
+    if (nKeep == m_Buffer.size())
+        m_Buffer.resize(m_Buffer.size() * 2);
+    ssize_t nRead = m_Input.Read(m_Buffer.data() + nKeep,
+                                 m_Buffer.size() - nKeep);
+    m_pCur = m_Buffer.data();
+    m_pEnd = m_pCur + nKeep + (nRead > 0 ? nRead : 0);
+    if (nRead > 0)
+        m_nBytesTotal += nRead;
+    if (nRead < 0)
+    {
+        cerr << "ERROR: Could not read " << m_Input.Name() << endl;
+        m_fFailed = true;
+    }
+    if (nRead <= 0)
+    {
+        m_fEof = true;
+        return false;
+    }
+    return true;
+}
+
+bool
+CountReader::Fail ( int         nLine,
+                    const char *pMessage )
+{
+    m_fFailed = true;
+    if (m_fQuiet)
+        return false;
+    if (!m_sName.empty())
+        cerr << m_sName << ":";
+    if (nLine > 0)
+        cerr << nLine << ":";
+    cerr << " error: " << pMessage << endl;
+    return false;
+}
+
+size_t
+CountReader::Read ( char   *pData,
+                    size_t  nLength )
+{
+    size_t nDone = 0;
+    while (nDone < nLength)
+    {
+        if (m_pCur == m_pEnd && !Fill())
+            break;
+        size_t nCopy = min(nLength - nDone,
+                           static_cast<size_t>(m_pEnd - m_pCur));
+        memcpy(pData + nDone, m_pCur, nCopy);
+        m_pCur += nCopy;
+        nDone  += nCopy;
+    }
+    return nDone;
+}
+
+bool
+CountReader::Next ()
+{
+    if (!Start() || m_fFailed)
+        return false;
+    if (!(m_pBinary ? NextBinary() : NextText()))
+    {
+        ReportInput();
+        return false;
+    }
+    if (m_pStats && m_nLinesRead % STATS_INPUT_BATCH == 0)
+        ReportInput();
+    if (m_fCheckSorted)
+    {
+        if (m_fHaveLastValue && 0 <= m_sLastValue.compare(Value))
+            return Fail(m_nLinesRead, "file not sorted");
+        m_sLastValue.assign(Value.data(), Value.size());
+        m_fHaveLastValue = true;
+    }
+    return true;
+}
+
+void
+CountReader::ReportInput ()
+{
+    if (!m_pStats)
+        return;
+    long long nBytes = BytesRead();
+    m_pStats->AddInput(m_nLinesRead - m_nLinesReported,
+                       nBytes - m_nBytesReported);
+    m_nLinesReported = m_nLinesRead;
+    m_nBytesReported = nBytes;
+}
+
+bool
+CountReader::NextText ()
+{
+    // find the end of the line, reading more input as needed; bytes
+    // already searched are not searched again
+    size_t      nScanned = 0;
+    const char *pNewline = 0;
+    while (true)
+    {
+        size_t nAvail = m_pEnd - m_pCur;
+        if (nScanned < nAvail)
+        {
+            pNewline = static_cast<const char *>(
+                memchr(m_pCur + nScanned, '\n', nAvail - nScanned));
+            if (pNewline)
+                break;
+        }
+        nScanned = nAvail;
+        if (!Fill())
+        {
+            if (m_fFailed || m_pCur == m_pEnd)
+                return false;
+            // a last line without a newline
+            pNewline = m_pEnd;
+            break;
+        }
+    }
+    const char *pLine = m_pCur;
+    m_pCur            = pNewline == m_pEnd ? m_pEnd : pNewline + 1;
+    m_nLinesRead     += 1;
+
+    const char *pTab = static_cast<const char *>(
+        memchr(pLine, '\t', pNewline - pLine));
+    if (pTab)
+    {
+        Value = string_view(pTab + 1, pNewline - pTab - 1);
+    }
+    else if (m_fAllowMissingTab)
+    {
+        Value = string_view(pNewline, 0);
+        pTab  = pNewline;
+    }
+    else
+    {
+        return Fail(m_nLinesRead, "no tab character found on line");
+    }
+    if (!ParseCountField(pLine, pTab, m_fFloatingPoint, nCount, nFloatCount))
+        return Fail(m_nLinesRead, "could not read count field");
+    return true;
+}
+
+bool
+CountReader::NextBinary ()
+{
+    bool fDidRead = m_pBinary->Next(Value, nCount, nFloatCount);
+    if (m_pBinary->Failed())
+        return Fail(m_nLinesRead + 1, "corrupt binary count file");
+    if (!fDidRead)
+        return false;
+    m_nLinesRead += 1;
+    if (m_fFloatingPoint && !m_pBinary->FloatingPoint())
+        nFloatCount = nCount;
+    return true;
+}
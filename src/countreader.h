@@ -0,0 +1,243 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countreader
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Fast reader for count files, shared by all the tools
+ *
+ * Description:
+ *    CountReader reads the records of a count file, text or binary, one
+ *    at a time.  Regular files are mapped into memory; anything else is
+ *    read in large blocks.  Text records are split with memchr (which
+ *    the C library implements with vector instructions), counts are
+ *    parsed with from_chars, and values are returned as string_views
+ *    into the buffer, so reading a record neither allocates nor copies.
+ *
+ *    The error messages are those of the ReadCountLine functions that
+ *    CountReader replaces, and line numbers are counted the same way.
+ *    A reader can also be set to read just a range of lines of an
+ *    already mapped text file, continuing the line numbering and the
+ *    sort-order check from the lines before the range.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - OpenRange(), SetLineNumber(), SetLastValue() and
+ *            SetQuiet(), for reading files in parallel pieces.
+ *          - IsMapped().
+ *          - SetStats() and BytesRead(), for --stats.
+ *
+ * \file countreader.h
+ */
+
+#ifndef COUNTREADER_H
+#define COUNTREADER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bincount.h"
+#include "inputfile.h"
+#include "toolstats.h"
+
+class CountReader : private ByteSource
+{
+public:
+    CountReader ();
+    ~CountReader ();
+
+    /**
+     * Opens sFileName, or standard input if it is "-".  Returns false
+     * (with errno set) if the file could not be opened.
+     */
+    bool Open ( const std::string &sFileName );
+
+    /**
+     * Reads the text count lines in [pBegin, pEnd), which must start at
+     * the beginning of a line and stay valid while they are read.
+     */
+    void OpenRange ( const char *pBegin,
+                     const char *pEnd );
+
+    /**
+     * Sets the number of lines before the first one to be read.
+     */
+    void
+    SetLineNumber ( int nLinesRead )
+    {
+        m_nLinesRead = nLinesRead;
+    }
+
+    /**
+     * Sets the value of the line before the first one to be read, for
+     * the sort-order check.
+     */
+    void
+    SetLastValue ( std::string_view LastValue )
+    {
+        m_sLastValue.assign(LastValue.data(), LastValue.size());
+        m_fHaveLastValue = true;
+    }
+
+    /**
+     * Fail without printing any message.
+     */
+    void
+    SetQuiet ( bool fQuiet )
+    {
+        m_fQuiet = fQuiet;
+    }
+
+    /**
+     * The name used in messages: the file name, or "<stdin>".  An empty
+     * name leaves messages with just the line number.
+     */
+    const std::string &
+    Name () const
+    {
+        return m_sName;
+    }
+
+    void
+    SetName ( const std::string &sName )
+    {
+        m_sName = sName;
+    }
+
+    /**
+     * Read counts as floating-point numbers, into nFloatCount.
+     */
+    void
+    SetFloatingPoint ( bool fFloatingPoint )
+    {
+        m_fFloatingPoint = fFloatingPoint;
+    }
+
+    /**
+     * Fail with "file not sorted" on a value that is not alphabetically
+     * after the previous one.
+     */
+    void
+    SetCheckSorted ( bool fCheckSorted )
+    {
+        m_fCheckSorted = fCheckSorted;
+    }
+
+    /**
+     * Read a text line without a tab as a count with an empty value,
+     * instead of failing.
+     */
+    void
+    SetAllowMissingTab ( bool fAllowMissingTab )
+    {
+        m_fAllowMissingTab = fAllowMissingTab;
+    }
+
+    /**
+     * Adds the records and bytes read to the input totals of pStats,
+     * in batches, and at the end of the input.
+     */
+    void
+    SetStats ( ToolStats *pStats )
+    {
+        m_pStats         = pStats;
+        m_nLinesReported = m_nLinesRead;
+    }
+
+    /**
+     * The number of (decompressed) bytes of input read so far.
+     */
+    long long
+    BytesRead () const
+    {
+        return m_nBytesTotal - (m_pEnd - m_pCur);
+    }
+
+    /**
+     * Returns true if the input is a mapped text file, whose Values
+     * stay valid for the life of the reader.
+     */
+    bool IsMapped ();
+
+    /**
+     * Returns true if the input is a binary count file.
+     */
+    bool IsBinary ();
+
+    /**
+     * Returns true if the input is a binary count file holding
+     * floating-point counts.
+     */
+    bool
+    IsFloatingPointBinary ()
+    {
+        return IsBinary() && m_pBinary->FloatingPoint();
+    }
+
+    /**
+     * Reads the next record into nCount (or nFloatCount) and Value;
+     * Value stays valid until the next call.  Returns false at the end
+     * of the input, or, after printing a message, on an error, in which
+     * case Failed() returns true.
+     */
+    bool Next ();
+
+    bool
+    Failed () const
+    {
+        return m_fFailed;
+    }
+
+    /**
+     * The number of the record last read, starting from one.
+     */
+    int
+    LineNumber () const
+    {
+        return m_nLinesRead;
+    }
+
+    long long        nCount;
+    double           nFloatCount;
+    std::string_view Value;
+
+private:
+    bool   Start ();
+    bool   Fill ();
+    bool   NextText ();
+    bool   NextBinary ();
+    bool   Fail ( int         nLine,
+                  const char *pMessage );
+    size_t Read ( char   *pData,
+                  size_t  nLength );
+    void   ReportInput ();
+
+    InputFile                          m_Input;
+    std::string                        m_sName;
+    bool                               m_fFloatingPoint;
+    bool                               m_fCheckSorted;
+    bool                               m_fAllowMissingTab;
+    bool                               m_fQuiet;
+    bool                               m_fStarted;
+    bool                               m_fFailed;
+    bool                               m_fEof;
+    int                                m_nLinesRead;
+    std::vector<char>                  m_Buffer;
+    const char                        *m_pCur;
+    const char                        *m_pEnd;
+    std::unique_ptr<BinaryCountReader> m_pBinary;
+    std::string                        m_sLastValue;
+    bool                               m_fHaveLastValue;
+    ToolStats                         *m_pStats;
+    long long                          m_nBytesTotal;
+    int                                m_nLinesReported;
+    long long                          m_nBytesReported;
+};
+
+#endif // COUNTREADER_H
@@ -0,0 +1,390 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countrun
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Sorted count runs: reading, spilling and merging
+ *
+ * Description:
+ *    Implementation of the run spiller and the k-way merge of sorted
+ *    count streams.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - CountFileStream reads through CountReader; ReadCountLine
+ *            is gone.
+ *          - Runs are written through OutputFile.
+ *          - Merge with a loser tree instead of a binary heap.
+ *          - CountFileStream can read a range of a mapped file.
+ *
+ * \file countrun.cpp
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include "countrun.h"
+using namespace std;
+
+bool
+ParseMemorySize ( const char *pArg,
+                  size_t     &nBytes )
+{
+    char               *pEnd;
+    unsigned long long  nValue = strtoull(pArg, &pEnd, 10);
+    if (pEnd == pArg)
+        return false;
+    switch (*pEnd)
+    {
+    case 'T': case 't':
+        nValue <<= 10;
+        // fall through
+    case 'G': case 'g':
+        nValue <<= 10;
+        // fall through
+    case 'M': case 'm':
+        nValue <<= 10;
+        // fall through
+    case 'K': case 'k':
+        nValue <<= 10;
+        pEnd++;
+        break;
+    case 'B': case 'b':
+        pEnd++;
+        break;
+    default:
+        break;
+    }
+    if (*pEnd != '\0' || nValue == 0)
+        return false;
+    nBytes = nValue;
+    return true;
+}
+
+CountFileStream::CountFileStream ( const string &sFileName,
+                                   bool          fFloatingPoint )
+    : m_fFloatingPoint(fFloatingPoint), m_fFailed(false)
+{
+    nCount      = 0;
+    nFloatCount = 0;
+    if (!m_Reader.Open(sFileName))
+    {
+        cerr << "ERROR: Could not open file " << sFileName << endl;
+        m_fFailed = true;
+    }
+    m_Reader.SetFloatingPoint(fFloatingPoint);
+    m_Reader.SetCheckSorted(true);
+}
+
+CountFileStream::CountFileStream ( const string &sFileName,
+                                   bool          fFloatingPoint,
+                                   const char   *pBegin,
+                                   const char   *pEnd )
+    : m_fFloatingPoint(fFloatingPoint), m_fFailed(false)
+{
+    nCount      = 0;
+    nFloatCount = 0;
+    m_Reader.OpenRange(pBegin, pEnd);
+    m_Reader.SetName(sFileName);
+    m_Reader.SetFloatingPoint(fFloatingPoint);
+    m_Reader.SetCheckSorted(true);
+}
+
+bool
+CountFileStream::Next ()
+{
+    if (m_fFailed)
+        return false;
+    if (!m_Reader.Next())
+    {
+        m_fFailed = m_Reader.Failed();
+        return false;
+    }
+    nCount      = m_Reader.nCount;
+    nFloatCount = m_Reader.nFloatCount;
+    Value       = m_Reader.Value;
+    return true;
+}
+
+RunSpiller::RunSpiller ( const string &sParentDir,
+                         bool          fFloatingPoint )
+    : m_sParentDir(sParentDir), m_fFloatingPoint(fFloatingPoint),
+      m_nNextRun(0)
+{
+    if (m_sParentDir.empty())
+    {
+        const char *pTmpDir = getenv("TMPDIR");
+        m_sParentDir = (pTmpDir && *pTmpDir) ? pTmpDir : "/tmp";
+    }
+}
+
+RunSpiller::~RunSpiller ()
+{
+    Remove();
+}
+
+bool
+RunSpiller::CreateRun ( string     &sRunName,
+                        OutputFile &runFile )
+{
+    {
+        lock_guard<mutex> lock(m_Mutex);
+        if (m_sDir.empty())
+        {
+            string sTemplate = m_sParentDir + "/count.XXXXXX";
+            if (!mkdtemp(&sTemplate[0]))
+            {
+                cerr << "ERROR: Could not create temporary directory in "
+                     << m_sParentDir << endl;
+                return false;
+            }
+            m_sDir = sTemplate;
+        }
+        ostringstream oss;
+        oss << m_sDir << "/run" << m_nNextRun++;
+        sRunName = oss.str();
+        m_Runs.push_back(sRunName);
+    }
+    if (!runFile.Open(sRunName))
+    {
+        cerr << "ERROR: Could not open file " << sRunName << endl;
+        return false;
+    }
+    // runs are read back exactly, so floating-point counts are written
+    // with every significant digit
+    if (m_fFloatingPoint)
+        runFile.SetPrecision(numeric_limits<double>::max_digits10);
+    return true;
+}
+
+bool
+RunSpiller::FinishRun ( const string &sRunName,
+                        OutputFile   &runFile )
+{
+    if (!runFile.Close())
+    {
+        cerr << "ERROR: Could not write temporary file " << sRunName << endl;
+        return false;
+    }
+    return true;
+}
+
+bool
+RunSpiller::Consolidate ( size_t nMaxRuns )
+{
+    while (m_Runs.size() > nMaxRuns)
+    {
+        size_t nMerge = min(MAX_MERGE_FAN_IN, m_Runs.size() - nMaxRuns + 1);
+        vector<string> Inputs(m_Runs.begin(), m_Runs.begin() + nMerge);
+        m_Runs.erase(m_Runs.begin(), m_Runs.begin() + nMerge);
+
+        vector<CountStream *> Streams;
+        for ( size_t i = 0; i < Inputs.size(); i++ )
+            Streams.push_back(new CountFileStream(Inputs[i],
+                                                  m_fFloatingPoint));
+        string     sRunName;
+        OutputFile runFile;
+        bool       fOk = CreateRun(sRunName, runFile);
+        if (fOk)
+        {
+            bool fFloatingPoint = m_fFloatingPoint;
+            fOk = MergeCountStreams(
+                Streams, fFloatingPoint,
+                [fFloatingPoint, &runFile](long long nCount,
+                                           double nFloatCount,
+                                           string_view Value)
+                {
+                    if (fFloatingPoint)
+                        runFile.WriteRecord(nFloatCount, Value);
+                    else
+                        runFile.WriteRecord(nCount, Value);
+                });
+            fOk = FinishRun(sRunName, runFile) && fOk;
+        }
+        for ( size_t i = 0; i < Streams.size(); i++ )
+            delete Streams[i];
+        for ( size_t i = 0; i < Inputs.size(); i++ )
+            unlink(Inputs[i].c_str());
+        if (!fOk)
+            return false;
+    }
+    return true;
+}
+
+void
+RunSpiller::Remove ()
+{
+    lock_guard<mutex> lock(m_Mutex);
+    for ( size_t i = 0; i < m_Runs.size(); i++ )
+        unlink(m_Runs[i].c_str());
+    m_Runs.clear();
+    if (!m_sDir.empty())
+        rmdir(m_sDir.c_str());
+    m_sDir.clear();
+}
+
+/**
+ * A tournament tree of losers over a set of sorted count streams.  Each
+ * internal node holds the stream that lost the match played there, and
+ * the overall winner (the stream with the smallest current value) is
+ * kept at the root.  When the winner advances, only the matches on the
+ * path from its leaf to the root are replayed: log2(N) comparisons,
+ * against about twice that for a binary heap.
+ */
+class LoserTree
+{
+public:
+    explicit LoserTree ( const vector<CountStream *> &Streams )
+        : m_Streams(Streams), m_nStreams(Streams.size()),
+          m_Tree(max<size_t>(m_nStreams, 1)), m_fDone(m_nStreams, false)
+    {
+    }
+
+    /**
+     * Reads the first record of every stream and plays the initial
+     * tournament.  Returns false if a stream failed.
+     */
+    bool
+    Start ()
+    {
+        for ( size_t i = 0; i < m_nStreams; i++ )
+        {
+            if (!m_Streams[i]->Next())
+            {
+                if (m_Streams[i]->Failed())
+                    return false;
+                m_fDone[i] = true;
+            }
+        }
+        if (m_nStreams == 0)
+        {
+            m_Tree[0] = 0;
+            return true;
+        }
+        // the leaves are at positions N to 2N - 1 of the implicit tree
+        vector<size_t> Winners(2 * m_nStreams);
+        for ( size_t i = 0; i < m_nStreams; i++ )
+            Winners[m_nStreams + i] = i;
+        for ( size_t nNode = m_nStreams - 1; nNode > 0; nNode-- )
+        {
+            size_t nA = Winners[2 * nNode];
+            size_t nB = Winners[2 * nNode + 1];
+            if (Before(nB, nA))
+                swap(nA, nB);
+            Winners[nNode] = nA;
+            m_Tree[nNode]  = nB;
+        }
+        m_Tree[0] = m_nStreams == 1 ? 0 : Winners[1];
+        return true;
+    }
+
+    /**
+     * Returns true once every stream is exhausted.
+     */
+    bool
+    Empty () const
+    {
+        return m_nStreams == 0 || m_fDone[m_Tree[0]];
+    }
+
+    CountStream *
+    Top () const
+    {
+        return m_Streams[m_Tree[0]];
+    }
+
+    /**
+     * Advances the winning stream and replays its matches.  Returns
+     * false if the stream failed.
+     */
+    bool
+    Advance ()
+    {
+        size_t nWinner = m_Tree[0];
+        if (!m_Streams[nWinner]->Next())
+        {
+            if (m_Streams[nWinner]->Failed())
+                return false;
+            m_fDone[nWinner] = true;
+        }
+        for ( size_t nNode = (nWinner + m_nStreams) / 2; nNode > 0;
+              nNode /= 2 )
+        {
+            if (Before(m_Tree[nNode], nWinner))
+                swap(m_Tree[nNode], nWinner);
+        }
+        m_Tree[0] = nWinner;
+        return true;
+    }
+
+private:
+    /**
+     * Exhausted streams lose every match; equal values are won by the
+     * earlier stream.
+     */
+    bool
+    Before ( size_t nA,
+             size_t nB ) const
+    {
+        if (m_fDone[nA] || m_fDone[nB])
+            return !m_fDone[nA] && (m_fDone[nB] || nA < nB);
+        int nCompare = m_Streams[nA]->Value.compare(m_Streams[nB]->Value);
+        return nCompare < 0 || (nCompare == 0 && nA < nB);
+    }
+
+    const vector<CountStream *> &m_Streams;
+    size_t                       m_nStreams;
+    vector<size_t>               m_Tree;
+    vector<bool>                 m_fDone;
+};
+
+bool
+MergeCountStreams ( const vector<CountStream *> &Streams,
+                    bool                         fFloatingPoint,
+                    const function<void(long long,
+                                        double,
+                                        string_view)> &Output )
+{
+    LoserTree Tree(Streams);
+    if (!Tree.Start())
+        return false;
+
+    string sValue;
+    while (!Tree.Empty())
+    {
+        sValue.assign(Tree.Top()->Value);
+        long long nCount      = 0;
+        double    nFloatCount = 0;
+        auto      Emit        = [&]()
+        {
+            if (fFloatingPoint)
+                Output(0, nFloatCount, sValue);
+            else
+                Output(nCount, 0, sValue);
+        };
+        while (!Tree.Empty() && Tree.Top()->Value.compare(sValue) == 0)
+        {
+            nCount      += Tree.Top()->nCount;
+            nFloatCount += Tree.Top()->nFloatCount;
+            if (!Tree.Advance())
+            {
+                // everything before the bad record is still output,
+                // as addcount always has
+                Emit();
+                return false;
+            }
+        }
+        Emit();
+    }
+    return true;
+}
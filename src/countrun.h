@@ -0,0 +1,325 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countrun
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Sorted count runs: reading, spilling and merging
+ *
+ * Description:
+ *    Support for counting more distinct values than fit in memory.
+ *    When a counting table reaches its memory budget, a RunSpiller
+ *    writes it out to a temporary directory as a sorted run (an
+ *    ordinary count file) and empties it.  At the end of the input,
+ *    MergeCountStreams() merges the runs, together with whatever is
+ *    left in the table, summing the counts of equal values exactly as
+ *    addcount does for its sorted input files.  If there are too many
+ *    runs to merge at once, the oldest are first merged together into
+ *    larger runs.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - ReadCountLine replaced by CountReader.
+ *          - Runs are written through OutputFile.
+ *          - MergeCountStreams() uses a loser tree, and also serves
+ *            addcount's N-way merge.
+ *          - CountFileStream over a range of a mapped file.
+ *          - CreateRun() and FinishRun() are public, for runs in other
+ *            orders (see countorder.h).
+ *          - TrieStream, and Spill() of a TrieCountTable.
+ *
+ * \file countrun.h
+ */
+
+#ifndef COUNTRUN_H
+#define COUNTRUN_H
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "countreader.h"
+#include "counttable.h"
+#include "outputfile.h"
+#include "trietable.h"
+
+/**
+ * Parses a memory size such as "512M" or "4G" (the suffixes K, M, G and
+ * T are powers of 1024; a bare number is in bytes).
+ */
+bool ParseMemorySize ( const char *pArg,
+                       size_t     &nBytes );
+
+/**
+ * The memory budget of each of nTables tables sharing nBudget bytes.
+ * Very small budgets are rounded up, since an empty table already
+ * takes some memory and would otherwise spill after every insertion.
+ */
+inline size_t
+TableBudget ( size_t nBudget,
+              size_t nTables )
+{
+    return std::max<size_t>(256 << 10, nBudget / nTables);
+}
+
+/**
+ * The arena block size to use for a table kept within nBudget bytes:
+ * small enough that a single block does not use up the budget.
+ */
+inline size_t
+ArenaBlockSizeForBudget ( size_t nBudget )
+{
+    return std::max<size_t>(4096, std::min<size_t>(1 << 20, nBudget / 16));
+}
+
+/**
+ * A stream of count records in alphabetical order of value.
+ */
+class CountStream
+{
+public:
+    virtual ~CountStream () {}
+
+    /**
+     * Advances to the next record.  Returns false at the end of the
+     * stream, or on an error, in which case Failed() returns true.
+     */
+    virtual bool Next () = 0;
+
+    virtual bool
+    Failed () const
+    {
+        return false;
+    }
+
+    long long        nCount;
+    double           nFloatCount;
+    std::string_view Value;
+};
+
+/**
+ * Reads a sorted count file.
+ */
+class CountFileStream : public CountStream
+{
+public:
+    CountFileStream ( const std::string &sFileName,
+                      bool               fFloatingPoint );
+
+    /**
+     * Reads just the text count lines in [pBegin, pEnd) of a file that
+     * is already in memory; sFileName is used in messages.
+     */
+    CountFileStream ( const std::string &sFileName,
+                      bool               fFloatingPoint,
+                      const char        *pBegin,
+                      const char        *pEnd );
+
+    bool Next ();
+
+    bool
+    Failed () const
+    {
+        return m_fFailed;
+    }
+
+    /**
+     * The underlying reader, for setting the line number and sort
+     * state at the start of a range.
+     */
+    CountReader &
+    Reader ()
+    {
+        return m_Reader;
+    }
+
+private:
+    CountReader m_Reader;
+    bool        m_fFloatingPoint;
+    bool        m_fFailed;
+};
+
+/**
+ * Walks the entries of a counting table in alphabetical order.
+ */
+template<typename TCount>
+class TableStream : public CountStream
+{
+public:
+    explicit TableStream ( const HashCountTable<TCount> &table )
+        : m_nNext(0)
+    {
+        table.SortedEntries(m_Entries);
+    }
+
+    bool
+    Next ()
+    {
+        if (m_nNext >= m_Entries.size())
+            return false;
+        const typename HashCountTable<TCount>::Entry *pEntry =
+            m_Entries[m_nNext++];
+        nCount      = static_cast<long long>(pEntry->nCount);
+        nFloatCount = static_cast<double>(pEntry->nCount);
+        Value       = pEntry->Key();
+        return true;
+    }
+
+private:
+    std::vector<const typename HashCountTable<TCount>::Entry *> m_Entries;
+    size_t                                                      m_nNext;
+};
+
+/**
+ * Walks the entries of a trie table in alphabetical order.
+ */
+template<typename TCount>
+class TrieStream : public CountStream
+{
+public:
+    explicit TrieStream ( const TrieCountTable<TCount> &table )
+        : m_Cursor(table)
+    {
+    }
+
+    bool
+    Next ()
+    {
+        if (!m_Cursor.Next())
+            return false;
+        nCount      = static_cast<long long>(m_Cursor.Count());
+        nFloatCount = static_cast<double>(m_Cursor.Count());
+        Value       = m_Cursor.Key();
+        return true;
+    }
+
+private:
+    typename TrieCountTable<TCount>::Cursor m_Cursor;
+};
+
+/**
+ * Writes full tables to sorted run files in a private temporary
+ * directory, which is removed (with the runs) on destruction.  Spill()
+ * may be called from several threads at once.
+ */
+class RunSpiller
+{
+public:
+    /**
+     * The run directory is created, when first needed, under
+     * sParentDir; an empty sParentDir means $TMPDIR, or /tmp.
+     */
+    RunSpiller ( const std::string &sParentDir,
+                 bool               fFloatingPoint );
+    ~RunSpiller ();
+
+    /**
+     * Writes the contents of table to a new run and clears the table.
+     * Returns false, after printing a message, if the run could not be
+     * written.
+     */
+    template<typename TCount>
+    bool
+    Spill ( HashCountTable<TCount> &table )
+    {
+        std::vector<const typename HashCountTable<TCount>::Entry *> Entries;
+        table.SortedEntries(Entries);
+        std::string sRunName;
+        OutputFile  runFile;
+        if (!CreateRun(sRunName, runFile))
+            return false;
+        for ( size_t i = 0; i < Entries.size(); i++ )
+            runFile.WriteRecord(Entries[i]->nCount, Entries[i]->Key());
+        table.Clear();
+        return FinishRun(sRunName, runFile);
+    }
+
+    /**
+     * Writes the contents of a trie table to a new run and clears the
+     * table, as above.
+     */
+    template<typename TCount>
+    bool
+    Spill ( TrieCountTable<TCount> &table )
+    {
+        std::string sRunName;
+        OutputFile  runFile;
+        if (!CreateRun(sRunName, runFile))
+            return false;
+        typename TrieCountTable<TCount>::Cursor cursor(table);
+        while (cursor.Next())
+            runFile.WriteRecord(cursor.Count(), cursor.Key());
+        table.Clear();
+        return FinishRun(sRunName, runFile);
+    }
+
+    /**
+     * Names of the runs written so far, in the order they were written.
+     */
+    const std::vector<std::string> &
+    Runs () const
+    {
+        return m_Runs;
+    }
+
+    /**
+     * Merges the oldest runs together until at most nMaxRuns remain, so
+     * that the final merge never needs too many open files.  Returns
+     * false, after printing a message, on failure.
+     */
+    bool Consolidate ( size_t nMaxRuns );
+
+    /**
+     * Removes all runs and the run directory.
+     */
+    void Remove ();
+
+    /**
+     * Opens runFile as a new run named sRunName, which is added to
+     * Runs().  Returns false, after printing a message, on failure.
+     */
+    bool CreateRun ( std::string &sRunName,
+                     OutputFile  &runFile );
+
+    /**
+     * Closes a run opened by CreateRun().  Returns false, after
+     * printing a message, if it could not be written.
+     */
+    bool FinishRun ( const std::string &sRunName,
+                     OutputFile        &runFile );
+
+private:
+
+    std::string              m_sParentDir;
+    std::string              m_sDir;
+    bool                     m_fFloatingPoint;
+    std::mutex               m_Mutex;
+    std::vector<std::string> m_Runs;
+    size_t                   m_nNextRun;
+};
+
+/**
+ * The largest number of runs merged in a single pass.
+ */
+const size_t MAX_MERGE_FAN_IN = 64;
+
+/**
+ * Merges the sorted Streams, summing the counts of equal values, and
+ * calls Output with each resulting record in alphabetical order.  The
+ * merge is a single pass through a loser tree, costing O(log N)
+ * comparisons per record for N streams.  Returns false if any stream
+ * failed.
+ */
+bool MergeCountStreams ( const std::vector<CountStream *> &Streams,
+                         bool                              fFloatingPoint,
+                         const std::function<void(long long,
+                                                  double,
+                                                  std::string_view)> &Output );
+
+#endif // COUNTRUN_H
@@ -0,0 +1,242 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          countstore
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Maintains a persistent count store
+ *
+ * Description:
+ *    countstore adds count files to a count store (see runstore.h),
+ *    looks up the total counts of values in it, and writes out all of
+ *    its counts in alphabetical order.  Adding a count file writes it
+ *    into the store as a new run, without rewriting what is already
+ *    there, and then compacts the store in the background.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Add -z to compress the output.
+ *          - -c waits for a compaction already running to finish.
+ *
+ * \file countstore.cpp
+ */
+
+//#define DEBUG
+
+#include "config.h"
+#include <getopt.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bincount.h"
+#include "compression.h"
+#include "countrun.h"
+#include "outputfile.h"
+#include "runstore.h"
+using namespace std;
+
+void
+printHelp()
+{
+    cout << "countstore - " << PACKAGE_STRING << endl << endl;
+    cout << "countstore maintains a count store: a directory STORE holding counts" << endl;
+    cout << "that are added to over time, such as all-time totals that are updated" << endl;
+    cout << "every hour.  Adding counts to the store (with -a, or with count --update)" << endl;
+    cout << "writes them as a new sorted run, without rewriting the rest of the" << endl;
+    cout << "store; runs are merged together into larger runs in the background as" << endl;
+    cout << "they accumulate.  The runs are ordinary sorted count files." << endl;
+    cout << endl;
+    cout << "By default, countstore writes every value in STORE with its total count" << endl;
+    cout << "to standard output, in alphabetical order, as addcount would for all" << endl;
+    cout << "of the count files ever added to it." << endl;
+    cout << endl;
+    cout << "Syntax:" << endl;
+    cout << endl;
+    cout << "   countstore [OPTIONS] STORE [VALUE...]" << endl;
+    cout << endl;
+    cout << "Options:" << endl;
+    cout << endl;
+    cout << "   -a FILE add the sorted count file FILE (\"-\" for standard input)" << endl;
+    cout << "           to STORE, creating STORE if it does not exist" << endl;
+    cout << "   -b      write a binary count file (see countconv)" << endl;
+    cout << "   -c      compact STORE now, waiting until it is done" << endl;
+    cout << "   -i      list the runs of STORE: level, size in bytes and file name" << endl;
+    cout << "   -l      print the total count of each VALUE (or of each line of" << endl;
+    cout << "           standard input, if no VALUE is given); values not in STORE" << endl;
+    cout << "           have a count of 0" << endl;
+    cout << "   -z FORMAT" << endl;
+    cout << "           compress the output with FORMAT: gzip, xz or zstd" << endl;
+    cout << "   -?      display this help message" << endl;
+}
+
+/**
+ * Writes the sorted count file sFileName into the store as a new run.
+ */
+bool
+addCounts ( CountStore   &store,
+            const string &sFileName )
+{
+    CountFileStream input(sFileName, false);
+    if (input.Failed())
+        return false;
+    string     sRunName;
+    OutputFile output;
+    if (!store.CreateRun(sRunName, output))
+        return false;
+    vector<CountStream *> Inputs(1, &input);
+    bool fOk = MergeCountStreams(
+        Inputs, false,
+        [&output](long long nCount, double, string_view Value)
+        {
+            output.WriteRecord(nCount, Value);
+        });
+    if (!output.Close() && fOk)
+    {
+        cerr << "ERROR: Could not write file " << output.Name() << endl;
+        fOk = false;
+    }
+    if (!fOk || !store.CommitRun(sRunName))
+    {
+        store.AbortRun(sRunName);
+        return false;
+    }
+    return true;
+}
+
+int main ( int argc, char **argv )
+{
+    string     sAddFileName        = "";
+    bool       fBinaryOutput       = false;
+    bool       fCompact            = false;
+    bool       fInfo               = false;
+    bool       fLookup             = false;
+    Compression OutputCompression  = COMPRESSION_NONE;
+    int        c;
+    while ((c = getopt(argc, argv, "a:bcilz:?")) != -1)
+    {
+        switch(c)
+        {
+        case 'a':
+            sAddFileName = optarg;
+            break;
+        case 'b':
+            fBinaryOutput = true;
+            break;
+        case 'c':
+            fCompact = true;
+            break;
+        case 'i':
+            fInfo = true;
+            break;
+        case 'l':
+            fLookup = true;
+            break;
+        case 'z':
+            if (!ParseCompression(optarg, OutputCompression))
+                exit(1);
+            break;
+        case '?':
+            printHelp();
+            exit(1);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if ((argc - optind) < 1)
+    {
+        cerr << "ERROR: Missing store argument." << endl;
+        printHelp();
+        exit(1);
+    }
+    CountStore store(argv[optind++]);
+    if (!store.Open(!sAddFileName.empty()))
+        exit(1);
+
+    if (!sAddFileName.empty())
+    {
+        if (!addCounts(store, sAddFileName))
+            exit(1);
+        if (!fCompact)
+            store.CompactInBackground();
+    }
+    if (fCompact && !store.Compact(true))
+        exit(1);
+    if (fCompact || !sAddFileName.empty())
+        return 0;
+
+    OutputFile output;
+    if (!output.Open("-", OutputCompression))
+        exit(1);
+    if (fInfo)
+    {
+        vector<StoreRun> Runs;
+        if (!store.ReadManifest(Runs))
+            exit(1);
+        for ( size_t i = 0; i < Runs.size(); i++ )
+        {
+            struct stat st;
+            string      sPath = string(argv[optind - 1]) + "/" + Runs[i].sName;
+            output.WriteNumber(static_cast<long long>(Runs[i].nLevel));
+            output.Put('\t');
+            output.WriteNumber(static_cast<long long>(
+                stat(sPath.c_str(), &st) == 0 ? st.st_size : 0));
+            output.Put('\t');
+            output.Write(Runs[i].sName);
+            output.Put('\n');
+        }
+    }
+    else if (fLookup)
+    {
+        vector<string> Keys(argv + optind, argv + argc);
+        if (Keys.empty())
+        {
+            string sLine;
+            while (getline(cin, sLine))
+                Keys.push_back(sLine);
+        }
+        vector<long long> Counts;
+        if (!store.Lookup(Keys, Counts))
+            exit(1);
+        for ( size_t i = 0; i < Keys.size(); i++ )
+            output.WriteRecord(Counts[i], Keys[i]);
+    }
+    else
+    {
+        BinaryCountWriter *binaryOutput = 0;
+        if (fBinaryOutput)
+            binaryOutput = new BinaryCountWriter(output, false);
+        bool fOk = store.Scan(
+            [&output, binaryOutput](long long nCount, string_view Value)
+            {
+                if (binaryOutput)
+                    binaryOutput->Write(Value, nCount, 0);
+                else
+                    output.WriteRecord(nCount, Value);
+            });
+        if (!fOk)
+        {
+            delete binaryOutput;
+            output.Close();
+            exit(1);
+        }
+        if (binaryOutput)
+            binaryOutput->Finish();
+        delete binaryOutput;
+    }
+
+    if (!output.Close())
+    {
+        cerr << "ERROR: Could not write to standard output" << endl;
+        exit(1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,532 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          counttable
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Arena-backed open-addressing hash table for counting
+ *
+ * Description:
+ *    HashCountTable maps byte-string keys to counts.  The table itself
+ *    is a flat power-of-two array of slots holding the key's hash, a
+ *    pointer to the key bytes, the key length and the count; collisions
+ *    are resolved by linear probing.  Key bytes are copied into a
+ *    KeyArena, which hands out memory from large blocks that are never
+ *    moved, so inserting a new key costs no individual heap allocation
+ *    and rehashing never touches the key bytes.  The table is unordered;
+ *    callers that need alphabetical output sort an index of the entries
+ *    once, after all the input has been counted.
+ *
+ *    Keys whose bytes are known to outlive the table (for instance,
+ *    lines of a memory-mapped input file) can be added with
+ *    AddBorrowed(), in which case the table points straight at the
+ *    caller's bytes and nothing is copied.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Borrowed (uncopied) keys; Absorb() to merge tables
+ *            without copying key bytes.
+ *          - Clear() releases memory, for spilling to disk.
+ *          - TopEntries() for exact top-K selection.
+ *          - SelectTopEntries() shared with SortCountTable.
+ *          - Capacity(), for --stats.
+ *          - Find(), and Prefetch() for batches of insertions.
+ *          - Retain(), to filter a table in place.
+ *
+ * \file counttable.h
+ */
+
+#ifndef COUNTTABLE_H
+#define COUNTTABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * Allocates key bytes from large blocks.  Pointers returned by Store()
+ * stay valid until Clear() is called or the arena is destroyed.
+ */
+class KeyArena
+{
+public:
+    explicit KeyArena ( size_t nBlockSize = 1 << 20 )
+        : m_pCur(0), m_nLeft(0), m_nBlockSize(nBlockSize),
+          m_nBytesAllocated(0)
+    {
+    }
+
+    const char *
+    Store ( const char *pData,
+            size_t      nLength )
+    {
+        if (nLength > m_nLeft)
+        {
+            // keys longer than a block get a block of their own, so
+            // that a single huge line does not waste the rest of the
+            // current block
+            size_t nSize = std::max(nLength, m_nBlockSize);
+            m_Blocks.emplace_back(new char[nSize]);
+            m_nBytesAllocated += nSize;
+            if (nSize > m_nBlockSize)
+            {
+                char *pBlock = m_Blocks.back().get();
+                memcpy(pBlock, pData, nLength);
+                return pBlock;
+            }
+            m_pCur  = m_Blocks.back().get();
+            m_nLeft = nSize;
+        }
+        char *pKey = m_pCur;
+        memcpy(pKey, pData, nLength);
+        m_pCur  += nLength;
+        m_nLeft -= nLength;
+        return pKey;
+    }
+
+    /**
+     * Takes over all of the blocks of other, which is left empty.
+     * Pointers into other's blocks remain valid.
+     */
+    void
+    Adopt ( KeyArena &other )
+    {
+        for (std::unique_ptr<char[]> &pBlock : other.m_Blocks)
+            m_Blocks.push_back(std::move(pBlock));
+        m_nBytesAllocated += other.m_nBytesAllocated;
+        other.Clear();
+    }
+
+    void
+    Clear ()
+    {
+        m_Blocks.clear();
+        m_pCur            = 0;
+        m_nLeft           = 0;
+        m_nBytesAllocated = 0;
+    }
+
+    size_t
+    BytesAllocated () const
+    {
+        return m_nBytesAllocated;
+    }
+
+    /**
+     * Sets the size of the blocks allocated from now on.
+     */
+    void
+    SetBlockSize ( size_t nBlockSize )
+    {
+        m_nBlockSize = nBlockSize;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]> > m_Blocks;
+    char                                 *m_pCur;
+    size_t                                m_nLeft;
+    size_t                                m_nBlockSize;
+    size_t                                m_nBytesAllocated;
+};
+
+/**
+ * Hashes a byte string eight bytes at a time.
+ */
+inline uint64_t
+HashKey ( const char *pData,
+          size_t      nLength )
+{
+    const uint64_t nMul  = 0x9E3779B97F4A7C15ULL;
+    uint64_t       nHash = nLength * nMul;
+    while (nLength >= 8)
+    {
+        uint64_t nWord;
+        memcpy(&nWord, pData, 8);
+        nHash    = (nHash ^ nWord) * nMul;
+        nHash   ^= nHash >> 29;
+        pData   += 8;
+        nLength -= 8;
+    }
+    if (nLength > 0)
+    {
+        uint64_t nWord = 0;
+        memcpy(&nWord, pData, nLength);
+        nHash  = (nHash ^ nWord) * nMul;
+        nHash ^= nHash >> 29;
+    }
+    nHash ^= nHash >> 32;
+    nHash *= 0xD6E8FEB86659FD93ULL;
+    nHash ^= nHash >> 32;
+    return nHash;
+}
+
+/**
+ * Orders keys the same way std::string::compare does: bytewise as
+ * unsigned characters, with a proper prefix sorting first.
+ */
+inline int
+CompareKeys ( const char *pKey1,
+              size_t      nLength1,
+              const char *pKey2,
+              size_t      nLength2 )
+{
+    int nCompare = memcmp(pKey1, pKey2, std::min(nLength1, nLength2));
+    if (nCompare != 0)
+        return nCompare;
+    if (nLength1 < nLength2)
+        return -1;
+    return nLength1 > nLength2 ? 1 : 0;
+}
+
+/**
+ * Reorders Entries, pointers to entries with pKey, nLength and nCount
+ * members, into order of descending count, with equal counts in
+ * alphabetical order of key, keeping only the first nK (or all of
+ * them, if nK is zero).  Only the selected entries are fully sorted.
+ */
+template<typename TEntry>
+void
+SelectTopEntries ( size_t                       nK,
+                   std::vector<const TEntry *> &Entries )
+{
+    auto fnBefore = [](const TEntry *pA, const TEntry *pB)
+    {
+        if (pA->nCount != pB->nCount)
+            return pA->nCount > pB->nCount;
+        return CompareKeys(pA->pKey, pA->nLength,
+                           pB->pKey, pB->nLength) < 0;
+    };
+    if (nK == 0 || nK >= Entries.size())
+    {
+        std::sort(Entries.begin(), Entries.end(), fnBefore);
+        return;
+    }
+    std::nth_element(Entries.begin(), Entries.begin() + nK,
+                     Entries.end(), fnBefore);
+    Entries.resize(nK);
+    std::sort(Entries.begin(), Entries.end(), fnBefore);
+}
+
+template<typename TCount>
+class HashCountTable
+{
+public:
+    struct Entry
+    {
+        uint64_t    nHash;
+        const char *pKey;
+        uint32_t    nLength;
+        TCount      nCount;
+
+        std::string_view
+        Key () const
+        {
+            return std::string_view(pKey, nLength);
+        }
+    };
+
+    explicit HashCountTable ( size_t nInitialCapacity = 1024 )
+        : m_nInitialCapacity(16), m_nSize(0)
+    {
+        while (m_nInitialCapacity < nInitialCapacity)
+            m_nInitialCapacity <<= 1;
+        m_Slots.assign(m_nInitialCapacity, Entry());
+        m_nMask = m_nInitialCapacity - 1;
+    }
+
+    /**
+     * Adds nDelta to the count of the given key, inserting the key
+     * (with a copy of its bytes in the arena) if it is not yet present.
+     */
+    void
+    Add ( const char *pKey,
+          size_t      nLength,
+          TCount      nDelta = 1 )
+    {
+        Add(pKey, nLength, HashKey(pKey, nLength), nDelta);
+    }
+
+    /**
+     * Like Add(), but stores a pointer to the caller's key bytes rather
+     * than a copy; they must stay valid for the life of the table.
+     */
+    void
+    AddBorrowed ( const char *pKey,
+                  size_t      nLength,
+                  TCount      nDelta = 1 )
+    {
+        Add(pKey, nLength, HashKey(pKey, nLength), nDelta, false);
+    }
+
+    void
+    Add ( const char *pKey,
+          size_t      nLength,
+          uint64_t    nHash,
+          TCount      nDelta,
+          bool        fCopyKey = true )
+    {
+        size_t nSlot = nHash & m_nMask;
+        while (m_Slots[nSlot].pKey)
+        {
+            Entry &entry = m_Slots[nSlot];
+            if (entry.nHash == nHash && entry.nLength == nLength &&
+                memcmp(entry.pKey, pKey, nLength) == 0)
+            {
+                entry.nCount += nDelta;
+                return;
+            }
+            nSlot = (nSlot + 1) & m_nMask;
+        }
+        Entry &entry  = m_Slots[nSlot];
+        entry.nHash   = nHash;
+        if (nLength == 0)
+            entry.pKey = EmptyKey();
+        else if (fCopyKey)
+            entry.pKey = m_Arena.Store(pKey, nLength);
+        else
+            entry.pKey = pKey;
+        entry.nLength = nLength;
+        entry.nCount  = nDelta;
+        if (++m_nSize * 4 > m_Slots.size() * 3)
+            Grow();
+    }
+
+    /**
+     * Starts loading the slot where the key with hash nHash would
+     * begin its probe, so that a batch of keys can be hashed first and
+     * then inserted without waiting on each slot in turn.
+     */
+    void
+    Prefetch ( uint64_t nHash ) const
+    {
+        __builtin_prefetch(&m_Slots[nHash & m_nMask]);
+    }
+
+    /**
+     * The entry of the given key, or null if it is not in the table.
+     * The pointer is invalidated by the next insertion.
+     */
+    const Entry *
+    Find ( const char *pKey,
+           size_t      nLength ) const
+    {
+        uint64_t nHash = HashKey(pKey, nLength);
+        size_t   nSlot = nHash & m_nMask;
+        while (m_Slots[nSlot].pKey)
+        {
+            const Entry &entry = m_Slots[nSlot];
+            if (entry.nHash == nHash && entry.nLength == nLength &&
+                memcmp(entry.pKey, pKey, nLength) == 0)
+                return &entry;
+            nSlot = (nSlot + 1) & m_nMask;
+        }
+        return 0;
+    }
+
+    /**
+     * Adds all of the counts in other to this table.
+     */
+    void
+    Merge ( const HashCountTable &other )
+    {
+        for (const Entry &entry : other.m_Slots)
+        {
+            if (entry.pKey)
+                Add(entry.pKey, entry.nLength, entry.nHash, entry.nCount);
+        }
+    }
+
+    /**
+     * Adds all of the counts in other to this table, taking over its
+     * key storage instead of copying the keys; other is left empty.
+     */
+    void
+    Absorb ( HashCountTable &other )
+    {
+        m_Arena.Adopt(other.m_Arena);
+        for (const Entry &entry : other.m_Slots)
+        {
+            if (entry.pKey)
+                Add(entry.pKey, entry.nLength, entry.nHash, entry.nCount,
+                    false);
+        }
+        other.Clear();
+    }
+
+    /**
+     * Fills Entries with pointers to every entry in the table, sorted
+     * in alphabetical order of key.  The pointers are invalidated by
+     * the next insertion.
+     */
+    void
+    SortedEntries ( std::vector<const Entry *> &Entries ) const
+    {
+        Entries.clear();
+        Entries.reserve(m_nSize);
+        for (const Entry &entry : m_Slots)
+        {
+            if (entry.pKey)
+                Entries.push_back(&entry);
+        }
+        std::sort(Entries.begin(), Entries.end(),
+                  [](const Entry *pA, const Entry *pB)
+                  {
+                      return CompareKeys(pA->pKey, pA->nLength,
+                                         pB->pKey, pB->nLength) < 0;
+                  });
+    }
+
+    /**
+     * Fills Entries with pointers to the nK entries with the highest
+     * counts (or to all entries, if nK is zero), in order of descending
+     * count, with equal counts in alphabetical order of key.  Only the
+     * selected entries are fully sorted, and no keys are copied.  The
+     * pointers are invalidated by the next insertion.
+     */
+    void
+    TopEntries ( size_t                      nK,
+                 std::vector<const Entry *> &Entries ) const
+    {
+        Entries.clear();
+        Entries.reserve(m_nSize);
+        for (const Entry &entry : m_Slots)
+        {
+            if (entry.pKey)
+                Entries.push_back(&entry);
+        }
+        SelectTopEntries(nK, Entries);
+    }
+
+    size_t
+    size () const
+    {
+        return m_nSize;
+    }
+
+    /**
+     * The number of slots in the table.
+     */
+    size_t
+    Capacity () const
+    {
+        return m_Slots.size();
+    }
+
+    /**
+     * Approximate number of bytes held by the table and its arena.
+     */
+    size_t
+    MemoryUsage () const
+    {
+        return m_Slots.size() * sizeof(Entry) + m_Arena.BytesAllocated();
+    }
+
+    /**
+     * Sets the size of the blocks in which key bytes are allocated.
+     * Tables kept under a small memory budget want smaller blocks.
+     */
+    void
+    SetArenaBlockSize ( size_t nBlockSize )
+    {
+        m_Arena.SetBlockSize(nBlockSize);
+    }
+
+    /**
+     * Removes, in place, every entry for which Keep(entry) is false.
+     * The copies of the removed keys are only released by Clear().
+     */
+    template<typename TKeep>
+    void
+    Retain ( TKeep Keep )
+    {
+        for ( size_t nSlot = 0; nSlot < m_Slots.size(); nSlot++ )
+        {
+            // the slot is checked again, as Remove() fills it with a
+            // later entry of its cluster
+            while (m_Slots[nSlot].pKey && !Keep(m_Slots[nSlot]))
+                Remove(nSlot);
+        }
+    }
+
+    /**
+     * Removes every entry, releasing the key storage and shrinking the
+     * slot array back to its initial capacity.
+     */
+    void
+    Clear ()
+    {
+        std::vector<Entry>(m_nInitialCapacity, Entry()).swap(m_Slots);
+        m_nMask = m_nInitialCapacity - 1;
+        m_Arena.Clear();
+        m_nSize = 0;
+    }
+
+private:
+    static const char *
+    EmptyKey ()
+    {
+        // the empty key needs a non-null pointer, since a null pointer
+        // marks an unused slot
+        static const char cEmpty = 0;
+        return &cEmpty;
+    }
+
+    /**
+     * Empties slot nHole, moving later entries of its cluster back into
+     * it so that each can still be found by probing from its home slot.
+     */
+    void
+    Remove ( size_t nHole )
+    {
+        size_t nSlot = nHole;
+        while (true)
+        {
+            nSlot = (nSlot + 1) & m_nMask;
+            if (!m_Slots[nSlot].pKey)
+                break;
+            // the entry may move back only if the hole lies between
+            // its home slot and its slot
+            size_t nHome = m_Slots[nSlot].nHash & m_nMask;
+            if (((nSlot - nHome) & m_nMask) >= ((nSlot - nHole) & m_nMask))
+            {
+                m_Slots[nHole] = m_Slots[nSlot];
+                nHole          = nSlot;
+            }
+        }
+        m_Slots[nHole] = Entry();
+        m_nSize--;
+    }
+
+    void
+    Grow ()
+    {
+        std::vector<Entry> OldSlots(m_Slots.size() * 2, Entry());
+        OldSlots.swap(m_Slots);
+        m_nMask = m_Slots.size() - 1;
+        for (const Entry &entry : OldSlots)
+        {
+            if (!entry.pKey)
+                continue;
+            size_t nSlot = entry.nHash & m_nMask;
+            while (m_Slots[nSlot].pKey)
+                nSlot = (nSlot + 1) & m_nMask;
+            m_Slots[nSlot] = entry;
+        }
+    }
+
+    std::vector<Entry> m_Slots;
+    size_t             m_nInitialCapacity;
+    size_t             m_nMask;
+    size_t             m_nSize;
+    KeyArena           m_Arena;
+};
+
+#endif // COUNTTABLE_H
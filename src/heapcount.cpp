@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          heapcount
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Counts heap allocations for --stats
+ *
+ * Description:
+ *    Replaces the global operator new, which every allocation of the
+ *    standard containers and of the key arenas goes through, with one
+ *    that adds to g_nHeapAllocations and g_nHeapBytes.  It is linked
+ *    into the tools only, not into libcount, so that a program using
+ *    the library keeps its own allocator.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version, moved from toolstats.cpp.
+ *
+ * \file heapcount.cpp
+ */
+
+#include "config.h"
+#include <cstdlib>
+#include <new>
+#include "toolstats.h"
+using namespace std;
+
+void *
+operator new ( size_t nSize )
+{
+    g_nHeapAllocations.fetch_add(1, memory_order_relaxed);
+    g_nHeapBytes.fetch_add(nSize, memory_order_relaxed);
+    void *p = malloc(nSize ? nSize : 1);
+    if (!p)
+        throw bad_alloc();
+    return p;
+}
+
+void *
+operator new[] ( size_t nSize )
+{
+    return operator new(nSize);
+}
+
+void
+operator delete ( void *p ) noexcept
+{
+    free(p);
+}
+
+void
+operator delete[] ( void *p ) noexcept
+{
+    free(p);
+}
+
+void
+operator delete ( void *p,
+                  size_t ) noexcept
+{
+    free(p);
+}
+
+void
+operator delete[] ( void *p,
+                    size_t ) noexcept
+{
+    free(p);
+}
@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          hyperloglog
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Fixed-memory estimation of the number of distinct values
+ *
+ * Description:
+ *    Implementation of HyperLogLog.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file hyperloglog.cpp
+ */
+
+#include "config.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include "hyperloglog.h"
+#include "inputfile.h"
+#include "outputfile.h"
+using namespace std;
+
+HyperLogLog::HyperLogLog ( int nPrecision )
+    : m_nPrecision(nPrecision), m_Registers(size_t(1) << nPrecision, 0)
+{
+}
+
+void
+HyperLogLog::Reduce ( int nPrecision )
+{
+    if (nPrecision >= m_nPrecision)
+        return;
+    // the index bits that are dropped become the first bits of the
+    // rest of the hash, so they decide the rank unless they are all
+    // zero, in which case they add to it
+    int             nDropped = m_nPrecision - nPrecision;
+    uint64_t        nMask    = (uint64_t(1) << nDropped) - 1;
+    vector<uint8_t> Registers(size_t(1) << nPrecision, 0);
+    for ( size_t i = 0; i < m_Registers.size(); i++ )
+    {
+        if (m_Registers[i] == 0)
+            continue;
+        uint64_t nLow  = i & nMask;
+        uint8_t  nRank = nLow ?
+            nDropped - (64 - __builtin_clzll(nLow)) + 1 :
+            m_Registers[i] + nDropped;
+        uint8_t &nReg  = Registers[i >> nDropped];
+        if (nRank > nReg)
+            nReg = nRank;
+    }
+    m_nPrecision = nPrecision;
+    m_Registers.swap(Registers);
+}
+
+void
+HyperLogLog::Merge ( const HyperLogLog &other )
+{
+    if (other.m_nPrecision > m_nPrecision)
+    {
+        HyperLogLog reduced(other);
+        reduced.Reduce(m_nPrecision);
+        Merge(reduced);
+        return;
+    }
+    Reduce(other.m_nPrecision);
+    for ( size_t i = 0; i < m_Registers.size(); i++ )
+        m_Registers[i] = max(m_Registers[i], other.m_Registers[i]);
+}
+
+/**
+ * The sigma function of Ertl's estimator, which accounts for the
+ * registers that are still zero.
+ */
+static double
+Sigma ( double x )
+{
+    if (x == 1)
+        return INFINITY;
+    double y = 1;
+    double z = x;
+    double zPrevious;
+    do
+    {
+        x         *= x;
+        zPrevious  = z;
+        z         += x * y;
+        y         += y;
+    } while (z != zPrevious);
+    return z;
+}
+
+/**
+ * The tau function of Ertl's estimator, which accounts for the
+ * registers that have reached their largest value.
+ */
+static double
+Tau ( double x )
+{
+    if (x == 0 || x == 1)
+        return 0;
+    double y = 1;
+    double z = 1 - x;
+    double zPrevious;
+    do
+    {
+        x          = sqrt(x);
+        zPrevious  = z;
+        y         *= 0.5;
+        z         -= (1 - x) * (1 - x) * y;
+    } while (z != zPrevious);
+    return z / 3;
+}
+
+double
+HyperLogLog::Estimate () const
+{
+    int            nMaxRank = MaxRank();
+    vector<double> Histogram(nMaxRank + 1, 0);
+    for ( size_t i = 0; i < m_Registers.size(); i++ )
+        Histogram[m_Registers[i]]++;
+    double m = m_Registers.size();
+    double z = m * Tau(1 - Histogram[nMaxRank] / m);
+    for ( int k = nMaxRank - 1; k >= 1; k-- )
+        z = 0.5 * (z + Histogram[k]);
+    z += m * Sigma(Histogram[0] / m);
+    return m * m / (2 * log(2.0) * z);
+}
+
+bool
+HyperLogLog::Save ( const string &sFileName ) const
+{
+    OutputFile output;
+    if (!output.Open(sFileName))
+    {
+        cerr << "ERROR: Could not open file " << sFileName << endl;
+        return false;
+    }
+    char Header[HLL_HEADER_SIZE] =
+        { HLL_MAGIC[0], HLL_MAGIC[1], HLL_MAGIC[2], HLL_MAGIC[3],
+          HLL_VERSION, static_cast<char>(m_nPrecision), 0, 0 };
+    output.Write(Header, sizeof(Header));
+    output.Write(reinterpret_cast<const char *>(m_Registers.data()),
+                 m_Registers.size());
+    if (!output.Close())
+    {
+        cerr << "ERROR: Could not write file " << output.Name() << endl;
+        return false;
+    }
+    return true;
+}
+
+bool
+HyperLogLog::Load ( const string &sFileName )
+{
+    InputFile input;
+    if (!input.Open(sFileName))
+    {
+        cerr << "ERROR: Could not open file " << sFileName << endl;
+        return false;
+    }
+    string sData;
+    if (input.IsMapped())
+    {
+        sData.assign(input.Data(), input.Size());
+    }
+    else
+    {
+        char    Buffer[1 << 16];
+        ssize_t nRead;
+        while ((nRead = input.Read(Buffer, sizeof(Buffer))) > 0)
+            sData.append(Buffer, nRead);
+        if (nRead < 0)
+        {
+            cerr << "ERROR: Could not read " << input.Name() << endl;
+            return false;
+        }
+    }
+    int nPrecision = sData.size() >= HLL_HEADER_SIZE ? sData[5] : 0;
+    if (sData.size() < HLL_HEADER_SIZE ||
+        memcmp(sData.data(), HLL_MAGIC, 4) != 0 ||
+        sData[4] != HLL_VERSION || nPrecision < HLL_MIN_PRECISION ||
+        nPrecision > HLL_MAX_PRECISION ||
+        sData.size() != HLL_HEADER_SIZE + (size_t(1) << nPrecision))
+    {
+        cerr << "ERROR: " << input.Name() << " is not a sketch file" << endl;
+        return false;
+    }
+    m_nPrecision = nPrecision;
+    m_Registers.assign(sData.begin() + HLL_HEADER_SIZE, sData.end());
+    uint8_t nMaxRank = MaxRank();
+    for ( size_t i = 0; i < m_Registers.size(); i++ )
+    {
+        if (m_Registers[i] > nMaxRank)
+        {
+            cerr << "ERROR: " << input.Name() << " is not a sketch file"
+                 << endl;
+            return false;
+        }
+    }
+    return true;
+}
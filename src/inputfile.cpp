@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          inputfile
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Opens an input, memory-mapping it where possible
+ *
+ * Description:
+ *    Implementation of InputFile.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Decompress gzip, xz and zstd inputs; add Read().
+ *
+ * \file inputfile.cpp
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "inputfile.h"
+using namespace std;
+
+InputFile::InputFile ()
+    : m_nFd(-1), m_nSourceFd(-1), m_fDetect(false), m_fMapped(false),
+      m_pData(0), m_nSize(0)
+{
+}
+
+InputFile::~InputFile ()
+{
+    if (m_fMapped && m_nSize > 0)
+        munmap(const_cast<char *>(m_pData), m_nSize);
+    if (m_nFd > 0)
+        close(m_nFd);
+    // closing the pipe stops a decompressor that is still writing
+    m_Codec.Finish();
+    if (m_nSourceFd > 0)
+        close(m_nSourceFd);
+}
+
+bool
+InputFile::Open ( const string &sFileName )
+{
+    if (sFileName.compare("-") == 0)
+    {
+        m_sName = "<stdin>";
+        m_nFd   = 0;
+    }
+    else
+    {
+        m_sName = sFileName;
+        m_nFd   = open(sFileName.c_str(), O_RDONLY);
+        if (m_nFd < 0)
+            return false;
+    }
+
+    // only regular files can be mapped; anything else (including a
+    // regular file redirected onto standard input, which might have
+    // been partly consumed already) is read through the descriptor
+    struct stat st;
+    if (m_nFd == 0 || fstat(m_nFd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        m_fDetect = true;
+        return true;
+    }
+    if (st.st_size == 0)
+    {
+        m_fMapped = true;
+        return true;
+    }
+    char    Magic[COMPRESSION_MAGIC_SIZE];
+    ssize_t nMagic = pread(m_nFd, Magic, sizeof(Magic), 0);
+    if (nMagic > 0)
+    {
+        Compression format = DetectCompression(Magic, nMagic);
+        if (format != COMPRESSION_NONE)
+        {
+            if (!Decompress(format, ""))
+            {
+                errno = EINVAL;
+                return false;
+            }
+            return true;
+        }
+    }
+    void *pMap = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, m_nFd, 0);
+    if (pMap == MAP_FAILED)
+        return true;
+#ifdef MADV_SEQUENTIAL
+    madvise(pMap, st.st_size, MADV_SEQUENTIAL);
+#endif
+    m_fMapped = true;
+    m_pData   = static_cast<const char *>(pMap);
+    m_nSize   = st.st_size;
+    return true;
+}
+
+ssize_t
+InputFile::Read ( char   *pBuffer,
+                  size_t  nSize )
+{
+    ssize_t nRead;
+    if (m_fDetect)
+    {
+        // read until the bytes so far show whether this is compressed
+        m_fDetect = false;
+        size_t nUsed = 0;
+        do
+        {
+            nRead = read(m_nFd, pBuffer + nUsed, nSize - nUsed);
+            if (nRead > 0)
+                nUsed += nRead;
+        } while ((nRead > 0 || (nRead < 0 && errno == EINTR)) &&
+                 nUsed < nSize && IsCompressionMagicPrefix(pBuffer, nUsed));
+        if (nUsed == 0)
+            return nRead;
+        Compression format = DetectCompression(pBuffer, nUsed);
+        if (format == COMPRESSION_NONE)
+            return nUsed;
+        if (!Decompress(format, string(pBuffer, nUsed)))
+        {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    do
+    {
+        nRead = read(m_nFd, pBuffer, nSize);
+    } while (nRead < 0 && errno == EINTR);
+    if (nRead == 0 && m_Codec.IsRunning() && !m_Codec.Finish())
+    {
+        errno = EIO;
+        return -1;
+    }
+    return nRead;
+}
+
+bool
+InputFile::Decompress ( Compression   format,
+                        const string &sPrefix )
+{
+    int nReadFd;
+    if (!m_Codec.StartDecompressing(format, m_nFd, sPrefix, m_sName,
+                                    nReadFd))
+        return false;
+    m_nSourceFd = m_nFd;
+    m_nFd       = nReadFd;
+    return true;
+}
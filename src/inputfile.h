@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          inputfile
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Opens an input, memory-mapping it where possible
+ *
+ * Description:
+ *    InputFile opens a named input file, or standard input for the
+ *    name "-".  Regular files are mapped read-only into memory, so
+ *    that their contents can be scanned (and referred to) in place
+ *    without any read() calls or copies; other inputs such as pipes,
+ *    FIFOs and terminals expose a file descriptor to be read with a
+ *    BlockReader instead.  The mapping stays valid for the lifetime of
+ *    the InputFile object.
+ *
+ *    Compressed inputs (see compression.h) are recognised by their
+ *    first bytes and decompressed on a separate thread; they are read
+ *    through Read() like any other unmapped input.  For a regular file
+ *    the check is made when it is opened, but a pipe cannot be looked
+ *    at without consuming it, so there the check is made on the first
+ *    Read(), which returns the bytes it looked at if they turn out not
+ *    to be compressed.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Decompress gzip, xz and zstd inputs; add Read().
+ *
+ * \file inputfile.h
+ */
+
+#ifndef INPUTFILE_H
+#define INPUTFILE_H
+
+#include <sys/types.h>
+#include <cstddef>
+#include <string>
+#include "compression.h"
+
+class InputFile
+{
+public:
+    InputFile ();
+    ~InputFile ();
+
+    InputFile ( const InputFile & ) = delete;
+    InputFile &operator= ( const InputFile & ) = delete;
+
+    /**
+     * Opens sFileName, or standard input if it is "-".  Returns false
+     * (with errno set) if the file could not be opened.
+     */
+    bool Open ( const std::string &sFileName );
+
+    bool
+    IsMapped () const
+    {
+        return m_fMapped;
+    }
+
+    /**
+     * The mapped contents; only meaningful if IsMapped().
+     */
+    const char *
+    Data () const
+    {
+        return m_pData;
+    }
+
+    size_t
+    Size () const
+    {
+        return m_nSize;
+    }
+
+    /**
+     * The descriptor to wait on (with poll()) if the input is not
+     * mapped; it may change after the first Read().
+     */
+    int
+    Fd () const
+    {
+        return m_nFd;
+    }
+
+    /**
+     * Reads up to nSize bytes of an unmapped input, as read() would,
+     * decompressing it if need be.  Returns 0 at the end of the input,
+     * or -1 if reading or decompressing failed.
+     */
+    ssize_t Read ( char   *pBuffer,
+                   size_t  nSize );
+
+    /**
+     * The file name for use in messages; "<stdin>" for standard input.
+     */
+    const std::string &
+    Name () const
+    {
+        return m_sName;
+    }
+
+private:
+    bool Decompress ( Compression        format,
+                      const std::string &sPrefix );
+
+    std::string m_sName;
+    int         m_nFd;
+    int         m_nSourceFd;    // the input itself, when decompressing
+    bool        m_fDetect;      // compression not yet checked
+    bool        m_fMapped;
+    const char *m_pData;
+    size_t      m_nSize;
+    StreamCodec m_Codec;
+};
+
+#endif // INPUTFILE_H
@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          keyselect
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Picks the part of an input line that is counted
+ *
+ * Description:
+ *    Implementation of KeySelector.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Fall back to matching a copy of the line without
+ *            REG_STARTEND.
+ *
+ * \file keyselect.cpp
+ */
+
+#include "config.h"
+#include <limits>
+#include <iostream>
+#include <sstream>
+#include "keyselect.h"
+using namespace std;
+
+KeySelector::KeySelector ()
+    : m_nFirstField(0), m_nLastField(0), m_cDelimiter('\t'),
+      m_fWhitespace(false), m_fRegex(false), m_nGroup(0)
+{
+}
+
+KeySelector::KeySelector ( const KeySelector &other )
+    : m_nFirstField(other.m_nFirstField), m_nLastField(other.m_nLastField),
+      m_cDelimiter(other.m_cDelimiter), m_fWhitespace(other.m_fWhitespace),
+      m_fRegex(false), m_nGroup(0)
+{
+    if (other.m_fRegex)
+        SetRegex(other.m_sPattern, static_cast<int>(other.m_nGroup));
+}
+
+KeySelector::~KeySelector ()
+{
+    if (m_fRegex)
+        regfree(&m_Regex);
+}
+
+bool
+KeySelector::SetFields ( const string &sRange )
+{
+    istringstream iss(sRange);
+    long long     nFirst = 0;
+    long long     nLast  = 0;
+    iss >> nFirst;
+    if (iss.fail() || nFirst <= 0)
+        return false;
+    nLast = nFirst;
+    if (iss.peek() == '-')
+    {
+        iss.get();
+        nLast = numeric_limits<long long>::max();
+        if (iss.peek() != EOF)
+        {
+            iss >> nLast;
+            if (iss.fail() || nLast < nFirst)
+                return false;
+        }
+    }
+    if (iss.peek() != EOF)
+        return false;
+    m_nFirstField = nFirst;
+    m_nLastField  = nLast;
+    return true;
+}
+
+void
+KeySelector::SetDelimiter ( char cDelimiter )
+{
+    m_cDelimiter = cDelimiter;
+}
+
+void
+KeySelector::SetWhitespace ()
+{
+    m_fWhitespace = true;
+}
+
+bool
+KeySelector::SetRegex ( const string &sPattern,
+                        int           nGroup )
+{
+    if (m_fRegex)
+    {
+        regfree(&m_Regex);
+        m_fRegex = false;
+    }
+    int nError = regcomp(&m_Regex, sPattern.c_str(), REG_EXTENDED);
+    if (nError)
+    {
+        char sMessage[256];
+        regerror(nError, &m_Regex, sMessage, sizeof(sMessage));
+        cerr << "ERROR: Invalid regular expression " << sPattern << ": "
+             << sMessage << endl;
+        return false;
+    }
+    if (nGroup < 0)
+        nGroup = m_Regex.re_nsub > 0 ? 1 : 0;
+    if (static_cast<size_t>(nGroup) > m_Regex.re_nsub ||
+        static_cast<size_t>(nGroup) > MAX_KEY_GROUP)
+    {
+        cerr << "ERROR: Regular expression " << sPattern << " has no group "
+             << nGroup << endl;
+        regfree(&m_Regex);
+        return false;
+    }
+    m_fRegex   = true;
+    m_sPattern = sPattern;
+    m_nGroup   = nGroup;
+    return true;
+}
+
+bool
+KeySelector::SelectBlankFields ( const char  *pLine,
+                                 size_t       nLength,
+                                 const char *&pKey,
+                                 size_t      &nKeyLength ) const
+{
+    const char *p      = pLine;
+    const char *pEnd   = pLine + nLength;
+    const char *pStop  = 0;
+    size_t      nField = 0;
+    pKey = 0;
+    while (p < pEnd && nField < m_nLastField)
+    {
+        while (p < pEnd && (*p == ' ' || *p == '\t'))
+            p++;
+        if (p == pEnd)
+            break;
+        if (++nField == m_nFirstField)
+            pKey = p;
+        while (p < pEnd && *p != ' ' && *p != '\t')
+            p++;
+        pStop = p;
+    }
+    if (!pKey)
+        return false;
+    nKeyLength = pStop - pKey;
+    return true;
+}
+
+bool
+KeySelector::SelectMatch ( const char  *pLine,
+                           size_t       nLength,
+                           const char *&pKey,
+                           size_t      &nKeyLength ) const
+{
+    regmatch_t Matches[MAX_KEY_GROUP + 1];
+#ifdef REG_STARTEND
+    // match within the line without copying it to add a terminating
+    // null
+    Matches[0].rm_so = 0;
+    Matches[0].rm_eo = nLength;
+    if (regexec(&m_Regex, pLine, m_nGroup + 1, Matches, REG_STARTEND) != 0 ||
+        Matches[m_nGroup].rm_so < 0)
+    {
+        return false;
+    }
+#else
+    m_sLine.assign(pLine, nLength);
+    if (regexec(&m_Regex, m_sLine.c_str(), m_nGroup + 1, Matches, 0) != 0 ||
+        Matches[m_nGroup].rm_so < 0)
+    {
+        return false;
+    }
+#endif
+    pKey       = pLine + Matches[m_nGroup].rm_so;
+    nKeyLength = Matches[m_nGroup].rm_eo - Matches[m_nGroup].rm_so;
+    return true;
+}
@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          keyselect
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Picks the part of an input line that is counted
+ *
+ * Description:
+ *    KeySelector finds the key of a line of input: the whole line, a
+ *    field or range of fields, or a capture group of a regular
+ *    expression.  The key is always a slice of the line itself, so
+ *    nothing is copied.  Fields are separated either by a single
+ *    delimiter character, as for cut, or by runs of blanks, as for awk;
+ *    a range of fields is returned with its separators as they appear
+ *    in the line.  Fields are found with memchr(), so counting a field
+ *    costs little more than counting whole lines.
+ *
+ *    Regular expressions are POSIX extended regular expressions.  A
+ *    compiled expression should not be shared between threads (glibc
+ *    serialises concurrent matches), so copying a KeySelector compiles
+ *    its own copy of the expression.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file keyselect.h
+ */
+
+#ifndef KEYSELECT_H
+#define KEYSELECT_H
+
+#include <regex.h>
+#include <string.h>
+#include <cstddef>
+#include <string>
+
+/**
+ * The highest capture group that can be selected, as for sed's \9.
+ */
+const size_t MAX_KEY_GROUP = 9;
+
+class KeySelector
+{
+public:
+    KeySelector ();
+    KeySelector ( const KeySelector &other );
+    ~KeySelector ();
+
+    KeySelector &operator= ( const KeySelector & ) = delete;
+
+    /**
+     * Selects the field range sRange: "N", "N-M" or "N-", counting
+     * fields from 1.  Returns false if sRange is not a valid range.
+     */
+    bool SetFields ( const std::string &sRange );
+
+    /**
+     * Separates fields with cDelimiter (a tab by default).
+     */
+    void SetDelimiter ( char cDelimiter );
+
+    /**
+     * Separates fields with runs of spaces and tabs, ignoring leading
+     * and trailing ones.
+     */
+    void SetWhitespace ();
+
+    /**
+     * Selects the text matched by capture group nGroup of sPattern (0
+     * for the whole match; if nGroup is negative, the first group, or
+     * the whole match if there are no groups).  Returns false, after
+     * printing a message, if sPattern does not compile or has no such
+     * group.
+     */
+    bool SetRegex ( const std::string &sPattern,
+                    int                nGroup );
+
+    /**
+     * Returns true if the key is the whole line.
+     */
+    bool
+    IsWholeLine () const
+    {
+        return !m_nFirstField && !m_fRegex;
+    }
+
+    /**
+     * Sets pKey and nKeyLength to the key of the line.  Returns false
+     * if the line has no key: it has too few fields, or the expression
+     * does not match it.
+     */
+    bool
+    Select ( const char  *pLine,
+             size_t       nLength,
+             const char *&pKey,
+             size_t      &nKeyLength ) const
+    {
+        if (m_fRegex)
+            return SelectMatch(pLine, nLength, pKey, nKeyLength);
+        if (m_fWhitespace)
+            return SelectBlankFields(pLine, nLength, pKey, nKeyLength);
+        if (!m_nFirstField)
+        {
+            pKey       = pLine;
+            nKeyLength = nLength;
+            return true;
+        }
+
+        const char *pEnd   = pLine + nLength;
+        const char *pStart = pLine;
+        for ( size_t i = 1; i < m_nFirstField; i++ )
+        {
+            const char *pDelimiter = static_cast<const char *>(
+                memchr(pStart, m_cDelimiter, pEnd - pStart));
+            if (!pDelimiter)
+                return false;
+            pStart = pDelimiter + 1;
+        }
+        const char *pStop = pStart;
+        for ( size_t i = m_nFirstField; i <= m_nLastField; i++ )
+        {
+            const char *pDelimiter = static_cast<const char *>(
+                memchr(pStop, m_cDelimiter, pEnd - pStop));
+            if (!pDelimiter)
+            {
+                pStop = pEnd;
+                break;
+            }
+            pStop = i < m_nLastField ? pDelimiter + 1 : pDelimiter;
+        }
+        pKey       = pStart;
+        nKeyLength = pStop - pStart;
+        return true;
+    }
+
+private:
+    bool SelectBlankFields ( const char  *pLine,
+                             size_t       nLength,
+                             const char *&pKey,
+                             size_t      &nKeyLength ) const;
+    bool SelectMatch ( const char  *pLine,
+                       size_t       nLength,
+                       const char *&pKey,
+                       size_t      &nKeyLength ) const;
+
+    size_t      m_nFirstField;      // 0 to select the whole line
+    size_t      m_nLastField;
+    char        m_cDelimiter;
+    bool        m_fWhitespace;
+    bool        m_fRegex;
+    std::string m_sPattern;
+    size_t      m_nGroup;
+    regex_t     m_Regex;
+    mutable std::string m_sLine;    // without REG_STARTEND, the line to match
+};
+
+#endif // KEYSELECT_H
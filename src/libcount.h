@@ -0,0 +1,374 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          libcount
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Counting in-process with libcount
+ *
+ * Description:
+ *    libcount is the library that the count tools are built on, for
+ *    programs that want to count without running count and piping
+ *    lines into it.  CountTable (or FloatCountTable, for floating-point
+ *    counts) does what the tools do, with the same results:
+ *
+ *      - AddBatch() and AddLines() count values, as count does;
+ *        AddBatchBorrowed() and AddLinesBorrowed() count them without
+ *        copying, for values that outlive the table.  A batch is
+ *        hashed first and inserted after, so that the table's memory
+ *        is loaded for many values at once.
+ *      - Merge() sums another table into this one, as addcount and
+ *        sortalph sum count files.
+ *      - Filter() keeps only the counts and values that meet the
+ *        conditions of a CountFilter and a ValueFilter, as threshcount
+ *        does.
+ *      - SortedEntries() and TopEntries() give the counts in
+ *        alphabetical order, or in order of descending count.
+ *      - Read() sums a count file (text or binary, and compressed or
+ *        not) into the table, and Write() writes the table as a count
+ *        file, in alphabetical order.
+ *
+ *    The table is a HashCountTable, and the other headers of libcount
+ *    give the lower-level pieces used by the tools: CountReader and
+ *    OutputFile, the merging of count files in countrun.h, and so on.
+ *    Programs link with -lcount (see libcount.pc).
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file libcount.h
+ */
+
+#ifndef LIBCOUNT_H
+#define LIBCOUNT_H
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "bincount.h"
+#include "compression.h"
+#include "countfilter.h"
+#include "countreader.h"
+#include "counttable.h"
+#include "outputfile.h"
+
+/**
+ * The number of values of a batch that are hashed before any of them
+ * is inserted.
+ */
+const size_t COUNT_BATCH_SIZE = 16;
+
+template<typename TCount>
+class BasicCountTable
+{
+public:
+    typedef typename HashCountTable<TCount>::Entry Entry;
+
+    /**
+     * Adds nCount to the count of Value, copying it if it is new.
+     */
+    void
+    Add ( std::string_view Value,
+          TCount           nCount = 1 )
+    {
+        m_Table.Add(Value.data(), Value.size(), nCount);
+    }
+
+    /**
+     * Like Add(), but keeps a pointer to the caller's bytes instead of
+     * a copy; they must stay valid for the life of the table.
+     */
+    void
+    AddBorrowed ( std::string_view Value,
+                  TCount           nCount = 1 )
+    {
+        m_Table.AddBorrowed(Value.data(), Value.size(), nCount);
+    }
+
+    /**
+     * Counts one occurrence of each of the nValues values at pValues,
+     * copying the new ones.
+     */
+    void
+    AddBatch ( const std::string_view *pValues,
+               size_t                  nValues )
+    {
+        AddBatch(pValues, nValues, true);
+    }
+
+    /**
+     * Like AddBatch(), but borrows the values, as AddBorrowed() does.
+     */
+    void
+    AddBatchBorrowed ( const std::string_view *pValues,
+                       size_t                  nValues )
+    {
+        AddBatch(pValues, nValues, false);
+    }
+
+    /**
+     * Counts the lines of Data, as count counts the lines of a file:
+     * every newline-terminated line, and the unterminated tail if it is
+     * not empty.
+     */
+    void
+    AddLines ( std::string_view Data )
+    {
+        AddLines(Data, true);
+    }
+
+    /**
+     * Like AddLines(), but borrows the lines, as AddBorrowed() does.
+     */
+    void
+    AddLinesBorrowed ( std::string_view Data )
+    {
+        AddLines(Data, false);
+    }
+
+    /**
+     * Adds all of the counts in other to this table.
+     */
+    void
+    Merge ( const BasicCountTable &other )
+    {
+        m_Table.Merge(other.m_Table);
+    }
+
+    /**
+     * Like Merge(), but takes over other's copies of its values rather
+     * than copying them again; other is left empty.
+     */
+    void
+    Absorb ( BasicCountTable &other )
+    {
+        m_Table.Absorb(other.m_Table);
+    }
+
+    /**
+     * Removes every value whose count is not kept by Counts or, if
+     * pValues is set, which is not kept by *pValues.  The table is
+     * filtered in place, without sorting.
+     */
+    void Filter ( const CountFilter<TCount> &Counts,
+                  ValueFilter               *pValues = 0 );
+
+    /**
+     * The count of Value, or zero if it has not been counted.
+     */
+    TCount
+    Count ( std::string_view Value ) const
+    {
+        const Entry *pEntry = m_Table.Find(Value.data(), Value.size());
+        return pEntry ? pEntry->nCount : 0;
+    }
+
+    /**
+     * The number of distinct values.
+     */
+    size_t
+    size () const
+    {
+        return m_Table.size();
+    }
+
+    /**
+     * Approximate number of bytes held by the table.
+     */
+    size_t
+    MemoryUsage () const
+    {
+        return m_Table.MemoryUsage();
+    }
+
+    /**
+     * Fills Entries with pointers to every entry (with Key() and
+     * nCount), in alphabetical order of value.  The pointers are
+     * invalidated by the next insertion.
+     */
+    void
+    SortedEntries ( std::vector<const Entry *> &Entries ) const
+    {
+        m_Table.SortedEntries(Entries);
+    }
+
+    /**
+     * Fills Entries with pointers to the nK entries with the highest
+     * counts (or to all of them, if nK is zero), in order of descending
+     * count, with equal counts in alphabetical order, as count -f
+     * writes them.  The pointers are invalidated by the next insertion.
+     */
+    void
+    TopEntries ( size_t                      nK,
+                 std::vector<const Entry *> &Entries ) const
+    {
+        m_Table.TopEntries(nK, Entries);
+    }
+
+    /**
+     * Adds the counts of the count file sFileName ("-" for standard
+     * input) to the table.  Returns false, after printing a message,
+     * if it could not be read.
+     */
+    bool Read ( const std::string &sFileName );
+
+    /**
+     * Writes the table to sFileName ("-" for standard output) as a
+     * count file in alphabetical order: a binary count file if fBinary
+     * is set, compressed in the given format.  Returns false, after
+     * printing a message, on failure.
+     */
+    bool Write ( const std::string &sFileName,
+                 bool               fBinary     = false,
+                 Compression        compression = COMPRESSION_NONE ) const;
+
+    void
+    Clear ()
+    {
+        m_Table.Clear();
+    }
+
+private:
+    static const bool FLOATING_POINT = std::is_floating_point<TCount>::value;
+
+    void AddBatch ( const std::string_view *pValues,
+                    size_t                  nValues,
+                    bool                    fCopyKeys );
+    void AddLines ( std::string_view Data,
+                    bool             fCopyKeys );
+
+    HashCountTable<TCount> m_Table;
+};
+
+typedef BasicCountTable<long long> CountTable;
+typedef BasicCountTable<double>    FloatCountTable;
+
+template<typename TCount>
+void
+BasicCountTable<TCount>::AddBatch ( const std::string_view *pValues,
+                                    size_t                  nValues,
+                                    bool                    fCopyKeys )
+{
+    uint64_t Hashes[COUNT_BATCH_SIZE];
+    for ( size_t nStart = 0; nStart < nValues; nStart += COUNT_BATCH_SIZE )
+    {
+        size_t nBatch = std::min(COUNT_BATCH_SIZE, nValues - nStart);
+        const std::string_view *pBatch = pValues + nStart;
+        for ( size_t i = 0; i < nBatch; i++ )
+        {
+            Hashes[i] = HashKey(pBatch[i].data(), pBatch[i].size());
+            m_Table.Prefetch(Hashes[i]);
+        }
+        for ( size_t i = 0; i < nBatch; i++ )
+        {
+            m_Table.Add(pBatch[i].data(), pBatch[i].size(), Hashes[i], 1,
+                        fCopyKeys);
+        }
+    }
+}
+
+template<typename TCount>
+void
+BasicCountTable<TCount>::AddLines ( std::string_view Data,
+                                    bool             fCopyKeys )
+{
+    std::string_view Lines[COUNT_BATCH_SIZE];
+    size_t           nLines = 0;
+    const char      *pData  = Data.data();
+    const char      *pEnd   = pData + Data.size();
+    while (pData < pEnd)
+    {
+        const char *pNewline =
+            static_cast<const char *>(memchr(pData, '\n', pEnd - pData));
+        const char *pLineEnd = pNewline ? pNewline : pEnd;
+        Lines[nLines++] = std::string_view(pData, pLineEnd - pData);
+        if (nLines == COUNT_BATCH_SIZE)
+        {
+            AddBatch(Lines, nLines, fCopyKeys);
+            nLines = 0;
+        }
+        pData = pLineEnd + 1;
+    }
+    AddBatch(Lines, nLines, fCopyKeys);
+}
+
+template<typename TCount>
+void
+BasicCountTable<TCount>::Filter ( const CountFilter<TCount> &Counts,
+                                  ValueFilter               *pValues )
+{
+    m_Table.Retain([&Counts, pValues](const Entry &entry)
+    {
+        return Counts.Keep(entry.nCount) &&
+               (!pValues || pValues->Keep(entry.Key()));
+    });
+}
+
+template<typename TCount>
+bool
+BasicCountTable<TCount>::Read ( const std::string &sFileName )
+{
+    CountReader input;
+    if (!input.Open(sFileName))
+    {
+        std::cerr << "ERROR: Could not open file " << sFileName << std::endl;
+        return false;
+    }
+    input.SetFloatingPoint(FLOATING_POINT);
+    input.SetAllowMissingTab(true);
+    while (input.Next())
+    {
+        if (FLOATING_POINT)
+            Add(input.Value, input.nFloatCount);
+        else
+            Add(input.Value, input.nCount);
+    }
+    return !input.Failed();
+}
+
+template<typename TCount>
+bool
+BasicCountTable<TCount>::Write ( const std::string &sFileName,
+                                 bool               fBinary,
+                                 Compression        compression ) const
+{
+    OutputFile output;
+    if (!output.Open(sFileName, compression))
+    {
+        std::cerr << "ERROR: Could not open file " << sFileName << std::endl;
+        return false;
+    }
+    std::vector<const Entry *> Entries;
+    SortedEntries(Entries);
+    BinaryCountWriter *binaryOutput = 0;
+    if (fBinary)
+        binaryOutput = new BinaryCountWriter(output, FLOATING_POINT);
+    for ( size_t i = 0; i < Entries.size(); i++ )
+    {
+        if (binaryOutput)
+            binaryOutput->Write(Entries[i]->Key(), Entries[i]->nCount,
+                                Entries[i]->nCount);
+        else
+            output.WriteRecord(Entries[i]->nCount, Entries[i]->Key());
+    }
+    if (binaryOutput)
+        binaryOutput->Finish();
+    delete binaryOutput;
+    if (!output.Close())
+    {
+        std::cerr << "ERROR: Could not write file " << output.Name()
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#endif // LIBCOUNT_H
@@ -0,0 +1,202 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          outputfile
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Buffered output file shared by all the tools
+ *
+ * Description:
+ *    Implementation of OutputFile.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Output to a string.
+ *          - Compressed output.
+ *
+ * \file outputfile.cpp
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "outputfile.h"
+using namespace std;
+
+/**
+ * Writes all of the given buffers, retrying after partial writes.
+ * Returns false if writing failed.
+ */
+static bool
+WriteFully ( int           nFd,
+             struct iovec *pVectors,
+             int           nVectors )
+{
+    while (nVectors > 0)
+    {
+        ssize_t nWritten = writev(nFd, pVectors, nVectors);
+        if (nWritten < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        while (nVectors > 0 &&
+               static_cast<size_t>(nWritten) >= pVectors->iov_len)
+        {
+            nWritten -= pVectors->iov_len;
+            pVectors++;
+            nVectors--;
+        }
+        if (nVectors > 0)
+        {
+            pVectors->iov_base = static_cast<char *>(pVectors->iov_base) +
+                                 nWritten;
+            pVectors->iov_len -= nWritten;
+        }
+    }
+    return true;
+}
+
+OutputFile::OutputFile ( size_t nBufferSize )
+    : m_nFd(-1),
+      m_nTargetFd(-1),
+      m_pTarget(0),
+      m_fOwnFd(false),
+      m_fFailed(false),
+      m_nPrecision(6),
+      m_pBuffer(new char[nBufferSize]),
+      m_nBufferSize(nBufferSize),
+      m_nUsed(0)
+{
+}
+
+OutputFile::~OutputFile ()
+{
+    Close();
+}
+
+bool
+OutputFile::Open ( const string &sFileName,
+                   Compression   format )
+{
+    if (sFileName.compare("-") == 0)
+    {
+        m_sName  = "<stdout>";
+        m_nFd    = 1;
+        m_fOwnFd = false;
+        return OpenFd(format);
+    }
+    m_sName  = sFileName;
+    m_nFd    = open(sFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    m_fOwnFd = true;
+    return m_nFd >= 0 && OpenFd(format);
+}
+
+/**
+ * Starts compressing into the file just opened, if asked.
+ */
+bool
+OutputFile::OpenFd ( Compression format )
+{
+    if (format == COMPRESSION_NONE)
+        return true;
+    int nWriteFd;
+    if (!m_Codec.StartCompressing(format, m_nFd, m_sName, nWriteFd))
+        return false;
+    m_nTargetFd = m_nFd;
+    m_nFd       = nWriteFd;
+    return true;
+}
+
+void
+OutputFile::OpenString ( string &sTarget )
+{
+    m_sName   = "<string>";
+    m_pTarget = &sTarget;
+}
+
+void
+OutputFile::WriteLarge ( const char *pData,
+                         size_t      nLength )
+{
+    if (m_pTarget)
+    {
+        m_pTarget->append(m_pBuffer.get(), m_nUsed);
+        m_pTarget->append(pData, nLength);
+        m_nUsed = 0;
+        return;
+    }
+    if (m_fFailed || m_nFd < 0)
+    {
+        m_fFailed = true;
+        m_nUsed   = 0;
+        return;
+    }
+    struct iovec Vectors[2];
+    Vectors[0].iov_base = m_pBuffer.get();
+    Vectors[0].iov_len  = m_nUsed;
+    Vectors[1].iov_base = const_cast<char *>(pData);
+    Vectors[1].iov_len  = nLength;
+    if (!WriteFully(m_nFd, Vectors, 2))
+        m_fFailed = true;
+    m_nUsed = 0;
+}
+
+bool
+OutputFile::Flush ()
+{
+    if (m_nUsed > 0 && m_pTarget)
+    {
+        m_pTarget->append(m_pBuffer.get(), m_nUsed);
+        m_nUsed = 0;
+    }
+    else if (m_nUsed > 0)
+    {
+        if (m_fFailed || m_nFd < 0)
+        {
+            m_fFailed = true;
+        }
+        else
+        {
+            struct iovec Vector;
+            Vector.iov_base = m_pBuffer.get();
+            Vector.iov_len  = m_nUsed;
+            if (!WriteFully(m_nFd, &Vector, 1))
+                m_fFailed = true;
+        }
+        m_nUsed = 0;
+    }
+    return !m_fFailed;
+}
+
+bool
+OutputFile::Close ()
+{
+    bool fOk = Flush();
+    if (m_nTargetFd >= 0)
+    {
+        // the compressor finishes once it sees the end of its pipe
+        close(m_nFd);
+        if (!m_Codec.Finish())
+            fOk = false;
+        m_nFd       = m_nTargetFd;
+        m_nTargetFd = -1;
+    }
+    if (m_fOwnFd && m_nFd >= 0 && close(m_nFd) != 0)
+    {
+        m_fFailed = true;
+        fOk       = false;
+    }
+    m_nFd     = -1;
+    m_fOwnFd  = false;
+    m_pTarget = 0;
+    return fOk;
+}
@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          outputfile
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Buffered output file shared by all the tools
+ *
+ * Description:
+ *    OutputFile collects output in a large buffer and writes it to its
+ *    file descriptor only when the buffer is full, or when the file is
+ *    flushed or closed.  Counts are formatted with to_chars, which for
+ *    floating-point numbers gives exactly what an ostream with the same
+ *    precision prints.  A value too large for the buffer is written
+ *    together with the buffered bytes in a single writev, without
+ *    being copied.  An OutputFile can also collect its output in a
+ *    string, so that pieces formatted in parallel can be written out
+ *    later in order.
+ *
+ *    Output can also be compressed (see compression.h), on a separate
+ *    thread that the buffer is written to through a pipe.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - OpenString().
+ *          - Compressed output.
+ *
+ * \file outputfile.h
+ */
+
+#ifndef OUTPUTFILE_H
+#define OUTPUTFILE_H
+
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "compression.h"
+
+class OutputFile
+{
+public:
+    explicit OutputFile ( size_t nBufferSize = 1 << 20 );
+    ~OutputFile ();
+
+    OutputFile ( const OutputFile & ) = delete;
+    OutputFile &operator= ( const OutputFile & ) = delete;
+
+    /**
+     * Creates (or truncates) sFileName, or uses standard output if it
+     * is "-", compressing what is written to it in the given format.
+     * Returns false (with errno set) if the file could not be created.
+     */
+    bool Open ( const std::string &sFileName,
+                Compression        format = COMPRESSION_NONE );
+
+    /**
+     * Appends the output to sTarget instead of writing it to a file;
+     * sTarget is complete once the OutputFile is flushed.
+     */
+    void OpenString ( std::string &sTarget );
+
+    /**
+     * The file name for use in messages; "<stdout>" for standard output.
+     */
+    const std::string &
+    Name () const
+    {
+        return m_sName;
+    }
+
+    /**
+     * The number of significant digits used for floating-point counts;
+     * the default, 6, matches an ostream.
+     */
+    void
+    SetPrecision ( int nPrecision )
+    {
+        m_nPrecision = nPrecision;
+    }
+
+    void
+    Write ( const char *pData,
+            size_t      nLength )
+    {
+        if (nLength <= m_nBufferSize - m_nUsed)
+        {
+            memcpy(m_pBuffer.get() + m_nUsed, pData, nLength);
+            m_nUsed += nLength;
+        }
+        else
+        {
+            WriteLarge(pData, nLength);
+        }
+    }
+
+    void
+    Write ( std::string_view Value )
+    {
+        Write(Value.data(), Value.size());
+    }
+
+    void
+    Put ( char c )
+    {
+        if (m_nUsed == m_nBufferSize)
+            Flush();
+        m_pBuffer[m_nUsed++] = c;
+    }
+
+    void
+    WriteNumber ( long long nValue )
+    {
+        Reserve(24);
+        char *pStart = m_pBuffer.get() + m_nUsed;
+        m_nUsed = std::to_chars(pStart, pStart + 24, nValue).ptr -
+                  m_pBuffer.get();
+    }
+
+    void
+    WriteNumber ( double nValue )
+    {
+        Reserve(32);
+        char *pStart = m_pBuffer.get() + m_nUsed;
+        m_nUsed = std::to_chars(pStart, pStart + 32, nValue,
+                                std::chars_format::general,
+                                m_nPrecision).ptr - m_pBuffer.get();
+    }
+
+    /**
+     * Writes a count line: the count, a tab, the value and a newline.
+     */
+    template<typename TCount>
+    void
+    WriteRecord ( TCount           nCount,
+                  std::string_view Value )
+    {
+        WriteNumber(nCount);
+        Put('\t');
+        Write(Value);
+        Put('\n');
+    }
+
+    /**
+     * Writes out the buffer.  Returns false if this or any earlier
+     * write failed.
+     */
+    bool Flush ();
+
+    /**
+     * Flushes and closes the file.  Returns false if any write failed.
+     */
+    bool Close ();
+
+private:
+    void
+    Reserve ( size_t nLength )
+    {
+        if (m_nBufferSize - m_nUsed < nLength)
+            Flush();
+    }
+
+    void WriteLarge ( const char *pData,
+                      size_t      nLength );
+
+    bool OpenFd ( Compression format );
+
+    std::string             m_sName;
+    int                     m_nFd;
+    int                     m_nTargetFd;    // the file, when compressing
+    std::string            *m_pTarget;
+    bool                    m_fOwnFd;
+    bool                    m_fFailed;
+    int                     m_nPrecision;
+    std::unique_ptr<char[]> m_pBuffer;
+    size_t                  m_nBufferSize;
+    size_t                  m_nUsed;
+    StreamCodec             m_Codec;
+};
+
+#endif // OUTPUTFILE_H
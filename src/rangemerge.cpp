@@ -0,0 +1,289 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          rangemerge
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Parallel merge of sorted count files by key range
+ *
+ * Description:
+ *    Implementation of ParallelMergeCountFiles().
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Line search moved to sortedlines.cpp.
+ *          - Report the input read to a ToolStats.
+ *
+ * \file rangemerge.cpp
+ */
+
+#include "config.h"
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "bincount.h"
+#include "countrun.h"
+#include "rangemerge.h"
+#include "sortedlines.h"
+using namespace std;
+
+/**
+ * Each thread gets this many ranges, so that uneven ranges still keep
+ * all the threads busy; large inputs get one more range for each
+ * RANGEMERGE_RANGE_BYTES of input, to bound the output held per range.
+ */
+const size_t RANGEMERGE_RANGES_PER_THREAD = 4;
+const size_t RANGEMERGE_RANGE_BYTES       = 64 << 20;
+
+/**
+ * The number of keys sampled for each range, to even out the ranges.
+ */
+const size_t RANGEMERGE_SAMPLES_PER_RANGE = 16;
+
+/**
+ * The buffer size of the output of a single range.
+ */
+const size_t RANGEMERGE_PIECE_BUFFER_SIZE = 64 << 10;
+
+/**
+ * A mapped input, and the offsets at which each range starts in it;
+ * range j is [Offsets[j], Offsets[j + 1]).
+ */
+struct RangeInput
+{
+    const InputFile *pInput;
+    vector<size_t>   Offsets;
+};
+
+static size_t
+CountLines ( const char *pData,
+             size_t      nSize )
+{
+    size_t      nLines = 0;
+    const char *pEnd   = pData + nSize;
+    while (pData < pEnd)
+    {
+        pData = static_cast<const char *>(memchr(pData, '\n', pEnd - pData));
+        if (!pData)
+            break;
+        pData++;
+        nLines++;
+    }
+    return nLines;
+}
+
+/**
+ * Splits the inputs into ranges of values, at keys sampled evenly from
+ * their contents, and sets the Offsets of each input.
+ */
+static void
+SplitIntoRanges ( vector<RangeInput> &Inputs,
+                  int                 nThreads )
+{
+    size_t nTotalSize = 0;
+    for ( size_t i = 0; i < Inputs.size(); i++ )
+        nTotalSize += Inputs[i].pInput->Size();
+    size_t nRanges = nThreads * RANGEMERGE_RANGES_PER_THREAD +
+                     nTotalSize / RANGEMERGE_RANGE_BYTES;
+
+    vector<string> Samples;
+    for ( size_t i = 0; nTotalSize > 0 && i < Inputs.size(); i++ )
+    {
+        const char *pData    = Inputs[i].pInput->Data();
+        size_t      nSize    = Inputs[i].pInput->Size();
+        size_t      nSamples = max<size_t>(
+            1, static_cast<double>(nRanges * RANGEMERGE_SAMPLES_PER_RANGE) *
+               nSize / nTotalSize);
+        for ( size_t j = 0; nSize > 0 && j < nSamples; j++ )
+        {
+            size_t nLine = LineStart(pData, nSize, nSize / nSamples * j);
+            if (nLine < nSize)
+                Samples.emplace_back(LineValue(pData, nSize, nLine));
+        }
+    }
+    sort(Samples.begin(), Samples.end());
+    Samples.erase(unique(Samples.begin(), Samples.end()), Samples.end());
+
+    vector<string> Splits;
+    for ( size_t k = 1; k < nRanges && !Samples.empty(); k++ )
+    {
+        const string &Key = Samples[k * Samples.size() / nRanges];
+        if (Splits.empty() || Splits.back() < Key)
+            Splits.push_back(Key);
+    }
+
+    for ( size_t i = 0; i < Inputs.size(); i++ )
+    {
+        const char *pData = Inputs[i].pInput->Data();
+        size_t      nSize = Inputs[i].pInput->Size();
+        Inputs[i].Offsets.assign(1, 0);
+        for ( size_t k = 0; k < Splits.size(); k++ )
+        {
+            // an unsorted input could give offsets out of order; the
+            // ranges must still cover the input, so that reading them
+            // finds the error
+            Inputs[i].Offsets.push_back(max(Inputs[i].Offsets.back(),
+                                            FindKey(pData, nSize,
+                                                    Splits[k])));
+        }
+        Inputs[i].Offsets.push_back(nSize);
+    }
+}
+
+/**
+ * Merges range j of the inputs into output.  A quiet merge only reports
+ * failure; otherwise messages are printed with the line numbers in the
+ * whole file.  The input read is added to pStats, if it is set.
+ */
+static bool
+MergeRange ( const vector<RangeInput> &Inputs,
+             size_t                    j,
+             bool                      fFloatingPoint,
+             bool                      fQuiet,
+             OutputFile               &output,
+             ToolStats                *pStats )
+{
+    vector<CountStream *> Streams;
+    for ( size_t i = 0; i < Inputs.size(); i++ )
+    {
+        const InputFile *pInput = Inputs[i].pInput;
+        size_t           nBegin = Inputs[i].Offsets[j];
+        size_t           nEnd   = Inputs[i].Offsets[j + 1];
+        CountFileStream *pStream = new CountFileStream(
+            pInput->Name(), fFloatingPoint, pInput->Data() + nBegin,
+            pInput->Data() + nEnd);
+        CountReader &reader = pStream->Reader();
+        reader.SetQuiet(fQuiet);
+        if (nBegin > 0)
+        {
+            reader.SetLastValue(PreviousLineValue(pInput->Data(),
+                                                  pInput->Size(), nBegin));
+            if (!fQuiet)
+                reader.SetLineNumber(CountLines(pInput->Data(), nBegin));
+        }
+        reader.SetStats(pStats);
+        Streams.push_back(pStream);
+    }
+
+    bool fOk = MergeCountStreams(
+        Streams, fFloatingPoint,
+        [&output, fFloatingPoint](long long   nCount,
+                                  double      nFloatCount,
+                                  string_view Value)
+        {
+            if (fFloatingPoint)
+                output.WriteRecord(nFloatCount, Value);
+            else
+                output.WriteRecord(nCount, Value);
+        });
+
+    for ( size_t i = 0; i < Streams.size(); i++ )
+        delete Streams[i];
+    return fOk;
+}
+
+bool
+CanMergeInRanges ( const InputFile &Input )
+{
+    return Input.IsMapped() &&
+           (Input.Size() == 0 || Input.Data()[0] != BINCOUNT_MAGIC[0]);
+}
+
+bool
+ParallelMergeCountFiles ( const vector<const InputFile *> &Files,
+                          bool                             fFloatingPoint,
+                          int                              nThreads,
+                          OutputFile                      &output,
+                          ToolStats                       *pStats )
+{
+    vector<RangeInput> Inputs(Files.size());
+    for ( size_t i = 0; i < Files.size(); i++ )
+        Inputs[i].pInput = Files[i];
+    SplitIntoRanges(Inputs, nThreads);
+    size_t nRanges = Inputs.empty() ? 0 : Inputs[0].Offsets.size() - 1;
+
+    // the merged ranges, and whether each is done (1) or failed (2);
+    // threads may start range j only while j < nWritten + nAhead
+    mutex              Lock;
+    condition_variable Changed;
+    vector<string>     Pieces(nRanges);
+    vector<char>       States(nRanges, 0);
+    size_t             nNext    = 0;
+    size_t             nWritten = 0;
+    size_t             nAhead   = 2 * nThreads;
+    bool               fAbort   = false;
+
+    auto worker = [&]()
+    {
+        unique_lock<mutex> guard(Lock);
+        while (true)
+        {
+            Changed.wait(guard, [&]()
+            {
+                return fAbort || nNext >= nRanges ||
+                       nNext < nWritten + nAhead;
+            });
+            if (fAbort || nNext >= nRanges)
+                break;
+            size_t j = nNext++;
+            guard.unlock();
+
+            string     sPiece;
+            OutputFile piece(RANGEMERGE_PIECE_BUFFER_SIZE);
+            piece.OpenString(sPiece);
+            bool fOk = MergeRange(Inputs, j, fFloatingPoint, true, piece,
+                                  pStats);
+            piece.Close();
+
+            guard.lock();
+            Pieces[j].swap(sPiece);
+            States[j] = fOk ? 1 : 2;
+            Changed.notify_all();
+        }
+    };
+
+    vector<thread> Threads;
+    for ( int t = 0; t < nThreads; t++ )
+        Threads.emplace_back(worker);
+
+    size_t nFailed = nRanges;
+    for ( size_t j = 0; j < nRanges; j++ )
+    {
+        string             sPiece;
+        unique_lock<mutex> guard(Lock);
+        Changed.wait(guard, [&]() { return States[j] != 0; });
+        if (States[j] == 2)
+        {
+            nFailed = j;
+            fAbort  = true;
+            Changed.notify_all();
+            break;
+        }
+        sPiece.swap(Pieces[j]);
+        nWritten = j + 1;
+        Changed.notify_all();
+        guard.unlock();
+        output.Write(sPiece);
+    }
+
+    for ( size_t t = 0; t < Threads.size(); t++ )
+        Threads[t].join();
+
+    if (nFailed < nRanges)
+    {
+        // merge the failed range again, to write its output up to the
+        // error and to report the error
+        MergeRange(Inputs, nFailed, fFloatingPoint, false, output, 0);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          rangemerge
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Parallel merge of sorted count files by key range
+ *
+ * Description:
+ *    ParallelMergeCountFiles() splits the space of values into ranges
+ *    at keys sampled from the inputs, finds where each range starts in
+ *    each (mapped, sorted) input by binary search, and merges the
+ *    ranges on several threads at once.  Since every value of a range
+ *    sorts before every value of the next, the merged ranges, written
+ *    out in order, are exactly what a single sequential merge gives.
+ *    Threads only run a bounded distance ahead of the range being
+ *    written, so the output held in memory stays small.
+ *
+ *    Each range is read with the sort-order check primed from the line
+ *    before it, so together the ranges check every line just as a
+ *    sequential read does.  If a range turns out to be malformed, it
+ *    is merged again sequentially, with the right line numbers, to
+ *    write the output up to the error and report it.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Report the input read to a ToolStats.
+ *
+ * \file rangemerge.h
+ */
+
+#ifndef RANGEMERGE_H
+#define RANGEMERGE_H
+
+#include <vector>
+#include "inputfile.h"
+#include "outputfile.h"
+#include "toolstats.h"
+
+/**
+ * Returns true if Input can take part in a parallel merge: it must be a
+ * mapped text count file.
+ */
+bool CanMergeInRanges ( const InputFile &Input );
+
+/**
+ * Merges the sorted text count files Inputs, all of them mapped, into
+ * output with nThreads threads, summing the counts of equal values.
+ * Returns false, after writing the output up to the error and printing
+ * a message, if an input is malformed or not sorted.  The lines and
+ * bytes read are added to pStats, if it is set.
+ */
+bool ParallelMergeCountFiles ( const std::vector<const InputFile *> &Inputs,
+                               bool                                  fFloatingPoint,
+                               int                                   nThreads,
+                               OutputFile                           &output,
+                               ToolStats                            *pStats = 0 );
+
+#endif // RANGEMERGE_H
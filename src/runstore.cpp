@@ -0,0 +1,464 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          runstore
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Persistent count store made of sorted runs
+ *
+ * Description:
+ *    Implementation of CountStore.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - A level with a run that cannot be opened is not compacted
+ *            (and compaction stops), rather than merged without it.
+ *          - Compact() can wait for another compaction to finish.
+ *          - Runs are created with the permissions of the other files
+ *            of the store, not readable by their owner only.
+ *
+ * \file runstore.cpp
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "countreader.h"
+#include "countrun.h"
+#include "runstore.h"
+#include "sortedlines.h"
+using namespace std;
+
+/**
+ * How many times to read the manifest again when a run it lists has
+ * been compacted away before it could be opened.
+ */
+const int STORE_OPEN_RETRIES = 10;
+
+/**
+ * Holds an exclusive lock on a file of the store for as long as the
+ * object lives.
+ */
+class StoreLock
+{
+public:
+    StoreLock ( const string &sPath,
+                bool          fWait )
+        : m_nFd(open(sPath.c_str(), O_RDWR | O_CREAT, 0666)),
+          m_fLocked(false)
+    {
+        int nResult = -1;
+        while (m_nFd >= 0 &&
+               (nResult = flock(m_nFd, fWait ? LOCK_EX : LOCK_EX | LOCK_NB))
+               != 0 && errno == EINTR)
+            ;
+        m_fLocked = nResult == 0;
+    }
+
+    ~StoreLock ()
+    {
+        if (m_nFd >= 0)
+            close(m_nFd);
+    }
+
+    StoreLock ( const StoreLock & ) = delete;
+    StoreLock &operator= ( const StoreLock & ) = delete;
+
+    bool
+    Locked () const
+    {
+        return m_fLocked;
+    }
+
+private:
+    int  m_nFd;
+    bool m_fLocked;
+};
+
+CountStore::CountStore ( const string &sDir )
+    : m_sDir(sDir)
+{
+}
+
+string
+CountStore::Path ( const string &sName ) const
+{
+    return m_sDir + "/" + sName;
+}
+
+bool
+CountStore::Open ( bool fCreate )
+{
+    if (fCreate && mkdir(m_sDir.c_str(), 0777) != 0 && errno != EEXIST)
+    {
+        cerr << "ERROR: Could not create directory " << m_sDir << endl;
+        return false;
+    }
+    struct stat st;
+    if (stat(Path("MANIFEST").c_str(), &st) == 0)
+        return true;
+    if (!fCreate)
+    {
+        cerr << "ERROR: " << m_sDir << " is not a count store" << endl;
+        return false;
+    }
+    StoreLock lock(Path("LOCK"), true);
+    if (!lock.Locked())
+    {
+        cerr << "ERROR: Could not lock count store " << m_sDir << endl;
+        return false;
+    }
+    if (stat(Path("MANIFEST").c_str(), &st) == 0)
+        return true;
+    return WriteManifest(vector<StoreRun>());
+}
+
+bool
+CountStore::CreateRun ( string     &sRunName,
+                        OutputFile &output )
+{
+    string       sTemplate = Path("run-XXXXXX.cnt");
+    vector<char> Name(sTemplate.begin(), sTemplate.end());
+    Name.push_back(0);
+    int nFd = mkstemps(Name.data(), 4);
+    if (nFd >= 0)
+    {
+        // mkstemps() creates the run readable by its owner only; give
+        // it the same permissions as the rest of the store
+        mode_t nMask = umask(0);
+        umask(nMask);
+        fchmod(nFd, 0666 & ~nMask);
+        close(nFd);
+    }
+    if (nFd < 0 || !output.Open(Name.data()))
+    {
+        cerr << "ERROR: Could not create a run in " << m_sDir << endl;
+        return false;
+    }
+    sRunName = string(Name.data()).substr(m_sDir.size() + 1);
+    return true;
+}
+
+bool
+CountStore::CommitRun ( const string &sRunName )
+{
+    StoreLock lock(Path("LOCK"), true);
+    vector<StoreRun> Runs;
+    if (!lock.Locked() || !ReadManifest(Runs))
+    {
+        cerr << "ERROR: Could not update count store " << m_sDir << endl;
+        return false;
+    }
+    StoreRun run;
+    run.nLevel = 0;
+    run.sName  = sRunName;
+    Runs.push_back(run);
+    return WriteManifest(Runs);
+}
+
+void
+CountStore::AbortRun ( const string &sRunName )
+{
+    unlink(Path(sRunName).c_str());
+}
+
+bool
+CountStore::ReadManifest ( vector<StoreRun> &Runs )
+{
+    Runs.clear();
+    ifstream manifest(Path("MANIFEST").c_str());
+    if (!manifest)
+    {
+        cerr << "ERROR: Could not read " << Path("MANIFEST") << endl;
+        return false;
+    }
+    string sLine;
+    while (getline(manifest, sLine))
+    {
+        istringstream iss(sLine);
+        StoreRun      run;
+        if (!(iss >> run.nLevel) || iss.get() != '\t' ||
+            !getline(iss, run.sName) || run.sName.empty())
+        {
+            cerr << "ERROR: Corrupt manifest " << Path("MANIFEST") << endl;
+            return false;
+        }
+        Runs.push_back(run);
+    }
+    return true;
+}
+
+/**
+ * Replaces the manifest with Runs; the caller holds the store lock.
+ */
+bool
+CountStore::WriteManifest ( const vector<StoreRun> &Runs )
+{
+    string     sTempName = Path("MANIFEST.tmp");
+    OutputFile manifest;
+    if (manifest.Open(sTempName))
+    {
+        for ( size_t i = 0; i < Runs.size(); i++ )
+        {
+            manifest.WriteNumber(static_cast<long long>(Runs[i].nLevel));
+            manifest.Put('\t');
+            manifest.Write(Runs[i].sName);
+            manifest.Put('\n');
+        }
+        if (manifest.Close() &&
+            rename(sTempName.c_str(), Path("MANIFEST").c_str()) == 0)
+            return true;
+    }
+    cerr << "ERROR: Could not write " << Path("MANIFEST") << endl;
+    unlink(sTempName.c_str());
+    return false;
+}
+
+bool
+CountStore::OpenRuns ( vector<unique_ptr<InputFile> > &Files )
+{
+    for ( int nTry = 0; nTry < STORE_OPEN_RETRIES; nTry++ )
+    {
+        vector<StoreRun> Runs;
+        if (!ReadManifest(Runs))
+            return false;
+        Files.clear();
+        size_t i = 0;
+        for ( ; i < Runs.size(); i++ )
+        {
+            unique_ptr<InputFile> pFile(new InputFile());
+            if (!pFile->Open(Path(Runs[i].sName)))
+            {
+                if (errno == ENOENT)
+                    break;
+                cerr << "ERROR: Could not open file "
+                     << Path(Runs[i].sName) << endl;
+                return false;
+            }
+            if (!pFile->IsMapped())
+            {
+                cerr << "ERROR: Could not map file "
+                     << Path(Runs[i].sName) << endl;
+                return false;
+            }
+            Files.push_back(std::move(pFile));
+        }
+        if (i == Runs.size())
+            return true;
+    }
+    cerr << "ERROR: Could not open the runs of count store " << m_sDir
+         << endl;
+    return false;
+}
+
+bool
+CountStore::Lookup ( const vector<string> &Keys,
+                     vector<long long>    &Counts )
+{
+    vector<unique_ptr<InputFile> > Files;
+    if (!OpenRuns(Files))
+        return false;
+    Counts.assign(Keys.size(), 0);
+    for ( size_t i = 0; i < Files.size(); i++ )
+    {
+        const char *pData = Files[i]->Data();
+        size_t      nSize = Files[i]->Size();
+        for ( size_t k = 0; k < Keys.size(); k++ )
+        {
+            size_t nLine = FindKey(pData, nSize, Keys[k]);
+            if (nLine == nSize || LineValue(pData, nSize, nLine) != Keys[k])
+                continue;
+            CountReader reader;
+            reader.OpenRange(pData + nLine, pData + nSize);
+            reader.SetName(Files[i]->Name());
+            if (!reader.Next())
+                return false;
+            Counts[k] += reader.nCount;
+        }
+    }
+    return true;
+}
+
+bool
+CountStore::Scan ( const function<void(long long, string_view)> &Output )
+{
+    vector<unique_ptr<InputFile> > Files;
+    if (!OpenRuns(Files))
+        return false;
+    vector<CountStream *> Streams;
+    for ( size_t i = 0; i < Files.size(); i++ )
+    {
+        Streams.push_back(new CountFileStream(
+            Files[i]->Name(), false, Files[i]->Data(),
+            Files[i]->Data() + Files[i]->Size()));
+    }
+    bool fOk = MergeCountStreams(
+        Streams, false,
+        [&Output](long long nCount, double, string_view Value)
+        {
+            Output(nCount, Value);
+        });
+    for ( size_t i = 0; i < Streams.size(); i++ )
+        delete Streams[i];
+    return fOk;
+}
+
+/**
+ * Merges all of the runs of level nLevel into one run of the next.
+ */
+bool
+CountStore::CompactLevel ( const vector<StoreRun> &Runs,
+                           int                     nLevel )
+{
+    vector<string>                 Merged;
+    vector<unique_ptr<InputFile> > Files;
+    vector<CountStream *>          Streams;
+    bool                           fOk = true;
+    for ( size_t i = 0; i < Runs.size(); i++ )
+    {
+        if (Runs[i].nLevel != nLevel)
+            continue;
+        unique_ptr<InputFile> pFile(new InputFile());
+        if (!pFile->Open(Path(Runs[i].sName)) || !pFile->IsMapped())
+        {
+            cerr << "ERROR: Could not open file " << Path(Runs[i].sName)
+                 << endl;
+            fOk = false;
+            break;
+        }
+        Streams.push_back(new CountFileStream(
+            pFile->Name(), false, pFile->Data(),
+            pFile->Data() + pFile->Size()));
+        Files.push_back(std::move(pFile));
+        Merged.push_back(Runs[i].sName);
+    }
+
+    string     sRunName;
+    OutputFile output;
+    fOk = fOk && CreateRun(sRunName, output);
+    if (fOk)
+    {
+        fOk = MergeCountStreams(
+            Streams, false,
+            [&output](long long nCount, double, string_view Value)
+            {
+                output.WriteRecord(nCount, Value);
+            });
+        if (!output.Close() && fOk)
+        {
+            cerr << "ERROR: Could not write file " << output.Name() << endl;
+            fOk = false;
+        }
+    }
+    for ( size_t i = 0; i < Streams.size(); i++ )
+        delete Streams[i];
+    if (fOk)
+    {
+        // other processes may have added runs meanwhile
+        StoreLock        lock(Path("LOCK"), true);
+        vector<StoreRun> Current;
+        fOk = lock.Locked() && ReadManifest(Current);
+        if (fOk)
+        {
+            vector<StoreRun> Kept;
+            for ( size_t i = 0; i < Current.size(); i++ )
+            {
+                if (find(Merged.begin(), Merged.end(), Current[i].sName) ==
+                    Merged.end())
+                    Kept.push_back(Current[i]);
+            }
+            StoreRun run;
+            run.nLevel = nLevel + 1;
+            run.sName  = sRunName;
+            Kept.push_back(run);
+            fOk = WriteManifest(Kept);
+        }
+    }
+    if (!fOk)
+    {
+        if (!sRunName.empty())
+            AbortRun(sRunName);
+        return false;
+    }
+    for ( size_t i = 0; i < Merged.size(); i++ )
+        unlink(Path(Merged[i]).c_str());
+    return true;
+}
+
+bool
+CountStore::Compact ( bool fWait )
+{
+    StoreLock lock(Path("COMPACT"), fWait);
+    if (!lock.Locked())
+        return true;
+    while (true)
+    {
+        vector<StoreRun> Runs;
+        if (!ReadManifest(Runs))
+            return false;
+        vector<size_t> LevelSizes;
+        for ( size_t i = 0; i < Runs.size(); i++ )
+        {
+            if (Runs[i].nLevel < 0)
+                continue;
+            if (LevelSizes.size() <= static_cast<size_t>(Runs[i].nLevel))
+                LevelSizes.resize(Runs[i].nLevel + 1, 0);
+            LevelSizes[Runs[i].nLevel]++;
+        }
+        size_t nLevel = 0;
+        while (nLevel < LevelSizes.size() &&
+               LevelSizes[nLevel] < STORE_LEVEL_FAN_IN)
+            nLevel++;
+        if (nLevel == LevelSizes.size())
+            return true;
+        if (!CompactLevel(Runs, nLevel))
+            return false;
+    }
+}
+
+void
+CountStore::CompactInBackground ()
+{
+    pid_t nPid = fork();
+    if (nPid < 0)
+    {
+        Compact();
+        return;
+    }
+    if (nPid > 0)
+    {
+        waitpid(nPid, 0, 0);
+        return;
+    }
+
+    // detach completely, so that the caller neither waits for the
+    // compaction nor has its output pipes held open by it
+    setsid();
+    if (fork() != 0)
+        _exit(0);
+    int nNull = open("/dev/null", O_RDWR);
+    int nLog  = open(Path("compact.log").c_str(),
+                     O_WRONLY | O_CREAT | O_APPEND, 0666);
+    if (nNull >= 0)
+    {
+        dup2(nNull, 0);
+        dup2(nNull, 1);
+    }
+    dup2(nLog >= 0 ? nLog : nNull, 2);
+    _exit(Compact() ? 0 : 1);
+}
@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          runstore
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Persistent count store made of sorted runs
+ *
+ * Description:
+ *    A CountStore is a directory of sorted count files (runs), whose
+ *    counts taken together are the contents of the store.  Adding
+ *    counts to the store writes them as a new small run; nothing that
+ *    is already in the store is rewritten.  The runs are kept in
+ *    levels: new runs start at level 0, and compaction merges all of
+ *    the runs of a level, once there are STORE_LEVEL_FAN_IN of them,
+ *    into a single run of the next level, summing the counts of equal
+ *    values as addcount does.  Compaction can run in a background
+ *    process, so that adding counts returns at once.
+ *
+ *    The file MANIFEST lists the level and file name of every run in
+ *    the store.  It is only ever replaced as a whole (by renaming a
+ *    new one into place) while holding a lock on the file LOCK, so
+ *    readers always see a complete set of runs; a second lock, on the
+ *    file COMPACT, lets only one process compact at a time.  Runs are
+ *    ordinary text count files, so they can also be read by the other
+ *    tools.  A reader maps every run it needs; should a compaction
+ *    delete a run between reading the manifest and opening the run,
+ *    the reader simply reads the new manifest and tries again.
+ *
+ *    Looking up a value costs a binary search in each run, and a full
+ *    sorted scan is a merge of all of the runs.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file runstore.h
+ */
+
+#ifndef RUNSTORE_H
+#define RUNSTORE_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "inputfile.h"
+#include "outputfile.h"
+
+/**
+ * The number of runs of a level that are merged into a run of the next
+ * level.
+ */
+const size_t STORE_LEVEL_FAN_IN = 4;
+
+struct StoreRun
+{
+    int         nLevel;
+    std::string sName;      // file name within the store directory
+};
+
+class CountStore
+{
+public:
+    explicit CountStore ( const std::string &sDir );
+
+    /**
+     * Checks that the store exists, creating it first if fCreate is
+     * set.  Returns false, after printing a message, if it cannot.
+     */
+    bool Open ( bool fCreate );
+
+    /**
+     * Creates a new, empty run file and opens output on it.  The run
+     * only becomes part of the store once CommitRun() is called.
+     */
+    bool CreateRun ( std::string &sRunName,
+                     OutputFile  &output );
+
+    /**
+     * Adds the finished run sRunName to the store at level 0.
+     */
+    bool CommitRun ( const std::string &sRunName );
+
+    /**
+     * Deletes a run that was created but not committed.
+     */
+    void AbortRun ( const std::string &sRunName );
+
+    /**
+     * Reads the list of runs in the store.
+     */
+    bool ReadManifest ( std::vector<StoreRun> &Runs );
+
+    /**
+     * Maps every run of the store, retrying if a compaction replaces
+     * runs meanwhile.  The runs stay readable for the life of Files.
+     */
+    bool OpenRuns ( std::vector<std::unique_ptr<InputFile> > &Files );
+
+    /**
+     * Sets Counts[i] to the total count of Keys[i] in the store.
+     */
+    bool Lookup ( const std::vector<std::string> &Keys,
+                  std::vector<long long>         &Counts );
+
+    /**
+     * Calls Output with every value in the store and its total count,
+     * in alphabetical order.
+     */
+    bool Scan ( const std::function<void(long long,
+                                         std::string_view)> &Output );
+
+    /**
+     * Merges runs until no level has STORE_LEVEL_FAN_IN runs or more.
+     * If another process is already compacting, waits for it to finish
+     * first if fWait is set, and otherwise returns at once.
+     */
+    bool Compact ( bool fWait = false );
+
+    /**
+     * Runs Compact() in a detached background process, which logs any
+     * errors to the file compact.log in the store.
+     */
+    void CompactInBackground ();
+
+private:
+    std::string Path ( const std::string &sName ) const;
+    bool        WriteManifest ( const std::vector<StoreRun> &Runs );
+    bool        CompactLevel ( const std::vector<StoreRun> &Runs,
+                               int                          nLevel );
+
+    std::string m_sDir;
+};
+
+#endif // RUNSTORE_H
@@ -0,0 +1,469 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          samplecount
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Draws a random sample of the values of a count file
+ *
+ * Description:
+ *    samplecount reads a count file and draws K of its values at
+ *    random, each with probability proportional to its count (or all
+ *    equally likely, with -u), in a single pass and in memory
+ *    proportional to K, however long the input or large its counts.
+ *
+ *    Without replacement, the sample is kept in a weighted reservoir:
+ *    each value gets the key u^(1/w), for u uniform on (0, 1) and w its
+ *    weight, and the K largest keys are kept (Efraimidis and Spirakis'
+ *    A-Res).  Once the reservoir is full, the weight to skip before the
+ *    next value that enters it is drawn directly, so that most values
+ *    cost one subtraction and no random numbers (A-ExpJ).  Keys are
+ *    kept as logarithms, which do not underflow for large weights.
+ *
+ *    With replacement, the sample is K independent single draws.  A
+ *    single draw over the values seen so far, of total weight W, is
+ *    replaced by a later value only when the running total passes W/u,
+ *    so each draw waits for the next threshold in a heap, and a value
+ *    costs nothing unless it crosses one.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file samplecount.cpp
+ */
+
+#include "config.h"
+#include <getopt.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bincount.h"
+#include "compression.h"
+#include "countreader.h"
+#include "outputfile.h"
+using namespace std;
+
+void
+printHelp()
+{
+    cout << "samplecount - " << PACKAGE_STRING << endl << endl;
+    cout << "samplecount draws a random sample of K values from a count file, each" << endl;
+    cout << "value being drawn with probability proportional to its count, and" << endl;
+    cout << "outputs them to standard output (or to the file OUTPUT, if this is" << endl;
+    cout << "specified).  If INPUT is not specified, or is given as the character" << endl;
+    cout << "\"-\", samplecount will read from standard input.  INPUT may also be a" << endl;
+    cout << "binary count file.  Values with a count of zero or less are never drawn." << endl;
+    cout << endl;
+    cout << "Without replacement, the output holds K distinct values (or all of" << endl;
+    cout << "them, if there are fewer) with their counts from INPUT.  With -r, the" << endl;
+    cout << "output is the count file of K independent draws: each value drawn, with" << endl;
+    cout << "the number of times it was drawn.  Either way, the output is sorted in" << endl;
+    cout << "alphabetical order of value." << endl;
+    cout << endl;
+    cout << "Syntax:" << endl;
+    cout << endl;
+    cout << "   samplecount [OPTIONS] K [INPUT [OUTPUT]]" << endl;
+    cout << endl;
+    cout << "Options:" << endl;
+    cout << endl;
+    cout << "   -b      write a binary count file (see countconv)" << endl;
+    cout << "   -d      interpret counts as floating-point numbers" << endl;
+    cout << "   -r      draw with replacement" << endl;
+    cout << "   -s SEED seed the random number generator with SEED, to draw the" << endl;
+    cout << "           same sample every time (default: a random seed)" << endl;
+    cout << "   -u      draw every value with the same probability, whatever" << endl;
+    cout << "           its count" << endl;
+    cout << "   -z FORMAT" << endl;
+    cout << "           compress the output with FORMAT: gzip, xz or zstd" << endl;
+    cout << "   -?      display this help message" << endl;
+}
+
+/**
+ * A value in the sample, with its count from the input.
+ */
+struct SampledValue
+{
+    string    sValue;
+    long long nCount;
+    double    nFloatCount;
+
+    void
+    Assign ( const CountReader &input )
+    {
+        sValue.assign(input.Value.data(), input.Value.size());
+        nCount      = input.nCount;
+        nFloatCount = input.nFloatCount;
+    }
+};
+
+/**
+ * Returns a number drawn uniformly from the open interval (0, 1).
+ */
+inline double
+Uniform ( mt19937_64 &Random )
+{
+    return ((Random() >> 11) + 0.5) * 0x1.0p-53;
+}
+
+/**
+ * Keeps K values drawn without replacement (A-ExpJ).
+ */
+class WeightedReservoir
+{
+public:
+    WeightedReservoir ( size_t      nSize,
+                        mt19937_64 &Random )
+        : m_nSize(nSize), m_Random(Random), m_nSkip(0)
+    {
+    }
+
+    void
+    Add ( const CountReader &input,
+          double             nWeight )
+    {
+        if (!(nWeight > 0))
+            return;
+        if (m_Heap.size() < m_nSize)
+        {
+            Insert(input, log(Uniform(m_Random)) / nWeight);
+            if (m_Heap.size() == m_nSize)
+                m_nSkip = NextSkip();
+            return;
+        }
+        m_nSkip -= nWeight;
+        if (m_nSkip > 0)
+            return;
+        // the value replaces the smallest key, with a key drawn from
+        // above it: u is uniform on (t^w, 1), for t the smallest key
+        double nLow = exp(nWeight * m_Heap.front().first);
+        double nKey = log(nLow + (1 - nLow) * Uniform(m_Random)) / nWeight;
+        pop_heap(m_Heap.begin(), m_Heap.end(), KeyAbove);
+        m_Heap.pop_back();
+        Insert(input, nKey);
+        m_nSkip = NextSkip();
+    }
+
+    /**
+     * Moves the sample into Values.
+     */
+    void
+    TakeSample ( vector<SampledValue> &Values )
+    {
+        Values.clear();
+        for ( size_t i = 0; i < m_Heap.size(); i++ )
+            Values.push_back(std::move(m_Heap[i].second));
+        m_Heap.clear();
+    }
+
+private:
+    typedef pair<double, SampledValue> Entry;
+
+    /**
+     * Orders the heap with the smallest key on top.
+     */
+    static bool
+    KeyAbove ( const Entry &a,
+               const Entry &b )
+    {
+        return a.first > b.first;
+    }
+
+    void
+    Insert ( const CountReader &input,
+             double             nKey )
+    {
+        m_Heap.emplace_back();
+        m_Heap.back().first = nKey;
+        m_Heap.back().second.Assign(input);
+        push_heap(m_Heap.begin(), m_Heap.end(), KeyAbove);
+    }
+
+    /**
+     * The weight to skip before the next value enters the reservoir:
+     * log(u) / log(t), for t the smallest key.
+     */
+    double
+    NextSkip ()
+    {
+        return log(Uniform(m_Random)) / m_Heap.front().first;
+    }
+
+    size_t          m_nSize;
+    mt19937_64     &m_Random;
+    vector<Entry>   m_Heap;
+    double          m_nSkip;
+};
+
+/**
+ * Keeps K independent draws, i.e. a sample with replacement.
+ */
+class ReplacementSample
+{
+public:
+    ReplacementSample ( size_t      nSize,
+                        mt19937_64 &Random )
+        : m_Random(Random), m_Draws(nSize), m_nTotal(0)
+    {
+        // every draw takes the first value of positive weight
+        for ( size_t i = 0; i < nSize; i++ )
+            m_Thresholds.emplace_back(0, i);
+    }
+
+    void
+    Add ( const CountReader &input,
+          double             nWeight )
+    {
+        if (!(nWeight > 0) || m_Draws.empty())
+            return;
+        m_nTotal += nWeight;
+        // a draw over total weight W is kept until the total passes
+        // W / u, for u uniform on (0, 1)
+        while (m_Thresholds.front().first <= m_nTotal)
+        {
+            pop_heap(m_Thresholds.begin(), m_Thresholds.end(), ThresholdAbove);
+            size_t nDraw = m_Thresholds.back().second;
+            m_Draws[nDraw].Assign(input);
+            m_Thresholds.back().first = m_nTotal / Uniform(m_Random);
+            push_heap(m_Thresholds.begin(), m_Thresholds.end(),
+                      ThresholdAbove);
+        }
+    }
+
+    /**
+     * Moves the draws into Values, or leaves it empty if there was
+     * nothing to draw.
+     */
+    void
+    TakeSample ( vector<SampledValue> &Values )
+    {
+        Values.clear();
+        if (m_nTotal > 0)
+            Values.swap(m_Draws);
+    }
+
+private:
+    typedef pair<double, size_t> Threshold;
+
+    static bool
+    ThresholdAbove ( const Threshold &a,
+                     const Threshold &b )
+    {
+        return a.first > b.first;
+    }
+
+    mt19937_64           &m_Random;
+    vector<SampledValue>  m_Draws;
+    vector<Threshold>     m_Thresholds;
+    double                m_nTotal;
+};
+
+/**
+ * Feeds every record of input with a positive count to Sampler,
+ * weighted by its count, or equally if fUniform is set.  Returns false
+ * if the input is malformed, or if a count or the total of the counts
+ * is too large to sample by.
+ */
+template<typename TSampler>
+bool
+sampleCounts ( CountReader &input,
+               bool         fFloatingPoint,
+               bool         fUniform,
+               TSampler    &Sampler )
+{
+    double nTotal = 0;
+    while (input.Next())
+    {
+        double nWeight = fFloatingPoint ? input.nFloatCount :
+            static_cast<double>(input.nCount);
+        if (!(nWeight > 0))
+            continue;
+        if (fUniform)
+            nWeight = 1.0;
+        nTotal += nWeight;
+        if (!isfinite(nTotal))
+        {
+            cerr << input.Name() << ":" << input.LineNumber()
+                 << ": error: counts too large to sample" << endl;
+            return false;
+        }
+        Sampler.Add(input, nWeight);
+    }
+    return !input.Failed();
+}
+
+/**
+ * Writes one record of output: as a text line to output, or to
+ * binaryOutput if it is set.
+ */
+inline void
+WriteCount ( OutputFile        &output,
+             BinaryCountWriter *binaryOutput,
+             bool               fFloatingPoint,
+             long long          nCount,
+             double             nFloatCount,
+             string_view        Value )
+{
+    if (binaryOutput)
+        binaryOutput->Write(Value, nCount, nFloatCount);
+    else if (fFloatingPoint)
+        output.WriteRecord(nFloatCount, Value);
+    else
+        output.WriteRecord(nCount, Value);
+}
+
+int main ( int argc, char **argv )
+{
+    bool        fBinaryOutput      = false;
+    bool        fFloatingPoint     = false;
+    bool        fReplacement       = false;
+    bool        fUniform           = false;
+    bool        fSeed              = false;
+    uint64_t    nSeed              = 0;
+    Compression OutputCompression  = COMPRESSION_NONE;
+    int         c;
+    while ((c = getopt(argc, argv, "bdrs:uz:?")) != -1)
+    {
+        switch(c)
+        {
+        case 'b':
+            fBinaryOutput = true;
+            break;
+        case 'd':
+            fFloatingPoint = true;
+            break;
+        case 'r':
+            fReplacement = true;
+            break;
+        case 's':
+        {
+            istringstream iss(optarg);
+            iss >> nSeed;
+            if (iss.fail() || !iss.eof())
+            {
+                cerr << "ERROR: Invalid seed " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            fSeed = true;
+            break;
+        }
+        case 'u':
+            fUniform = true;
+            break;
+        case 'z':
+            if (!ParseCompression(optarg, OutputCompression))
+                exit(1);
+            break;
+        case '?':
+            printHelp();
+            exit(1);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if ((argc - optind) < 1)
+    {
+        cerr << "ERROR: Missing sample size argument." << endl;
+        printHelp();
+        exit(1);
+    }
+    long long     nSize = 0;
+    istringstream iss(argv[optind]);
+    iss >> nSize;
+    if (iss.fail() || !iss.eof() || nSize <= 0)
+    {
+        cerr << "ERROR: Invalid sample size " << argv[optind] << endl;
+        printHelp();
+        exit(1);
+    }
+    optind++;
+    string sInputFileName  = (argc - optind) >= 1 ? argv[optind++] : "-";
+    string sOutputFileName = (argc - optind) >= 1 ? argv[optind] : "-";
+
+    CountReader input;
+    if (!input.Open(sInputFileName))
+    {
+        cerr << "ERROR: Could not open file " << sInputFileName << endl;
+        exit(1);
+    }
+    input.SetFloatingPoint(fFloatingPoint);
+    OutputFile output;
+    if (!output.Open(sOutputFileName, OutputCompression))
+    {
+        cerr << "ERROR: Could not open file " << sOutputFileName << endl;
+        exit(1);
+    }
+
+    if (!fSeed)
+        nSeed = (static_cast<uint64_t>(random_device()()) << 32) ^
+                random_device()();
+    mt19937_64           Random(nSeed);
+    vector<SampledValue> Values;
+    bool                 fOk;
+    if (fReplacement)
+    {
+        ReplacementSample Sampler(nSize, Random);
+        fOk = sampleCounts(input, fFloatingPoint, fUniform, Sampler);
+        Sampler.TakeSample(Values);
+    }
+    else
+    {
+        WeightedReservoir Sampler(nSize, Random);
+        fOk = sampleCounts(input, fFloatingPoint, fUniform, Sampler);
+        Sampler.TakeSample(Values);
+    }
+    if (!fOk)
+    {
+        output.Close();
+        exit(1);
+    }
+
+    sort(Values.begin(), Values.end(),
+         [](const SampledValue &a, const SampledValue &b)
+         {
+             return a.sValue < b.sValue;
+         });
+    BinaryCountWriter *binaryOutput = 0;
+    if (fBinaryOutput)
+        binaryOutput = new BinaryCountWriter(output, fFloatingPoint);
+    for ( size_t i = 0; i < Values.size(); )
+    {
+        // with replacement, a value drawn n times is written once, with
+        // a count of n
+        size_t j = i + 1;
+        while (fReplacement && j < Values.size() &&
+               Values[j].sValue == Values[i].sValue)
+            j++;
+        if (fReplacement)
+            WriteCount(output, binaryOutput, fFloatingPoint, j - i, j - i,
+                       Values[i].sValue);
+        else
+            WriteCount(output, binaryOutput, fFloatingPoint,
+                       Values[i].nCount, Values[i].nFloatCount,
+                       Values[i].sValue);
+        i = j;
+    }
+    if (binaryOutput)
+        binaryOutput->Finish();
+    delete binaryOutput;
+    if (!output.Close())
+    {
+        cerr << "ERROR: Could not write file " << output.Name() << endl;
+        exit(1);
+    }
+
+    return 0;
+}
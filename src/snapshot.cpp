@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          snapshot
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Periodic snapshots of the counts of a running count
+ *
+ * Description:
+ *    Implementation of SnapshotWriter.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file snapshot.cpp
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "bincount.h"
+#include "outputfile.h"
+#include "snapshot.h"
+using namespace std;
+
+SnapshotWriter::SnapshotWriter ( const SnapshotSettings &Settings )
+    : m_Settings(Settings), m_pPending(0), m_fBusy(false), m_fDone(false),
+      m_fFailed(false), m_nSequence(0)
+{
+    m_Thread = thread(&SnapshotWriter::Run, this);
+}
+
+SnapshotWriter::~SnapshotWriter ()
+{
+    Finish();
+}
+
+void
+SnapshotWriter::Submit ( Table *pDelta )
+{
+    unique_lock<mutex> lock(m_Lock);
+    m_Changed.wait(lock, [this] { return !m_fBusy; });
+    m_pPending = pDelta;
+    m_fBusy    = true;
+    m_Changed.notify_all();
+}
+
+bool
+SnapshotWriter::Finish ()
+{
+    {
+        unique_lock<mutex> lock(m_Lock);
+        m_Changed.wait(lock, [this] { return !m_fBusy; });
+        m_fDone = true;
+        m_Changed.notify_all();
+    }
+    if (m_Thread.joinable())
+        m_Thread.join();
+    return !m_fFailed;
+}
+
+void
+SnapshotWriter::Run ()
+{
+    unique_lock<mutex> lock(m_Lock);
+    while (true)
+    {
+        m_Changed.wait(lock, [this] { return m_pPending || m_fDone; });
+        if (!m_pPending)
+            break;
+        unique_ptr<Table> pDelta(m_pPending);
+        m_pPending = 0;
+        lock.unlock();
+        Write(*pDelta);
+        pDelta.reset();
+        lock.lock();
+        m_fBusy = false;
+        m_Changed.notify_all();
+    }
+}
+
+void
+SnapshotWriter::Write ( const Table &Delta )
+{
+    if (!m_Settings.fDelta)
+        m_Total.Merge(Delta);
+
+    string sFileName = m_Settings.sPrefix + "." + to_string(++m_nSequence);
+    string sTempName = sFileName + ".tmp";
+    bool   fOk       = false;
+    {
+        OutputFile output;
+        if (output.Open(sTempName))
+        {
+            BinaryCountWriter *binaryOutput = 0;
+            if (m_Settings.fBinary)
+                binaryOutput = new BinaryCountWriter(output, false);
+            vector<const Table::Entry *> Entries;
+            (m_Settings.fDelta ? Delta : m_Total).SortedEntries(Entries);
+            for ( size_t i = 0; i < Entries.size(); i++ )
+            {
+                if (binaryOutput)
+                    binaryOutput->Write(Entries[i]->Key(),
+                                        Entries[i]->nCount, 0);
+                else
+                    output.WriteRecord(Entries[i]->nCount,
+                                       Entries[i]->Key());
+            }
+            if (binaryOutput)
+                binaryOutput->Finish();
+            delete binaryOutput;
+            fOk = output.Close() &&
+                  rename(sTempName.c_str(), sFileName.c_str()) == 0;
+        }
+    }
+    if (!fOk)
+    {
+        cerr << "ERROR: Could not write snapshot " << sFileName << endl;
+        unlink(sTempName.c_str());
+        m_fFailed = true;
+    }
+
+    if (m_Settings.fDelta)
+        m_Total.Merge(Delta);
+    if (m_Settings.nKeep && m_nSequence > m_Settings.nKeep)
+    {
+        string sOldName = m_Settings.sPrefix + "." +
+                          to_string(m_nSequence - m_Settings.nKeep);
+        unlink(sOldName.c_str());
+    }
+}
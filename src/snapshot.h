@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          snapshot
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Periodic snapshots of the counts of a running count
+ *
+ * Description:
+ *    SnapshotWriter writes snapshots of the counts so far while count
+ *    is still reading an unbounded stream.  The counting thread never
+ *    waits for a snapshot to be written: it hands the table of counts
+ *    gathered since the last snapshot to the writer thread, and simply
+ *    carries on counting into a fresh table.  The writer thread adds
+ *    each such table into the running total, which only it touches,
+ *    and writes out either the total (a full snapshot) or just the
+ *    handed-over table (a delta snapshot).  If the writer is still busy
+ *    when the next snapshot is due, the counting thread keeps counting
+ *    into its table and hands it over as soon as the writer is free.
+ *
+ *    Snapshots are sorted count files named PREFIX.1, PREFIX.2, ...,
+ *    each written under a temporary name and renamed into place once
+ *    complete, so that a reader never sees a partial snapshot.  Only
+ *    the most recent few are kept, if asked.  Delta snapshots can be
+ *    summed with addcount to give the full counts.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file snapshot.h
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "counttable.h"
+
+struct SnapshotSettings
+{
+    std::string sPrefix;        // snapshot files are sPrefix.N
+    double      nSeconds;       // snapshot interval, or 0
+    long long   nLines;         // lines between snapshots, or 0
+    bool        fDelta;         // write only the counts since the last
+    bool        fBinary;        // write binary count files
+    size_t      nKeep;          // number of snapshots kept, or 0 for all
+};
+
+class SnapshotWriter
+{
+public:
+    typedef HashCountTable<long long> Table;
+
+    explicit SnapshotWriter ( const SnapshotSettings &Settings );
+    ~SnapshotWriter ();
+
+    SnapshotWriter ( const SnapshotWriter & ) = delete;
+    SnapshotWriter &operator= ( const SnapshotWriter & ) = delete;
+
+    /**
+     * Returns true if the writer has finished the last snapshot, so
+     * that Submit() would not wait.
+     */
+    bool
+    Ready () const
+    {
+        return !m_fBusy;
+    }
+
+    /**
+     * Hands pDelta, the counts since the last snapshot, over to the
+     * writer thread, which deletes it once written; waits first if the
+     * writer is still busy.
+     */
+    void Submit ( Table *pDelta );
+
+    /**
+     * Waits for the last snapshot and stops the writer thread.  Returns
+     * false if any snapshot could not be written.
+     */
+    bool Finish ();
+
+    /**
+     * The sum of all of the submitted counts; only valid after Finish().
+     */
+    Table &
+    Total ()
+    {
+        return m_Total;
+    }
+
+private:
+    void Run ();
+    void Write ( const Table &Delta );
+
+    SnapshotSettings        m_Settings;
+    Table                   m_Total;
+    std::mutex              m_Lock;
+    std::condition_variable m_Changed;
+    Table                  *m_pPending;
+    std::atomic<bool>       m_fBusy;
+    bool                    m_fDone;
+    bool                    m_fFailed;
+    size_t                  m_nSequence;
+    std::thread             m_Thread;
+};
+
+#endif // SNAPSHOT_H
@@ -21,6 +21,25 @@
  *    (WKR) 15 May 2014
  *          - Initial version.
  *
+ *    (WKR) 17 October 2026
+ *          - Sum into arena-backed hash tables instead of std::maps;
+ *            add -S to spill sorted runs to disk under a memory
+ *            budget, merging them at the end.
+ *          - Add -k K for the K highest counts; -f now lists every
+ *            value, breaking ties in count alphabetically, instead of
+ *            only the first value with each count.
+ *          - Binary count files are read transparently; -b writes
+ *            binary output.
+ *          - Read the input with CountReader.
+ *          - Write the output through a buffered OutputFile.
+ *          - -j N sums by sorting instead of hashing, with a parallel
+ *            radix sort on N threads.
+ *          - Read compressed inputs; add -z to compress the output.
+ *          - Add --stats, --stats-json and --progress.
+ *          - -S can be combined with -f and -k: the merged counts are
+ *            sorted by count with CountOrderSorter.
+ *          - Add --trie to sum into a TrieCountTable.
+ *
  * \file sortalph.cpp
  */
 
@@ -28,11 +47,21 @@
 
 #include "config.h"
 #include <getopt.h>
+#include <stdlib.h>
 #include <algorithm>
-#include <fstream>
 #include <sstream>
 #include <iostream>
-#include <map>
+#include <type_traits>
+#include <vector>
+#include "compression.h"
+#include "countorder.h"
+#include "countreader.h"
+#include "countrun.h"
+#include "counttable.h"
+#include "outputfile.h"
+#include "sortcounttable.h"
+#include "toolstats.h"
+#include "trietable.h"
 using namespace std;
 
 void
@@ -45,7 +74,7 @@ printHelp()
     cout << "input count file INPUT contains at least two tab-separated columns;" << endl;
     cout << "the first specifying the count and the second the value.  If INPUT is" << endl;
     cout << "not specified, or is given as the character \"-\", sortalph will read " << endl;
-    cout << "from standard input." << endl;
+    cout << "from standard input.  INPUT may also be a binary count file." << endl;
     cout << endl;
     cout << "Syntax:" << endl;
     cout << endl;
@@ -53,99 +82,287 @@ printHelp()
     cout << endl;
     cout << "Options:" << endl;
     cout << endl;
-    cout << "   -f      sort output in order of descending frequency" << endl;
+    cout << "   -b      write a binary count file (see countconv)" << endl;
+    cout << "   -f      sort output in order of descending frequency; values" << endl;
+    cout << "           with equal counts are in alphabetical order" << endl;
+    cout << "   -k K    output only the K values with the highest counts" << endl;
+    cout << "           (implies -f)" << endl;
     cout << "   -d      interpret counts as floating-point numbers" << endl;
+    cout << "   -j N    sum by sorting all of the records with a radix sort on N" << endl;
+    cout << "           threads, instead of with a hash table; cannot be combined" << endl;
+    cout << "           with -S" << endl;
+    cout << "   -S SIZE use at most about SIZE bytes of memory (e.g. 512M, 4G)" << endl;
+    cout << "           for the table, spilling sorted runs to disk when it" << endl;
+    cout << "           is full; with -f or -k, the merged counts are sorted in" << endl;
+    cout << "           runs of about SIZE bytes too" << endl;
+    cout << "   -T DIR  write temporary runs under DIR (default $TMPDIR or /tmp)" << endl;
+    cout << "   --trie  sum in a trie that stores prefixes shared by values only" << endl;
+    cout << "           once, and is written out in order without sorting;" << endl;
+    cout << "           much smaller on values such as URLs and file paths" << endl;
+    cout << "   -z FORMAT" << endl;
+    cout << "           compress the output with FORMAT: gzip, xz or zstd" << endl;
+    cout << "   --stats print statistics of the run to standard error: lines and" << endl;
+    cout << "           bytes read, distinct values, time in each phase, table" << endl;
+    cout << "           size, heap allocations and peak memory" << endl;
+    cout << "   --stats-json FILE" << endl;
+    cout << "           write the statistics to FILE as a JSON object" << endl;
+    cout << "   --progress SECONDS" << endl;
+    cout << "           print the input read so far to standard error every" << endl;
+    cout << "           SECONDS seconds" << endl;
     cout << "   -?      display this help message" << endl;
 }
 
+/**
+ * Writes one record of output: as a text line to output, or to
+ * binaryOutput if it is set.
+ */
+template<typename TCount>
+void
+WriteCount ( OutputFile        &output,
+             BinaryCountWriter *binaryOutput,
+             TCount             nCount,
+             string_view        Value )
+{
+    if (binaryOutput)
+        binaryOutput->Write(Value, static_cast<long long>(nCount),
+                            static_cast<double>(nCount));
+    else
+        output.WriteRecord(nCount, Value);
+}
+
+/**
+ * Writes LineDict (a HashCountTable or a SortCountTable) in
+ * alphabetical order or, if fSortDecreasingFreq is set, the nTopK
+ * highest counts (all of them, if nTopK is zero) in descending order.
+ */
+template<typename TTable>
+void
+WriteCounts ( TTable            &LineDict,
+              bool               fSortDecreasingFreq,
+              size_t             nTopK,
+              OutputFile        &output,
+              BinaryCountWriter *binaryOutput,
+              ToolStats         &Stats )
+{
+    Stats.Phase("sort");
+    vector<const typename TTable::Entry *> Entries;
+    if (fSortDecreasingFreq)
+        LineDict.TopEntries(nTopK, Entries);
+    else
+        LineDict.SortedEntries(Entries);
+    Stats.Phase("write");
+    for ( size_t i = 0; i < Entries.size(); i++ )
+    {
+        WriteCount(output, binaryOutput, Entries[i]->nCount,
+                   Entries[i]->Key());
+    }
+}
+
+/**
+ * Writes a TrieCountTable as WriteCounts() does above: walking the trie
+ * gives alphabetical order without sorting, and -f sorts that order
+ * stably by count.
+ */
+template<typename TCount>
 void
-cleanup ( ifstream *inputFile,
-          ofstream *outputFile )
+WriteCounts ( TrieCountTable<TCount> &LineDict,
+              bool                    fSortDecreasingFreq,
+              size_t                  nTopK,
+              OutputFile             &output,
+              BinaryCountWriter      *binaryOutput,
+              ToolStats              &Stats )
 {
-    if (inputFile)
+    typename TrieCountTable<TCount>::Cursor cursor(LineDict);
+    if (!fSortDecreasingFreq)
     {
-        inputFile->close();
-        delete inputFile;
-        inputFile = 0;
+        Stats.Phase("write");
+        while (cursor.Next())
+            WriteCount(output, binaryOutput, cursor.Count(), cursor.Key());
+        return;
     }
-    if (outputFile)
+    Stats.Phase("sort");
+    bool             fFloatingPoint = is_same<TCount, double>::value;
+    CountOrderSorter sorter(fFloatingPoint, 0, "");
+    while (cursor.Next())
     {
-        outputFile->close();
-        delete outputFile;
-        outputFile = 0;
+        sorter.Add(static_cast<long long>(cursor.Count()),
+                   static_cast<double>(cursor.Count()), cursor.Key());
     }
+    Stats.Phase("write");
+    sorter.Write(nTopK,
+                 [fFloatingPoint, &output, binaryOutput](long long   nCount,
+                                                         double      nFloatCount,
+                                                         string_view Value)
+                 {
+                     if (fFloatingPoint)
+                         WriteCount(output, binaryOutput, nFloatCount, Value);
+                     else
+                         WriteCount(output, binaryOutput, nCount, Value);
+                 });
 }
 
+/**
+ * Reads all of input into a SortCountTable, sorts it on nThreads
+ * threads and writes it out as WriteCounts() does.  Values of a mapped
+ * input are not copied.  Returns false if the input is malformed.
+ */
+template<typename TCount>
 bool
-ReadCountLine ( const string &sFileName,
-                ifstream     *inputFile,
-                bool          fFloatingPoint,
-                bool         &fDidRead,
-                int          &nLinesRead,
-                int          &nCount,
-                double       &nFloatCount,
-                string       &sValue )
+SortAndWriteCounts ( CountReader       &input,
+                     int                nThreads,
+                     bool               fSortDecreasingFreq,
+                     size_t             nTopK,
+                     OutputFile        &output,
+                     BinaryCountWriter *binaryOutput,
+                     ToolStats         &Stats )
 {
-    fDidRead     = false;
-    string sLine = "";
-    if ((inputFile && *inputFile) ||
-        (!inputFile && cin))
+    SortCountTable<TCount> LineDict;
+    bool                   fBorrow = input.IsMapped();
+    while (input.Next())
     {
-        fDidRead    = true;
-        nLinesRead += 1;
-        if (inputFile)
-            getline ( *inputFile, sLine );
-        else
-            getline ( cin, sLine );
-        if (((inputFile && !*inputFile) ||
-             (!inputFile && !cin)) && sLine.length() == 0)
-        {
-            fDidRead = false;
-            return false;
-        }
-        size_t nFirstTab = sLine.find_first_of('\t');
-        if (nFirstTab == string::npos)
-        {
-            sValue    = "";
-            nFirstTab = sLine.length();
-        }
+        TCount nCount = static_cast<TCount>(input.nCount);
+        if (is_same<TCount, double>::value)
+            nCount = input.nFloatCount;
+        if (fBorrow)
+            LineDict.AddBorrowed(input.Value.data(), input.Value.length(),
+                                 nCount);
         else
-        {
-            sValue = sLine.substr(nFirstTab + 1);
-        }
-        istringstream iss(sLine.substr(0, nFirstTab));
-        if (fFloatingPoint)
-        {
-            iss >> nFloatCount;
-        }
-        else
-        {
-            iss >> nCount;
-        }
-        if (iss.fail())
-        {
-            cerr << sFileName << ":" << nLinesRead
-                 << ": error: could not read count field" << endl;
-            return true;
-        }
+            LineDict.Add(input.Value.data(), input.Value.length(), nCount);
     }
+    if (input.Failed())
+        return false;
+    Stats.Phase("sort");
+    LineDict.Sort(nThreads);
+    Stats.Set("distinct_keys", LineDict.size());
+    WriteCounts(LineDict, fSortDecreasingFreq, nTopK, output, binaryOutput,
+                Stats);
+    return true;
+}
 
-    return false;
+template<typename TCount>
+CountStream *
+NewTableStream ( const HashCountTable<TCount> &LineDict )
+{
+    return new TableStream<TCount>(LineDict);
 }
 
-template<typename A, typename B>
-pair<B,A> flip_pair(const pair<A,B> &p)
+template<typename TCount>
+CountStream *
+NewTableStream ( const TrieCountTable<TCount> &LineDict )
 {
-    return pair<B,A>(p.second, p.first);
+    return new TrieStream<TCount>(LineDict);
 }
 
-template<typename A, typename B>
-map<B,A> flip_map(const map<A,B> &src)
+/**
+ * Merges the spilled runs with the rest of LineDict into output or, if
+ * pSorter is set, into pSorter, to be written in order of count.
+ */
+template<typename TTable>
+bool
+WriteMergedCounts ( RunSpiller        &spiller,
+                    TTable            &LineDict,
+                    bool               fFloatingPoint,
+                    CountOrderSorter  *pSorter,
+                    OutputFile        &output,
+                    BinaryCountWriter *binaryOutput )
 {
-    map<B,A> dst;
-    transform(src.begin(), src.end(), inserter(dst, dst.begin()),
-              flip_pair<A,B>);
-    return dst;
+    if (!spiller.Consolidate(MAX_MERGE_FAN_IN))
+        return false;
+    vector<CountStream *> Streams;
+    for ( size_t i = 0; i < spiller.Runs().size(); i++ )
+        Streams.push_back(new CountFileStream(spiller.Runs()[i],
+                                              fFloatingPoint));
+    Streams.push_back(NewTableStream(LineDict));
+    bool fSortOk = true;
+    bool fOk     = MergeCountStreams(
+        Streams, fFloatingPoint,
+        [&](long long   nCount,
+            double      nFloatCount,
+            string_view Value)
+        {
+            if (pSorter)
+            {
+                if (fSortOk)
+                    fSortOk = pSorter->Add(nCount, nFloatCount, Value);
+            }
+            else if (fFloatingPoint)
+                WriteCount(output, binaryOutput, nFloatCount, Value);
+            else
+                WriteCount(output, binaryOutput, nCount, Value);
+        });
+    for ( size_t i = 0; i < Streams.size(); i++ )
+        delete Streams[i];
+    return fOk && fSortOk;
+}
+
+/**
+ * Sums input into LineDict (a HashCountTable or a TrieCountTable),
+ * spilling it to a run whenever it reaches nMemoryBudget bytes (if that
+ * is not zero), and writes the sums as WriteCounts() does, merging them
+ * with the runs if there are any.  Returns false if the input is
+ * malformed, or the runs could not be written or merged.
+ */
+template<typename TCount, typename TTable>
+bool
+SumAndWriteCounts ( CountReader       &input,
+                    TTable            &LineDict,
+                    RunSpiller        &spiller,
+                    size_t             nMemoryBudget,
+                    const string      &sTempDir,
+                    bool               fSortDecreasingFreq,
+                    size_t             nTopK,
+                    OutputFile        &output,
+                    BinaryCountWriter *binaryOutput,
+                    ToolStats         &Stats )
+{
+    bool fFloatingPoint = is_same<TCount, double>::value;
+    while (input.Next())
+    {
+        TCount nCount = static_cast<TCount>(input.nCount);
+        if (fFloatingPoint)
+            nCount = input.nFloatCount;
+        LineDict.Add(input.Value.data(), input.Value.length(), nCount);
+        if (nMemoryBudget && LineDict.MemoryUsage() >= nMemoryBudget &&
+            !spiller.Spill(LineDict))
+        {
+            return false;
+        }
+    }
+    if (input.Failed())
+        return false;
+
+    if (spiller.Runs().empty())
+    {
+        Stats.SetTable(LineDict);
+        WriteCounts(LineDict, fSortDecreasingFreq, nTopK, output,
+                    binaryOutput, Stats);
+        return true;
+    }
+    Stats.Phase("merge");
+    Stats.Set("runs_spilled", spiller.Runs().size());
+    // the merged counts come out alphabetically, so sorting them stably
+    // by count breaks ties alphabetically, as -f does
+    CountOrderSorter  sorter(fFloatingPoint, nMemoryBudget, sTempDir);
+    CountOrderSorter *pSorter  = fSortDecreasingFreq ? &sorter : 0;
+    bool              fMergeOk = WriteMergedCounts(spiller, LineDict,
+                                                   fFloatingPoint, pSorter,
+                                                   output, binaryOutput);
+    if (fMergeOk && pSorter)
+    {
+        Stats.Phase("sort");
+        fMergeOk = sorter.Write(
+            nTopK,
+            [fFloatingPoint, &output, binaryOutput](long long   nCount,
+                                                    double      nFloatCount,
+                                                    string_view Value)
+            {
+                if (fFloatingPoint)
+                    WriteCount(output, binaryOutput, nFloatCount, Value);
+                else
+                    WriteCount(output, binaryOutput, nCount, Value);
+            });
+    }
+    return fMergeOk;
 }
 
 int main ( int argc, char **argv )
@@ -156,17 +373,87 @@ int main ( int argc, char **argv )
 
     bool       fFloatingPoint      = false;
     bool       fSortDecreasingFreq = false;
+    bool       fBinaryOutput       = false;
+    size_t     nMemoryBudget       = 0;
+    string     sTempDir            = "";
+    size_t     nTopK               = 0;
+    int        nThreads            = 0;
+    bool       fTrie               = false;
+    Compression OutputCompression  = COMPRESSION_NONE;
+    ToolStats  Stats("sortalph");
     int        c;
-    while ((c = getopt(argc, argv, "df?")) != -1)
+    static const struct option LongOptions[] =
+    {
+        { "stats",      no_argument,       0, STATS_OPTION },
+        { "stats-json", required_argument, 0, STATS_JSON_OPTION },
+        { "progress",   required_argument, 0, PROGRESS_OPTION },
+        { "trie",       no_argument,       0, 'R' },
+        { 0,            0,                 0, 0 }
+    };
+    while ((c = getopt_long(argc, argv, "bdfj:k:S:T:z:?", LongOptions,
+                            0)) != -1)
     {
         switch(c)
         {
+        case 'b':
+            fBinaryOutput = true;
+            break;
         case 'd':
             fFloatingPoint = true;
             break;
         case 'f':
             fSortDecreasingFreq = true;
             break;
+        case 'j':
+            nThreads = atoi(optarg);
+            if (nThreads < 1)
+            {
+                cerr << "ERROR: -j needs a positive number of threads" << endl;
+                exit(1);
+            }
+            break;
+        case 'k':
+        {
+            long long     nValue = 0;
+            istringstream iss(optarg);
+            iss >> nValue;
+            if (iss.fail() || nValue <= 0)
+            {
+                cerr << "ERROR: Invalid number of values " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            nTopK               = nValue;
+            fSortDecreasingFreq = true;
+            break;
+        }
+        case 'S':
+            if (!ParseMemorySize(optarg, nMemoryBudget))
+            {
+                cerr << "ERROR: Invalid memory size " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            break;
+        case 'T':
+            sTempDir = optarg;
+            break;
+        case 'R':
+            fTrie = true;
+            break;
+        case 'z':
+            if (!ParseCompression(optarg, OutputCompression))
+                exit(1);
+            break;
+        case STATS_OPTION:
+        case STATS_JSON_OPTION:
+        case PROGRESS_OPTION:
+            if (!Stats.ParseOption(c, optarg))
+            {
+                printHelp();
+                exit(1);
+            }
+            break;
         case '?':
             printHelp();
             exit(1);
@@ -176,11 +463,22 @@ int main ( int argc, char **argv )
         }
     }
 
-    string    sInputFileName  = "";
-    string    sOutputFileName = "";
+    if (nMemoryBudget && nThreads)
+    {
+        cerr << "ERROR: -S cannot be combined with -j" << endl;
+        exit(1);
+    }
+    if (fTrie && nThreads)
+    {
+        cerr << "ERROR: --trie cannot be combined with -j" << endl;
+        exit(1);
+    }
+
+    string      sInputFileName  = "";
+    string      sOutputFileName = "";
 
-    ifstream *inputFile       = 0;
-    ofstream *outputFile      = 0;
+    CountReader input;
+    OutputFile  output;
 
     if ((argc - optind) < 1)
     {
@@ -191,157 +489,116 @@ int main ( int argc, char **argv )
         sInputFileName = argv[optind++];
     }
 
-    if (sInputFileName.compare("-") == 0)
-    {
 #ifdef DEBUG
-        cout << "input from stdin" << endl;
+    cout << "input from " << sInputFileName << endl;
 #endif // DEBUG
-        inputFile      = 0;
-        sInputFileName = "<stdin>";
-    }
-    else
+    if (!input.Open(sInputFileName))
     {
-#ifdef DEBUG
-        cout << "input from " << sInputFileName << endl;
-#endif // DEBUG
-        inputFile = new ifstream();
-        inputFile->open(sInputFileName.c_str());
-        if (!*inputFile)
-        {
-            cerr << "ERROR: Could not open file " << sInputFileName << endl;
-            exit(1);
-        }
+        cerr << "ERROR: Could not open file " << sInputFileName << endl;
+        exit(1);
     }
 
     if ((argc - optind) == 0)
     {
-#ifdef DEBUG
-        cout << "output to stdout" << endl;
-#endif // DEBUG
-        outputFile      = 0;
-        sOutputFileName = "<stdout>";
+        sOutputFileName = "-";
     }
     else
     {
         sOutputFileName = argv[optind];
+    }
 #ifdef DEBUG
-        cout << "output to " << sOutputFileName << endl;
+    cout << "output to " << sOutputFileName << endl;
 #endif // DEBUG
-        outputFile = new ofstream(sOutputFileName.c_str());
-        if (!*outputFile)
-        {
-            cerr << "ERROR: Could not open file " << sOutputFileName << endl;
-            cleanup(inputFile, outputFile);
-            exit(1);
-        }
-    }
-
-    int                nLineNum = 0;
-    map<string,int>    LineDict;
-    map<string,double> LineDictFloat;
-    bool               fReadLine;
-    int                nCount;
-    double             nFloatCount;
-    string             sValue;
-
-    if (ReadCountLine ( sInputFileName,
-                        inputFile,
-                        fFloatingPoint,
-                        fReadLine,
-                        nLineNum,
-                        nCount,
-                        nFloatCount,
-                        sValue ))
+    if (!output.Open(sOutputFileName, OutputCompression))
     {
-        cleanup(inputFile, outputFile);
+        cerr << "ERROR: Could not open file " << sOutputFileName << endl;
         exit(1);
     }
 
-#ifdef DEBUG
-    if (fReadLine)
-    {
-        cout << "nCount \"" << nCount << "\"" << endl;
-        cout << "sValue \"" << sValue << "\"" << endl;
-    }
-#endif // DEBUG
+    input.SetFloatingPoint(fFloatingPoint);
+    input.SetAllowMissingTab(true);
+    input.SetStats(&Stats);
+    Stats.Start("read");
 
-    while (fReadLine)
+    if (nThreads)
     {
-        if (fFloatingPoint)
-            LineDictFloat[sValue] += nFloatCount;
-        else
-            LineDict[sValue] += nCount;
-        // process 1
-        if (ReadCountLine ( sInputFileName,
-                            inputFile,
-                            fFloatingPoint,
-                            fReadLine,
-                            nLineNum,
-                            nCount,
-                            nFloatCount,
-                            sValue ))
+        BinaryCountWriter *binaryOutput = 0;
+        if (fBinaryOutput)
+            binaryOutput = new BinaryCountWriter(output, fFloatingPoint);
+        bool fOk = fFloatingPoint ?
+            SortAndWriteCounts<double>(input, nThreads, fSortDecreasingFreq,
+                                       nTopK, output, binaryOutput, Stats) :
+            SortAndWriteCounts<long long>(input, nThreads,
+                                          fSortDecreasingFreq, nTopK, output,
+                                          binaryOutput, Stats);
+        if (!fOk)
         {
-            cleanup(inputFile, outputFile);
+            delete binaryOutput;
+            output.Close();
             exit(1);
         }
-    }
-
-    if (fSortDecreasingFreq)
-    {
-        if (fFloatingPoint)
+        if (binaryOutput)
+            binaryOutput->Finish();
+        delete binaryOutput;
+        if (!output.Close())
         {
-            map<double,string> FlippedLineDictFloat = flip_map(LineDictFloat);
-            for ( map<double,string>::reverse_iterator iterator =
-                      FlippedLineDictFloat.rbegin();
-                  iterator != FlippedLineDictFloat.rend(); iterator++ )
-            {
-                if (outputFile)
-                    *outputFile << iterator->first << "\t" << iterator->second << endl;
-                else
-                    cout << iterator->first << "\t" << iterator->second << endl;
-            }
-        }
-        else
-        {
-            map<int,string> FlippedLineDict = flip_map(LineDict);
-            for ( map<int,string>::reverse_iterator iterator =
-                      FlippedLineDict.rbegin();
-                  iterator != FlippedLineDict.rend(); iterator++ )
-            {
-                if (outputFile)
-                    *outputFile << iterator->first << "\t" << iterator->second << endl;
-                else
-                    cout << iterator->first << "\t" << iterator->second << endl;
-            }
+            cerr << "ERROR: Could not write file " << output.Name() << endl;
+            exit(1);
         }
+        return Stats.Report() ? 0 : 1;
     }
+    HashCountTable<long long> LineDict;
+    HashCountTable<double>    LineDictFloat;
+    TrieCountTable<long long> LineTrie;
+    TrieCountTable<double>    LineTrieFloat;
+    RunSpiller                spiller(sTempDir, fFloatingPoint);
+    if (nMemoryBudget)
+    {
+        nMemoryBudget = TableBudget(nMemoryBudget, 1);
+        LineDict.SetArenaBlockSize(ArenaBlockSizeForBudget(nMemoryBudget));
+        LineDictFloat.SetArenaBlockSize(ArenaBlockSizeForBudget(nMemoryBudget));
+    }
+
+    BinaryCountWriter *binaryOutput = 0;
+    if (fBinaryOutput)
+        binaryOutput = new BinaryCountWriter(output, fFloatingPoint);
+    bool fOk;
+    if (fTrie && fFloatingPoint)
+        fOk = SumAndWriteCounts<double>(input, LineTrieFloat, spiller,
+                                        nMemoryBudget, sTempDir,
+                                        fSortDecreasingFreq, nTopK, output,
+                                        binaryOutput, Stats);
+    else if (fTrie)
+        fOk = SumAndWriteCounts<long long>(input, LineTrie, spiller,
+                                           nMemoryBudget, sTempDir,
+                                           fSortDecreasingFreq, nTopK,
+                                           output, binaryOutput, Stats);
+    else if (fFloatingPoint)
+        fOk = SumAndWriteCounts<double>(input, LineDictFloat, spiller,
+                                        nMemoryBudget, sTempDir,
+                                        fSortDecreasingFreq, nTopK, output,
+                                        binaryOutput, Stats);
     else
+        fOk = SumAndWriteCounts<long long>(input, LineDict, spiller,
+                                           nMemoryBudget, sTempDir,
+                                           fSortDecreasingFreq, nTopK,
+                                           output, binaryOutput, Stats);
+    if (!fOk)
     {
-        if (fFloatingPoint)
-        {
-            for ( map<string,double>::iterator iterator = LineDictFloat.begin();
-                  iterator != LineDictFloat.end(); iterator++ )
-            {
-                if (outputFile)
-                    *outputFile << iterator->second << "\t" << iterator->first << endl;
-                else
-                    cout << iterator->second << "\t" << iterator->first << endl;
-            }
-        }
-        else
-        {
-            for ( map<string,int>::iterator iterator = LineDict.begin();
-                  iterator != LineDict.end(); iterator++ )
-            {
-                if (outputFile)
-                    *outputFile << iterator->second << "\t" << iterator->first << endl;
-                else
-                    cout << iterator->second << "\t" << iterator->first << endl;
-            }
-        }
+        delete binaryOutput;
+        spiller.Remove();
+        output.Close();
+        exit(1);
     }
+    if (binaryOutput)
+        binaryOutput->Finish();
+    delete binaryOutput;
 
-    cleanup(inputFile, outputFile);
+    if (!output.Close())
+    {
+        cerr << "ERROR: Could not write file " << output.Name() << endl;
+        exit(1);
+    }
 
-    return 0;
+    return Stats.Report() ? 0 : 1;
 }
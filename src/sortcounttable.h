@@ -0,0 +1,384 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          sortcounttable
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Sort-based count aggregation
+ *
+ * Description:
+ *    SortCountTable sums counts by sorting rather than hashing: every
+ *    record is appended to a flat array (its key bytes copied into a
+ *    KeyArena, or borrowed from a mapped file), the array is sorted by
+ *    key with an MSD radix sort, and runs of equal keys are then
+ *    collapsed in one linear pass.  Adding a record is just an append,
+ *    with no lookups or per-node allocations, and the sort divides
+ *    into independent buckets that are sorted on several threads.
+ *
+ *    The radix sort is stable, so the counts of equal keys are summed
+ *    in input order, giving exactly the floating-point totals of a
+ *    HashCountTable.  Small buckets are finished with an insertion
+ *    sort, and a byte on which all of a bucket's keys agree is skipped
+ *    without moving anything, so long common prefixes cost little.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Radix sort keeps its buckets on a stack instead of
+ *            recursing, so that chains of prefix keys cannot overflow
+ *            the stack.
+ *
+ * \file sortcounttable.h
+ */
+
+#ifndef SORTCOUNTTABLE_H
+#define SORTCOUNTTABLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "counttable.h"
+
+/**
+ * Buckets smaller than this are sorted by insertion sort.
+ */
+const size_t SORTCOUNT_INSERTION_CUTOFF = 32;
+
+template<typename TCount>
+class SortCountTable
+{
+public:
+    struct Entry
+    {
+        const char *pKey;
+        uint32_t    nLength;
+        TCount      nCount;
+
+        std::string_view
+        Key () const
+        {
+            return std::string_view(pKey, nLength);
+        }
+    };
+
+    SortCountTable ()
+        : m_fSorted(true)
+    {
+    }
+
+    /**
+     * Appends a record, with a copy of its key bytes in the arena.
+     */
+    void
+    Add ( const char *pKey,
+          size_t      nLength,
+          TCount      nCount )
+    {
+        AddBorrowed(nLength ? m_Arena.Store(pKey, nLength) : "", nLength,
+                    nCount);
+    }
+
+    /**
+     * Like Add(), but keeps a pointer to the caller's key bytes rather
+     * than a copy; they must stay valid for the life of the table.
+     */
+    void
+    AddBorrowed ( const char *pKey,
+                  size_t      nLength,
+                  TCount      nCount )
+    {
+        Entry entry;
+        entry.pKey    = pKey;
+        entry.nLength = nLength;
+        entry.nCount  = nCount;
+        m_Entries.push_back(entry);
+        m_fSorted = false;
+    }
+
+    /**
+     * Sorts the records by key on nThreads threads and sums the counts
+     * of equal keys, leaving one entry per distinct key.
+     */
+    void Sort ( int nThreads );
+
+    /**
+     * Fills Entries with pointers to every entry, in alphabetical order
+     * of key.  Sorts first if needed.
+     */
+    void
+    SortedEntries ( std::vector<const Entry *> &Entries )
+    {
+        Sort(1);
+        Entries.clear();
+        Entries.reserve(m_Entries.size());
+        for (const Entry &entry : m_Entries)
+            Entries.push_back(&entry);
+    }
+
+    /**
+     * Fills Entries with pointers to the nK entries with the highest
+     * counts (or to all entries, if nK is zero), as
+     * HashCountTable::TopEntries() does.
+     */
+    void
+    TopEntries ( size_t                      nK,
+                 std::vector<const Entry *> &Entries )
+    {
+        SortedEntries(Entries);
+        SelectTopEntries(nK, Entries);
+    }
+
+    size_t
+    size () const
+    {
+        return m_Entries.size();
+    }
+
+private:
+    /**
+     * A bucket of entries still to be sorted, all sharing their first
+     * nDepth bytes.
+     */
+    struct Bucket
+    {
+        size_t nBegin;
+        size_t nSize;
+        size_t nDepth;
+    };
+
+    /**
+     * The byte of entry's key at nDepth, plus one; zero if the key is
+     * no longer than nDepth, so that shorter keys sort first.
+     */
+    static unsigned
+    ByteAt ( const Entry &entry,
+             size_t       nDepth )
+    {
+        return nDepth < entry.nLength ?
+            1 + static_cast<unsigned char>(entry.pKey[nDepth]) : 0;
+    }
+
+    static void InsertionSort ( Entry  *pEntries,
+                                size_t  nSize,
+                                size_t  nDepth );
+
+    static bool Distribute ( Entry  *pEntries,
+                             Entry  *pTemp,
+                             size_t  nSize,
+                             size_t  nDepth,
+                             size_t *pBounds );
+
+    static void RadixSort ( Entry  *pEntries,
+                            Entry  *pTemp,
+                            size_t  nSize,
+                            size_t  nDepth );
+
+    void Collapse ();
+
+    std::vector<Entry> m_Entries;
+    KeyArena           m_Arena;
+    bool               m_fSorted;
+};
+
+template<typename TCount>
+void
+SortCountTable<TCount>::InsertionSort ( Entry  *pEntries,
+                                        size_t  nSize,
+                                        size_t  nDepth )
+{
+    for ( size_t i = 1; i < nSize; i++ )
+    {
+        Entry  entry = pEntries[i];
+        size_t j     = i;
+        // strictly less, so that equal keys keep their order
+        while (j > 0 &&
+               CompareKeys(entry.pKey + nDepth, entry.nLength - nDepth,
+                           pEntries[j - 1].pKey + nDepth,
+                           pEntries[j - 1].nLength - nDepth) < 0)
+        {
+            pEntries[j] = pEntries[j - 1];
+            j--;
+        }
+        pEntries[j] = entry;
+    }
+}
+
+/**
+ * Stably distributes the entries into 257 buckets by ByteAt(nDepth),
+ * bucket b being [pBounds[b], pBounds[b + 1]).  Returns false, having
+ * moved nothing, if every entry falls into the same bucket.
+ */
+template<typename TCount>
+bool
+SortCountTable<TCount>::Distribute ( Entry  *pEntries,
+                                     Entry  *pTemp,
+                                     size_t  nSize,
+                                     size_t  nDepth,
+                                     size_t *pBounds )
+{
+    size_t Counts[257] = { 0 };
+    for ( size_t i = 0; i < nSize; i++ )
+        Counts[ByteAt(pEntries[i], nDepth)]++;
+    pBounds[0] = 0;
+    for ( size_t b = 0; b < 257; b++ )
+    {
+        if (Counts[b] == nSize)
+            return false;
+        pBounds[b + 1] = pBounds[b] + Counts[b];
+    }
+    size_t Next[257];
+    std::copy(pBounds, pBounds + 257, Next);
+    for ( size_t i = 0; i < nSize; i++ )
+        pTemp[Next[ByteAt(pEntries[i], nDepth)]++] = pEntries[i];
+    std::copy(pTemp, pTemp + nSize, pEntries);
+    return true;
+}
+
+/**
+ * Sorts the entries by key from byte nDepth on.  The buckets still to
+ * be sorted are kept on a stack rather than recursed into, since keys
+ * that are prefixes of one another would take the recursion one level
+ * deeper for every byte.
+ */
+template<typename TCount>
+void
+SortCountTable<TCount>::RadixSort ( Entry  *pEntries,
+                                    Entry  *pTemp,
+                                    size_t  nSize,
+                                    size_t  nDepth )
+{
+    std::vector<Bucket> Stack;
+    Stack.push_back(Bucket{ 0, nSize, nDepth });
+    size_t Bounds[258];
+    while (!Stack.empty())
+    {
+        Bucket bucket = Stack.back();
+        Stack.pop_back();
+        Entry *pBucket = pEntries + bucket.nBegin;
+        if (bucket.nSize < SORTCOUNT_INSERTION_CUTOFF)
+        {
+            InsertionSort(pBucket, bucket.nSize, bucket.nDepth);
+            continue;
+        }
+        if (!Distribute(pBucket, pTemp + bucket.nBegin, bucket.nSize,
+                        bucket.nDepth, Bounds))
+        {
+            // all the keys agree on this byte; if they have all ended,
+            // they are all equal
+            if (ByteAt(*pBucket, bucket.nDepth) != 0)
+            {
+                bucket.nDepth++;
+                Stack.push_back(bucket);
+            }
+            continue;
+        }
+        // bucket 0 holds the keys that have ended, which are all equal
+        for ( size_t b = 1; b < 257; b++ )
+        {
+            size_t nBucket = Bounds[b + 1] - Bounds[b];
+            if (nBucket > 1)
+                Stack.push_back(Bucket{ bucket.nBegin + Bounds[b], nBucket,
+                                        bucket.nDepth + 1 });
+        }
+    }
+}
+
+template<typename TCount>
+void
+SortCountTable<TCount>::Sort ( int nThreads )
+{
+    if (m_fSorted)
+        return;
+    std::vector<Entry> Temp(m_Entries.size());
+    Entry             *pEntries = m_Entries.data();
+    size_t             nSize    = m_Entries.size();
+
+    // split the largest buckets until there are enough for every
+    // thread to have several, then sort the buckets in parallel,
+    // largest first
+    std::vector<Bucket> Buckets;
+    Buckets.push_back(Bucket{ 0, nSize, 0 });
+    size_t nTarget = nThreads > 1 ? nSize / (4 * nThreads) : nSize;
+    while (!Buckets.empty())
+    {
+        auto pLargest = std::max_element(
+            Buckets.begin(), Buckets.end(),
+            [](const Bucket &a, const Bucket &b) { return a.nSize < b.nSize; });
+        if (pLargest->nSize <= std::max(nTarget, SORTCOUNT_INSERTION_CUTOFF))
+            break;
+        Bucket bucket = *pLargest;
+        Buckets.erase(pLargest);
+        size_t Bounds[258];
+        if (!Distribute(pEntries + bucket.nBegin, Temp.data() + bucket.nBegin,
+                        bucket.nSize, bucket.nDepth, Bounds))
+        {
+            if (ByteAt(pEntries[bucket.nBegin], bucket.nDepth) != 0)
+            {
+                bucket.nDepth++;
+                Buckets.push_back(bucket);
+            }
+            continue;
+        }
+        for ( size_t b = 1; b < 257; b++ )
+        {
+            size_t nBucket = Bounds[b + 1] - Bounds[b];
+            if (nBucket > 1)
+                Buckets.push_back(Bucket{ bucket.nBegin + Bounds[b], nBucket,
+                                          bucket.nDepth + 1 });
+        }
+    }
+    std::sort(Buckets.begin(), Buckets.end(),
+              [](const Bucket &a, const Bucket &b) { return a.nSize > b.nSize; });
+
+    std::atomic<size_t> nNext(0);
+    auto worker = [&]()
+    {
+        size_t i;
+        while ((i = nNext++) < Buckets.size())
+        {
+            const Bucket &bucket = Buckets[i];
+            RadixSort(pEntries + bucket.nBegin, Temp.data() + bucket.nBegin,
+                      bucket.nSize, bucket.nDepth);
+        }
+    };
+    std::vector<std::thread> Threads;
+    for ( int t = 1; t < nThreads && static_cast<size_t>(t) < Buckets.size(); t++ )
+        Threads.emplace_back(worker);
+    worker();
+    for ( size_t t = 0; t < Threads.size(); t++ )
+        Threads[t].join();
+
+    Collapse();
+    m_fSorted = true;
+}
+
+/**
+ * Sums each run of equal keys into its first entry, in order.
+ */
+template<typename TCount>
+void
+SortCountTable<TCount>::Collapse ()
+{
+    size_t nOut = 0;
+    for ( size_t i = 0; i < m_Entries.size(); i++ )
+    {
+        const Entry &entry = m_Entries[i];
+        if (nOut > 0 && m_Entries[nOut - 1].nLength == entry.nLength &&
+            memcmp(m_Entries[nOut - 1].pKey, entry.pKey, entry.nLength) == 0)
+            m_Entries[nOut - 1].nCount += entry.nCount;
+        else
+            m_Entries[nOut++] = entry;
+    }
+    m_Entries.resize(nOut);
+    m_Entries.shrink_to_fit();
+}
+
+#endif // SORTCOUNTTABLE_H
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          sortedlines
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Searching sorted count files in memory
+ *
+ * Description:
+ *    Implementation of the sorted count file search functions.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version, from rangemerge.cpp.
+ *
+ * \file sortedlines.cpp
+ */
+
+#include "config.h"
+#include <string.h>
+#include <algorithm>
+#include "sortedlines.h"
+using namespace std;
+
+size_t
+LineStart ( const char *pData,
+            size_t      nSize,
+            size_t      nOffset )
+{
+    if (nOffset == 0 || nOffset >= nSize)
+        return min(nOffset, nSize);
+    if (pData[nOffset - 1] == '\n')
+        return nOffset;
+    const char *pNewline = static_cast<const char *>(
+        memchr(pData + nOffset, '\n', nSize - nOffset));
+    return pNewline ? pNewline - pData + 1 : nSize;
+}
+
+string_view
+LineValue ( const char *pData,
+            size_t      nSize,
+            size_t      nStart )
+{
+    const char *pLine    = pData + nStart;
+    const char *pNewline = static_cast<const char *>(
+        memchr(pLine, '\n', nSize - nStart));
+    if (!pNewline)
+        pNewline = pData + nSize;
+    const char *pTab = static_cast<const char *>(
+        memchr(pLine, '\t', pNewline - pLine));
+    if (!pTab)
+        return string_view(pNewline, 0);
+    return string_view(pTab + 1, pNewline - pTab - 1);
+}
+
+string_view
+PreviousLineValue ( const char *pData,
+                    size_t      nSize,
+                    size_t      nStart )
+{
+    size_t nLine = nStart - 1;
+    while (nLine > 0 && pData[nLine - 1] != '\n')
+        nLine--;
+    return LineValue(pData, nSize, nLine);
+}
+
+size_t
+FindKey ( const char  *pData,
+          size_t       nSize,
+          string_view  Key )
+{
+    // every line starting before nLow is before Key, and the line
+    // starting at nHigh (if any) is not
+    size_t nLow  = 0;
+    size_t nHigh = nSize;
+    while (nLow < nHigh)
+    {
+        size_t nLine = LineStart(pData, nSize, nLow + (nHigh - nLow) / 2);
+        if (nLine >= nHigh)
+        {
+            // no line starts in the upper half; test the line at nLow
+            nLine = nLow;
+        }
+        if (LineValue(pData, nSize, nLine) < Key)
+            nLow = LineStart(pData, nSize, nLine + 1);
+        else
+            nHigh = nLine;
+    }
+    return nHigh;
+}
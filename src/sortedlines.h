@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          sortedlines
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Searching sorted count files in memory
+ *
+ * Description:
+ *    Functions for finding lines in a text count file that is mapped
+ *    into memory, without reading it from the start: the line at or
+ *    after any byte offset, the value of a line, and, in a file sorted
+ *    by value, the first line whose value is not before a given key,
+ *    found by binary search over byte offsets.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version, from rangemerge.cpp.
+ *
+ * \file sortedlines.h
+ */
+
+#ifndef SORTEDLINES_H
+#define SORTEDLINES_H
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * The offset of the first line starting at or after nOffset.
+ */
+size_t LineStart ( const char *pData,
+                   size_t      nSize,
+                   size_t      nOffset );
+
+/**
+ * The value of the line starting at nStart, as CountReader reads it.
+ */
+std::string_view LineValue ( const char *pData,
+                             size_t      nSize,
+                             size_t      nStart );
+
+/**
+ * The value of the line before the one starting at nStart > 0.
+ */
+std::string_view PreviousLineValue ( const char *pData,
+                                     size_t      nSize,
+                                     size_t      nStart );
+
+/**
+ * The offset of the first line whose value is not before Key (or nSize,
+ * if there is none), assuming that the lines are sorted.
+ */
+size_t FindKey ( const char       *pData,
+                 size_t            nSize,
+                 std::string_view  Key );
+
+#endif // SORTEDLINES_H
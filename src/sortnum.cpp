@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          sortnum
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Sorts a count file by descending count
+ *
+ * Description:
+ *    sortnum reads a count file and writes its records in order of
+ *    descending count; records with equal counts stay in the order of
+ *    the input, so a count file in alphabetical order gives the same
+ *    output as count -f.  It replaces a script around sort -nr, which
+ *    compared every line as text and was not stable.
+ *
+ *    The sorting is done by CountOrderSorter, with a radix sort on the
+ *    counts; with -S, records that do not fit in memory are written to
+ *    sorted runs on disk and merged.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file sortnum.cpp
+ */
+
+#include "config.h"
+#include <getopt.h>
+#include <stdlib.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "bincount.h"
+#include "compression.h"
+#include "countorder.h"
+#include "countreader.h"
+#include "countrun.h"
+#include "outputfile.h"
+#include "toolstats.h"
+using namespace std;
+
+void
+printHelp()
+{
+    cout << "sortnum - " << PACKAGE_STRING << endl << endl;
+    cout << "sortnum reads in a count file and sorts it in order of descending" << endl;
+    cout << "count, outputting the results to standard output (or to the file" << endl;
+    cout << "OUTPUT, if this is specified).  Values with equal counts keep the" << endl;
+    cout << "order they have in the input.  The input count file INPUT contains" << endl;
+    cout << "at least two tab-separated columns; the first specifying the count" << endl;
+    cout << "and the second the value.  If INPUT is not specified, or is given" << endl;
+    cout << "as the character \"-\", sortnum will read from standard input.  INPUT" << endl;
+    cout << "may also be a binary count file." << endl;
+    cout << endl;
+    cout << "Syntax:" << endl;
+    cout << endl;
+    cout << "   sortnum [OPTIONS] [INPUT [OUTPUT]]" << endl;
+    cout << endl;
+    cout << "Options:" << endl;
+    cout << endl;
+    cout << "   -b      write a binary count file (see countconv)" << endl;
+    cout << "   -d      interpret counts as floating-point numbers" << endl;
+    cout << "   -k K    output only the K values with the highest counts" << endl;
+    cout << "   -S SIZE use at most about SIZE bytes of memory (e.g. 512M, 4G)," << endl;
+    cout << "           spilling sorted runs to disk when it is full" << endl;
+    cout << "   -T DIR  write temporary runs under DIR (default $TMPDIR or /tmp)" << endl;
+    cout << "   -z FORMAT" << endl;
+    cout << "           compress the output with FORMAT: gzip, xz or zstd" << endl;
+    cout << "   --stats print statistics of the run to standard error: lines and" << endl;
+    cout << "           bytes read, time in each phase, heap allocations and" << endl;
+    cout << "           peak memory" << endl;
+    cout << "   --stats-json FILE" << endl;
+    cout << "           write the statistics to FILE as a JSON object" << endl;
+    cout << "   --progress SECONDS" << endl;
+    cout << "           print the input read so far to standard error every" << endl;
+    cout << "           SECONDS seconds" << endl;
+    cout << "   -?      display this help message" << endl;
+}
+
+int main ( int argc, char **argv )
+{
+    bool        fFloatingPoint    = false;
+    bool        fBinaryOutput     = false;
+    size_t      nMemoryBudget     = 0;
+    string      sTempDir          = "";
+    size_t      nTopK             = 0;
+    Compression OutputCompression = COMPRESSION_NONE;
+    ToolStats   Stats("sortnum");
+    int         c;
+    static const struct option LongOptions[] =
+    {
+        { "stats",      no_argument,       0, STATS_OPTION },
+        { "stats-json", required_argument, 0, STATS_JSON_OPTION },
+        { "progress",   required_argument, 0, PROGRESS_OPTION },
+        { 0,            0,                 0, 0 }
+    };
+    while ((c = getopt_long(argc, argv, "bdk:S:T:z:?", LongOptions,
+                            0)) != -1)
+    {
+        switch(c)
+        {
+        case 'b':
+            fBinaryOutput = true;
+            break;
+        case 'd':
+            fFloatingPoint = true;
+            break;
+        case 'k':
+        {
+            long long     nValue = 0;
+            istringstream iss(optarg);
+            iss >> nValue;
+            if (iss.fail() || nValue <= 0)
+            {
+                cerr << "ERROR: Invalid number of values " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            nTopK = nValue;
+            break;
+        }
+        case 'S':
+            if (!ParseMemorySize(optarg, nMemoryBudget))
+            {
+                cerr << "ERROR: Invalid memory size " << optarg << endl;
+                printHelp();
+                exit(1);
+            }
+            break;
+        case 'T':
+            sTempDir = optarg;
+            break;
+        case 'z':
+            if (!ParseCompression(optarg, OutputCompression))
+                exit(1);
+            break;
+        case STATS_OPTION:
+        case STATS_JSON_OPTION:
+        case PROGRESS_OPTION:
+            if (!Stats.ParseOption(c, optarg))
+            {
+                printHelp();
+                exit(1);
+            }
+            break;
+        case '?':
+            printHelp();
+            exit(1);
+            break;
+        default:
+            break;
+        }
+    }
+
+    string      sInputFileName  = "";
+    string      sOutputFileName = "";
+
+    CountReader input;
+    OutputFile  output;
+
+    if ((argc - optind) < 1)
+    {
+        sInputFileName = "-";
+    }
+    else
+    {
+        sInputFileName = argv[optind++];
+    }
+
+    if (!input.Open(sInputFileName))
+    {
+        cerr << "ERROR: Could not open file " << sInputFileName << endl;
+        exit(1);
+    }
+
+    if ((argc - optind) == 0)
+    {
+        sOutputFileName = "-";
+    }
+    else
+    {
+        sOutputFileName = argv[optind];
+    }
+    if (!output.Open(sOutputFileName, OutputCompression))
+    {
+        cerr << "ERROR: Could not open file " << sOutputFileName << endl;
+        exit(1);
+    }
+
+    input.SetFloatingPoint(fFloatingPoint);
+    input.SetAllowMissingTab(true);
+    input.SetStats(&Stats);
+    Stats.Start("read");
+
+    // values of a mapped input stay valid, and need not be copied
+    CountOrderSorter sorter(fFloatingPoint, nMemoryBudget, sTempDir);
+    bool             fBorrow = input.IsMapped();
+    bool             fOk     = true;
+    while (fOk && input.Next())
+    {
+        if (fBorrow)
+            fOk = sorter.AddBorrowed(input.nCount, input.nFloatCount,
+                                     input.Value);
+        else
+            fOk = sorter.Add(input.nCount, input.nFloatCount, input.Value);
+    }
+    if (!fOk || input.Failed())
+    {
+        output.Close();
+        exit(1);
+    }
+
+    Stats.Phase(sorter.RunCount() ? "merge" : "sort");
+    Stats.Set("runs_spilled", sorter.RunCount());
+    BinaryCountWriter *binaryOutput = 0;
+    if (fBinaryOutput)
+        binaryOutput = new BinaryCountWriter(output, fFloatingPoint);
+    fOk = sorter.Write(
+        nTopK,
+        [fFloatingPoint, &output, binaryOutput](long long   nCount,
+                                                double      nFloatCount,
+                                                string_view Value)
+        {
+            if (binaryOutput)
+                binaryOutput->Write(Value, nCount, nFloatCount);
+            else if (fFloatingPoint)
+                output.WriteRecord(nFloatCount, Value);
+            else
+                output.WriteRecord(nCount, Value);
+        });
+    if (!fOk)
+    {
+        delete binaryOutput;
+        output.Close();
+        exit(1);
+    }
+    if (binaryOutput)
+        binaryOutput->Finish();
+    delete binaryOutput;
+
+    if (!output.Close())
+    {
+        cerr << "ERROR: Could not write file " << output.Name() << endl;
+        exit(1);
+    }
+
+    return Stats.Report() ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          spacesaving
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Fixed-memory approximate heavy-hitter counting
+ *
+ * Description:
+ *    Implementation of SpaceSaving.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file spacesaving.cpp
+ */
+
+#include "config.h"
+#include <algorithm>
+#include "spacesaving.h"
+using namespace std;
+
+SpaceSaving::SpaceSaving ( size_t nCapacity )
+    : m_nCapacity(max<size_t>(1, nCapacity)), m_nTotal(0)
+{
+    m_Counters.reserve(m_nCapacity);
+    m_Heap.reserve(m_nCapacity);
+    m_HeapPos.reserve(m_nCapacity);
+    m_Index.reserve(m_nCapacity);
+}
+
+SpaceSaving::SpaceSaving ( const SpaceSaving &other )
+    : m_nCapacity(other.m_nCapacity), m_nTotal(other.m_nTotal),
+      m_Counters(other.m_Counters), m_Heap(other.m_Heap),
+      m_HeapPos(other.m_HeapPos)
+{
+    // the index refers to the strings of the counters, so it has to be
+    // rebuilt rather than copied
+    m_Counters.reserve(m_nCapacity);
+    Reindex();
+}
+
+void
+SpaceSaving::Reindex ()
+{
+    m_Index.clear();
+    m_Index.reserve(m_nCapacity);
+    for ( size_t i = 0; i < m_Counters.size(); i++ )
+        m_Index.emplace(m_Counters[i].sValue, i);
+}
+
+long long
+SpaceSaving::MissingCount () const
+{
+    if (m_Counters.size() < m_nCapacity)
+        return 0;
+    return m_Counters[m_Heap[0]].nCount;
+}
+
+void
+SpaceSaving::SiftDown ( size_t nPos )
+{
+    size_t nSize = m_Heap.size();
+    while (true)
+    {
+        size_t nSmallest = nPos;
+        size_t nLeft     = 2 * nPos + 1;
+        size_t nRight    = nLeft + 1;
+        if (nLeft < nSize && m_Counters[m_Heap[nLeft]].nCount <
+                             m_Counters[m_Heap[nSmallest]].nCount)
+            nSmallest = nLeft;
+        if (nRight < nSize && m_Counters[m_Heap[nRight]].nCount <
+                              m_Counters[m_Heap[nSmallest]].nCount)
+            nSmallest = nRight;
+        if (nSmallest == nPos)
+            return;
+        swap(m_Heap[nPos], m_Heap[nSmallest]);
+        m_HeapPos[m_Heap[nPos]]      = nPos;
+        m_HeapPos[m_Heap[nSmallest]] = nSmallest;
+        nPos = nSmallest;
+    }
+}
+
+void
+SpaceSaving::Insert ( string_view Value,
+                      long long   nCount,
+                      long long   nError )
+{
+    size_t nCounter;
+    if (m_Counters.size() < m_nCapacity)
+    {
+        // new counters start at the bottom of the heap; since counts
+        // never decrease, sifting up is never needed except here
+        nCounter = m_Counters.size();
+        m_Counters.push_back(Counter());
+        m_Heap.push_back(nCounter);
+        m_HeapPos.push_back(m_Heap.size() - 1);
+        size_t nPos = m_Heap.size() - 1;
+        while (nPos > 0)
+        {
+            size_t nParent = (nPos - 1) / 2;
+            if (m_Counters[m_Heap[nParent]].nCount <= nCount)
+                break;
+            swap(m_Heap[nPos], m_Heap[nParent]);
+            m_HeapPos[m_Heap[nPos]]    = nPos;
+            m_HeapPos[m_Heap[nParent]] = nParent;
+            nPos = nParent;
+        }
+    }
+    else
+    {
+        // evict the value with the smallest count
+        nCounter = m_Heap[0];
+        m_Index.erase(m_Counters[nCounter].sValue);
+    }
+    Counter &counter = m_Counters[nCounter];
+    counter.sValue.assign(Value.data(), Value.size());
+    counter.nCount = nCount;
+    counter.nError = nError;
+    m_Index.emplace(counter.sValue, nCounter);
+    SiftDown(m_HeapPos[nCounter]);
+}
+
+void
+SpaceSaving::Add ( const char *pValue,
+                   size_t      nLength )
+{
+    m_nTotal += 1;
+    string_view Value(pValue, nLength);
+    unordered_map<string_view, size_t>::iterator iterator =
+        m_Index.find(Value);
+    if (iterator != m_Index.end())
+    {
+        m_Counters[iterator->second].nCount += 1;
+        SiftDown(m_HeapPos[iterator->second]);
+        return;
+    }
+    long long nMissing = MissingCount();
+    Insert(Value, nMissing + 1, nMissing);
+}
+
+void
+SpaceSaving::Merge ( const SpaceSaving &other )
+{
+    // a value missing from one summary may have occurred up to that
+    // summary's missing count times in its part of the input
+    long long       nMissing      = MissingCount();
+    long long       nOtherMissing = other.MissingCount();
+    vector<Counter> Combined;
+    Combined.reserve(m_Counters.size() + other.m_Counters.size());
+    for ( size_t i = 0; i < m_Counters.size(); i++ )
+    {
+        Counter counter = m_Counters[i];
+        unordered_map<string_view, size_t>::const_iterator iterator =
+            other.m_Index.find(counter.sValue);
+        if (iterator != other.m_Index.end())
+        {
+            counter.nCount += other.m_Counters[iterator->second].nCount;
+            counter.nError += other.m_Counters[iterator->second].nError;
+        }
+        else
+        {
+            counter.nCount += nOtherMissing;
+            counter.nError += nOtherMissing;
+        }
+        Combined.push_back(counter);
+    }
+    for ( size_t i = 0; i < other.m_Counters.size(); i++ )
+    {
+        if (m_Index.count(other.m_Counters[i].sValue))
+            continue;
+        Counter counter = other.m_Counters[i];
+        counter.nCount += nMissing;
+        counter.nError += nMissing;
+        Combined.push_back(counter);
+    }
+
+    // keep the capacity largest
+    if (Combined.size() > m_nCapacity)
+    {
+        nth_element(Combined.begin(), Combined.begin() + m_nCapacity,
+                    Combined.end(),
+                    [](const Counter &a, const Counter &b)
+                    {
+                        return a.nCount > b.nCount;
+                    });
+        Combined.resize(m_nCapacity);
+    }
+
+    m_nTotal += other.m_nTotal;
+    m_Counters.swap(Combined);
+    m_Heap.resize(m_Counters.size());
+    m_HeapPos.resize(m_Counters.size());
+    for ( size_t i = 0; i < m_Counters.size(); i++ )
+        m_Heap[i] = i;
+    for ( size_t i = 0; i < m_Heap.size(); i++ )
+        m_HeapPos[m_Heap[i]] = i;
+    for ( size_t i = m_Heap.size() / 2; i-- > 0; )
+        SiftDown(i);
+    Reindex();
+}
+
+void
+SpaceSaving::TopK ( size_t                   nK,
+                    vector<const Counter *> &Counters ) const
+{
+    Counters.clear();
+    for ( size_t i = 0; i < m_Counters.size(); i++ )
+        Counters.push_back(&m_Counters[i]);
+    auto fnBefore = [](const Counter *pA, const Counter *pB)
+    {
+        if (pA->nCount != pB->nCount)
+            return pA->nCount > pB->nCount;
+        return pA->sValue < pB->sValue;
+    };
+    nK = min(nK, Counters.size());
+    partial_sort(Counters.begin(), Counters.begin() + nK, Counters.end(),
+                 fnBefore);
+    Counters.resize(nK);
+}
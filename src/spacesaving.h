@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          spacesaving
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Fixed-memory approximate heavy-hitter counting
+ *
+ * Description:
+ *    SpaceSaving implements the Space-Saving algorithm of Metwally,
+ *    Agrawal and El Abbadi: it monitors at most a fixed number of
+ *    values, each with a count and an error.  A value that is already
+ *    monitored has its count incremented; a new value replaces the
+ *    monitored value with the smallest count, inheriting that count
+ *    (plus one) as an overestimate and recording the inherited amount
+ *    as its error.  Every monitored value's true count therefore lies
+ *    between nCount - nError and nCount, and any value occurring more
+ *    than N / capacity times in a stream of N lines is guaranteed to
+ *    be monitored.  The counters are kept in a min-heap, so each update
+ *    costs O(log capacity) at worst, and memory does not grow with the
+ *    number of distinct values.
+ *
+ *    Summaries built over separate parts of the input (for instance,
+ *    by different threads) can be combined with Merge().
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file spacesaving.h
+ */
+
+#ifndef SPACESAVING_H
+#define SPACESAVING_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class SpaceSaving
+{
+public:
+    struct Counter
+    {
+        std::string sValue;
+        long long   nCount;
+        long long   nError;
+    };
+
+    explicit SpaceSaving ( size_t nCapacity );
+
+    SpaceSaving ( const SpaceSaving &other );
+    SpaceSaving &operator= ( const SpaceSaving &other ) = delete;
+
+    /**
+     * Counts one occurrence of the given value.
+     */
+    void Add ( const char *pValue,
+               size_t      nLength );
+
+    /**
+     * Combines the summary of another part of the input into this one.
+     */
+    void Merge ( const SpaceSaving &other );
+
+    /**
+     * Fills Counters with the (at most) nK monitored values with the
+     * highest counts, in order of descending count; values with equal
+     * counts are in alphabetical order.
+     */
+    void TopK ( size_t                        nK,
+                std::vector<const Counter *> &Counters ) const;
+
+    /**
+     * The number of lines counted.
+     */
+    long long
+    TotalCount () const
+    {
+        return m_nTotal;
+    }
+
+private:
+    /**
+     * The count that any unmonitored value may have had: the smallest
+     * monitored count once the summary is full, and zero before that.
+     */
+    long long MissingCount () const;
+
+    void Insert ( std::string_view Value,
+                  long long        nCount,
+                  long long        nError );
+    void SiftDown ( size_t nPos );
+    void Reindex ();
+
+    size_t                                       m_nCapacity;
+    long long                                    m_nTotal;
+    std::vector<Counter>                         m_Counters;
+    std::vector<size_t>                          m_Heap;
+    std::vector<size_t>                          m_HeapPos;
+    std::unordered_map<std::string_view, size_t> m_Index;
+};
+
+#endif // SPACESAVING_H
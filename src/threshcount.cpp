@@ -15,13 +15,30 @@
  *    argument passed on the command line.  It outputs the result to
  *    standard output.  The input contains at least two tab-separated
  *    columns; the first specifying the count and the second the
- *    value.
+ *    value.  Instead of a threshold, any number of conditions on the
+ *    count (-c), which together select a range of counts, and on the
+ *    value (-p, -r) can be given; a record is output if it meets all
+ *    of them.
  *
  * Revision Information:
  *
  *    (WKR) 8 December 2013
  *          - Initial version.
  *
+ *    (WKR) 17 October 2026
+ *          - Binary count files are read transparently; -b writes
+ *            binary output.  Counts are read as long long.
+ *          - Read the input with CountReader.
+ *          - Write the output through a buffered OutputFile.
+ *          - Filter with -c conditions on the count (ranges, floating
+ *            point counts with -d), -p prefixes and -r regular
+ *            expressions on the value.  Records are tested on their
+ *            count first.
+ *          - Read compressed inputs; add -z to compress the output.
+ *          - Add --stats, --stats-json and --progress.
+ *          - CountFilter and ValueFilter moved to countfilter.h, to be
+ *            shared with CountTable.
+ *
  * \file threshcount.cpp
  */
 
@@ -29,8 +46,17 @@
 
 #include "config.h"
 #include <getopt.h>
+#include <stdlib.h>
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <vector>
+#include "bincount.h"
+#include "compression.h"
+#include "countfilter.h"
+#include "countreader.h"
+#include "outputfile.h"
+#include "toolstats.h"
 using namespace std;
 
 void
@@ -41,54 +67,130 @@ printHelp()
     cout << "lines whose counts are less than or equal to the threshold argument" << endl;
     cout << "passed on the command line.  It outputs the result to standard output." << endl;
     cout << "The input contains at least two tab-separated columns; the first" << endl;
-    cout << "specifying the count and the second the value." << endl;
+    cout << "specifying the count and the second the value.  The input may also" << endl;
+    cout << "be a binary count file." << endl;
+    cout << endl;
+    cout << "Instead of (or as well as) THRESHOLD, the lines to keep can be chosen" << endl;
+    cout << "with the options below, which may each be given more than once.  A line" << endl;
+    cout << "is output if its count meets every -c condition, and its value starts" << endl;
+    cout << "with one of the -p prefixes (if any) and matches every -r expression." << endl;
     cout << endl;
     cout << "Syntax:" << endl;
     cout << endl;
-    cout << "   threshcount [OPTIONS] THRESHOLD" << endl;
+    cout << "   threshcount [OPTIONS] [THRESHOLD]" << endl;
     cout << endl;
     cout << "Options:" << endl;
     cout << endl;
+    cout << "   -b      write a binary count file (see countconv)" << endl;
+    cout << "   -c COND keep lines whose count meets COND, one of >N, >=N, <N, <=N," << endl;
+    cout << "           =N, or N:M (between N and M, inclusive)" << endl;
+    cout << "   -d      interpret counts as floating-point numbers" << endl;
+    cout << "   -p PREFIX" << endl;
+    cout << "           keep lines whose value starts with PREFIX" << endl;
+    cout << "   -r REGEX" << endl;
+    cout << "           keep lines whose value matches the extended regular" << endl;
+    cout << "           expression REGEX" << endl;
+    cout << "   -z FORMAT" << endl;
+    cout << "           compress the output with FORMAT: gzip, xz or zstd" << endl;
+    cout << "   --stats print statistics of the run to standard error: lines and" << endl;
+    cout << "           bytes read, values kept, time in each phase, heap" << endl;
+    cout << "           allocations and peak memory" << endl;
+    cout << "   --stats-json FILE" << endl;
+    cout << "           write the statistics to FILE as a JSON object" << endl;
+    cout << "   --progress SECONDS" << endl;
+    cout << "           print the input read so far to standard error every" << endl;
+    cout << "           SECONDS seconds" << endl;
     cout << "   -?      display this help message" << endl;
 }
 
+inline void
+GetCount ( const CountReader &input,
+           long long         &nCount )
+{
+    nCount = input.nCount;
+}
+
+inline void
+GetCount ( const CountReader &input,
+           double            &nCount )
+{
+    nCount = input.nFloatCount;
+}
+
+/**
+ * Copies the records of input that pass both filters to output (or to
+ * binaryOutput, if it is set).  The cheap test on the count comes
+ * first, so most rejected records never have their value looked at.
+ * The number of records kept is recorded in Stats.  Returns false if
+ * the input is malformed.
+ */
+template<typename TCount>
 bool
-ReadCountLine ( bool   &fDidRead,
-                int    &nLinesRead,
-                int    &nCount,
-                string &sValue )
+filterCounts ( CountReader               &input,
+               OutputFile                &output,
+               BinaryCountWriter         *binaryOutput,
+               const CountFilter<TCount> &Counts,
+               ValueFilter               &Values,
+               ToolStats                 &Stats )
+{
+    bool      fTestValues = !Values.Empty();
+    long long nKept       = 0;
+    TCount    nCount;
+    while (input.Next())
+    {
+        GetCount(input, nCount);
+        if (!Counts.Keep(nCount))
+            continue;
+        if (fTestValues && !Values.Keep(input.Value))
+            continue;
+        if (binaryOutput)
+            binaryOutput->Write(input.Value, input.nCount, input.nFloatCount);
+        else
+            output.WriteRecord(nCount, input.Value);
+        nKept++;
+    }
+    Stats.Set("values_kept", nKept);
+    return !input.Failed();
+}
+
+/**
+ * Builds the count filter from the threshold argument (if any) and the
+ * -c conditions; exits with a message if one is invalid.
+ */
+template<typename TCount>
+void
+buildCountFilter ( CountFilter<TCount>  &Counts,
+                   const char           *pThreshold,
+                   const vector<string> &Conditions )
 {
-    fDidRead     = false;
-    string sLine = "";
-    if (cin)
+    if (pThreshold)
     {
-        fDidRead    = true;
-        nLinesRead += 1;
-        getline ( cin, sLine );
-        if (!cin && sLine.length() == 0)
+        TCount        nThreshold = 0;
+        istringstream iss(pThreshold);
+        iss >> nThreshold;
+        if (iss.fail())
         {
-            fDidRead = false;
-            return false;
+            cerr << "ERROR: Invalid threshold argument " << pThreshold << endl;
+            printHelp();
+            exit(1);
         }
-        size_t nFirstTab = sLine.find_first_of('\t');
-        if (nFirstTab == string::npos)
+        if (nThreshold <= 0)
         {
-            cerr << nLinesRead
-                 << ": error: no tab character found on line" << endl;
-            return true;
+            cerr << "ERROR: Threshold must be positive: " << nThreshold << endl;
+            printHelp();
+            exit(1);
         }
-        sValue = sLine.substr(nFirstTab + 1);
-        istringstream iss(sLine.substr(0, nFirstTab));
-        iss >> nCount;
-        if (iss.fail())
+        Counts.AtLeast(nThreshold, true);
+    }
+    for ( size_t i = 0; i < Conditions.size(); i++ )
+    {
+        if (!Counts.Add(Conditions[i]))
         {
-            cerr << nLinesRead
-                 << ": error: could not read count field" << endl;
-            return true;
+            cerr << "ERROR: Invalid count condition " << Conditions[i] << endl;
+            printHelp();
+            exit(1);
         }
     }
-
-    return false;
 }
 
 int main ( int argc, char **argv )
@@ -97,11 +199,53 @@ int main ( int argc, char **argv )
     cout << "Hello, world!" << endl;
 #endif // DEBUG
 
-    int        c;
-    while ((c = getopt(argc, argv, "?")) != -1)
+    bool           fBinaryOutput       = false;
+    bool           fFloatingPoint      = false;
+    Compression    OutputCompression   = COMPRESSION_NONE;
+    vector<string> Conditions;
+    ValueFilter    Values;
+    ToolStats      Stats("threshcount");
+    int            c;
+    static const struct option LongOptions[] =
+    {
+        { "stats",      no_argument,       0, STATS_OPTION },
+        { "stats-json", required_argument, 0, STATS_JSON_OPTION },
+        { "progress",   required_argument, 0, PROGRESS_OPTION },
+        { 0,            0,                 0, 0 }
+    };
+    while ((c = getopt_long(argc, argv, "bc:dp:r:z:?", LongOptions, 0)) != -1)
     {
         switch(c)
         {
+        case 'b':
+            fBinaryOutput = true;
+            break;
+        case 'c':
+            Conditions.push_back(optarg);
+            break;
+        case 'd':
+            fFloatingPoint = true;
+            break;
+        case 'p':
+            Values.AddPrefix(optarg);
+            break;
+        case 'r':
+            if (!Values.AddRegex(optarg))
+                exit(1);
+            break;
+        case 'z':
+            if (!ParseCompression(optarg, OutputCompression))
+                exit(1);
+            break;
+        case STATS_OPTION:
+        case STATS_JSON_OPTION:
+        case PROGRESS_OPTION:
+            if (!Stats.ParseOption(c, optarg))
+            {
+                printHelp();
+                exit(1);
+            }
+            break;
         case '?':
             printHelp();
             exit(1);
@@ -111,65 +255,58 @@ int main ( int argc, char **argv )
         }
     }
 
-    if ((argc - optind) < 1)
+    const char *pThreshold = 0;
+    if ((argc - optind) >= 1)
     {
-        cerr << "ERROR: Missing threshold argument." << endl;
-        printHelp();
-        exit(1);
-    }
-
-    int           nThreshold = 0;
-    istringstream iss(argv[optind]);
-    iss >> nThreshold;
-    if (iss.fail())
-    {
-        cerr << "ERROR: Invalid threshold argument " << argv[optind] << endl;
-        printHelp();
-        exit(1);
+        pThreshold = argv[optind];
     }
-    if (nThreshold <= 0)
+    else if (Conditions.empty() && Values.Empty())
     {
-        cerr << "ERROR: Threshold must be positive: " << nThreshold << endl;
+        cerr << "ERROR: Missing threshold argument." << endl;
         printHelp();
         exit(1);
     }
 
-    int    nLineNum = 0;
-    bool   fReadLine;
-    int    nCount;
-    string sValue;
-    if (ReadCountLine ( fReadLine,
-                        nLineNum,
-                        nCount,
-                        sValue ))
-    {
+    CountFilter<long long> Counts;
+    CountFilter<double>    FloatCounts;
+    if (fFloatingPoint)
+        buildCountFilter(FloatCounts, pThreshold, Conditions);
+    else
+        buildCountFilter(Counts, pThreshold, Conditions);
+
+    CountReader input;
+    input.Open("-");
+    input.SetName("");
+    input.SetFloatingPoint(fFloatingPoint);
+    input.SetStats(&Stats);
+    OutputFile output;
+    if (!output.Open("-", OutputCompression))
         exit(1);
-    }
+    BinaryCountWriter *binaryOutput = 0;
+    if (fBinaryOutput)
+        binaryOutput = new BinaryCountWriter(output, fFloatingPoint);
 
-#ifdef DEBUG
-    if (fReadLine)
+    Stats.Start("filter");
+    bool fOk;
+    if (fFloatingPoint)
+        fOk = filterCounts(input, output, binaryOutput, FloatCounts, Values,
+                           Stats);
+    else
+        fOk = filterCounts(input, output, binaryOutput, Counts, Values,
+                           Stats);
+    if (!fOk)
     {
-        cout << "nCount \"" << nCount << "\"" << endl;
-        cout << "sValue \"" << sValue << "\"" << endl;
+        output.Close();
+        exit(1);
     }
-#endif // DEBUG
-
-    while (fReadLine)
+    if (binaryOutput)
+        binaryOutput->Finish();
+    delete binaryOutput;
+    if (!output.Close())
     {
-        if (nThreshold < nCount)
-        {
-            cout << nCount << "\t" << sValue << endl;
-        }
-        // process
-        if (ReadCountLine ( fReadLine,
-                            nLineNum,
-                            nCount,
-                            sValue ))
-        {
-            exit(1);
-        }
+        cerr << "ERROR: Could not write to standard output" << endl;
+        exit(1);
     }
 
-    return 0;
+    return Stats.Report() ? 0 : 1;
 }
-
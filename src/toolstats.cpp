@@ -0,0 +1,241 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          toolstats
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Statistics and progress reports for --stats
+ *
+ * Description:
+ *    Implementation of ToolStats.  Heap allocations are counted by
+ *    the replacement of the global operator new in heapcount.cpp.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - The replacement operator new moved to heapcount.cpp, which
+ *            only the tools link with, so that programs using libcount
+ *            keep their own.
+ *
+ * \file toolstats.cpp
+ */
+
+#include "config.h"
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "toolstats.h"
+using namespace std;
+
+atomic<long long> g_nHeapAllocations(0);
+atomic<long long> g_nHeapBytes(0);
+
+/**
+ * Formats a value for the report: whole numbers without a fraction.
+ */
+static string
+FormatValue ( double nValue )
+{
+    ostringstream oss;
+    if (nValue == floor(nValue) && fabs(nValue) < 1e15)
+        oss << static_cast<long long>(nValue);
+    else
+        oss << fixed << setprecision(4) << nValue;
+    return oss.str();
+}
+
+static double
+TimevalSeconds ( const struct timeval &Time )
+{
+    return Time.tv_sec + Time.tv_usec / 1e6;
+}
+
+ToolStats::ToolStats ( const char *sTool )
+    : m_sTool(sTool), m_fText(false), m_nProgressSeconds(0), m_nLines(0),
+      m_nBytes(0), m_Start(Clock::now()), m_PhaseStart(m_Start),
+      m_fStopping(false)
+{
+}
+
+ToolStats::~ToolStats ()
+{
+    StopProgress();
+}
+
+bool
+ToolStats::ParseOption ( int         nOption,
+                         const char *sArgument )
+{
+    switch (nOption)
+    {
+    case STATS_OPTION:
+        m_fText = true;
+        break;
+    case STATS_JSON_OPTION:
+        m_sJsonFile = sArgument;
+        break;
+    case PROGRESS_OPTION:
+    {
+        istringstream iss(sArgument);
+        iss >> m_nProgressSeconds;
+        if (iss.fail() || !(m_nProgressSeconds > 0))
+        {
+            cerr << "ERROR: Invalid progress interval " << sArgument << endl;
+            return false;
+        }
+        break;
+    }
+    default:
+        return false;
+    }
+    return true;
+}
+
+void
+ToolStats::Start ( const char *sPhase )
+{
+    m_Start  = m_PhaseStart = Clock::now();
+    m_sPhase = sPhase;
+    if (m_nProgressSeconds > 0)
+    {
+        m_Progress = thread([this]
+        {
+            unique_lock<mutex> guard(m_Lock);
+            auto Interval = chrono::duration_cast<Clock::duration>(
+                chrono::duration<double>(m_nProgressSeconds));
+            while (!m_Stop.wait_for(guard, Interval,
+                                    [this] { return m_fStopping; }))
+                PrintProgress();
+        });
+    }
+}
+
+void
+ToolStats::Phase ( const char *sName )
+{
+    lock_guard<mutex> guard(m_Lock);
+    if (m_sPhase == sName)
+        return;
+    Clock::time_point Now = Clock::now();
+    m_Phases.emplace_back(m_sPhase,
+                          chrono::duration<double>(Now - m_PhaseStart).count());
+    m_sPhase     = sName;
+    m_PhaseStart = Now;
+}
+
+void
+ToolStats::Set ( const string &sName,
+                 double        nValue )
+{
+    for ( size_t i = 0; i < m_Values.size(); i++ )
+    {
+        if (m_Values[i].first == sName)
+        {
+            m_Values[i].second = nValue;
+            return;
+        }
+    }
+    m_Values.emplace_back(sName, nValue);
+}
+
+double
+ToolStats::Seconds () const
+{
+    return chrono::duration<double>(Clock::now() - m_Start).count();
+}
+
+void
+ToolStats::PrintProgress ()
+{
+    double    nSeconds = Seconds();
+    long long nBytes   = m_nBytes.load(memory_order_relaxed);
+    cerr << m_sTool << ": " << fixed << setprecision(1) << nSeconds << " s, "
+         << m_nLines.load(memory_order_relaxed) << " lines, "
+         << nBytes / 1e6 << " MB read ("
+         << (nSeconds > 0 ? nBytes / 1e6 / nSeconds : 0) << " MB/s), "
+         << m_sPhase << defaultfloat << endl;
+}
+
+void
+ToolStats::StopProgress ()
+{
+    if (!m_Progress.joinable())
+        return;
+    {
+        lock_guard<mutex> guard(m_Lock);
+        m_fStopping = true;
+    }
+    m_Stop.notify_all();
+    m_Progress.join();
+}
+
+bool
+ToolStats::Report ()
+{
+    StopProgress();
+    Phase("");
+    if (!m_fText && m_sJsonFile.empty())
+        return true;
+
+    struct rusage Usage;
+    getrusage(RUSAGE_SELF, &Usage);
+    vector<pair<string, double> > Values;
+    Values.emplace_back("lines_read", m_nLines.load());
+    Values.emplace_back("bytes_read", m_nBytes.load());
+    Values.insert(Values.end(), m_Values.begin(), m_Values.end());
+    Values.emplace_back("allocations", g_nHeapAllocations.load());
+    Values.emplace_back("allocated_bytes", g_nHeapBytes.load());
+    Values.emplace_back("peak_rss_kb", Usage.ru_maxrss);
+    Values.emplace_back("wall_s", Seconds());
+    Values.emplace_back("user_s", TimevalSeconds(Usage.ru_utime));
+    Values.emplace_back("sys_s", TimevalSeconds(Usage.ru_stime));
+
+    if (m_fText)
+    {
+        for ( size_t i = 0; i < Values.size(); i++ )
+        {
+            cerr << m_sTool << ": " << left << setw(16) << Values[i].first
+                 << FormatValue(Values[i].second) << endl;
+        }
+        for ( size_t i = 0; i < m_Phases.size(); i++ )
+        {
+            cerr << m_sTool << ": phase " << left << setw(10)
+                 << m_Phases[i].first << FormatValue(m_Phases[i].second)
+                 << " s" << endl;
+        }
+        cerr << right;
+    }
+    if (!m_sJsonFile.empty())
+    {
+        ofstream json(m_sJsonFile);
+        json << "{\"tool\": \"" << m_sTool << "\"";
+        for ( size_t i = 0; i < Values.size(); i++ )
+        {
+            json << ", \"" << Values[i].first << "\": "
+                 << FormatValue(Values[i].second);
+        }
+        json << ", \"phases\": {";
+        for ( size_t i = 0; i < m_Phases.size(); i++ )
+        {
+            json << (i ? ", \"" : "\"") << m_Phases[i].first << "\": "
+                 << FormatValue(m_Phases[i].second);
+        }
+        json << "}}" << endl;
+        json.close();
+        if (json.fail())
+        {
+            cerr << "ERROR: Could not write file " << m_sJsonFile << endl;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          toolstats
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Statistics and progress reports for --stats
+ *
+ * Description:
+ *    A ToolStats collects what a tool did on one run: the lines and
+ *    bytes it read, the time spent in each phase of the run (reading
+ *    and counting, merging, sorting, writing), whatever the tool knows
+ *    about its tables, and the number of heap allocations and peak
+ *    resident memory of the process.  With --stats the report is
+ *    printed to standard error at the end of the run; with --stats-json
+ *    it is written to a file as a JSON object.  --progress prints a
+ *    line with the input read so far every so many seconds, from a
+ *    thread of its own.
+ *
+ *    The input totals are shared by all of the counting threads, so
+ *    they are atomic; to keep the cost of that negligible, readers
+ *    count lines locally and add them to the totals only once every
+ *    STATS_INPUT_BATCH lines, or at the end of a block.  Everything is
+ *    counted whether or not a report was asked for.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *          - Declare the heap allocation counters of heapcount.cpp.
+ *
+ * \file toolstats.h
+ */
+
+#ifndef TOOLSTATS_H
+#define TOOLSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * The getopt_long codes of --stats, --stats-json and --progress; they
+ * are not characters, so they never clash with a tool's own options.
+ */
+const int STATS_OPTION      = 256;
+const int STATS_JSON_OPTION = 257;
+const int PROGRESS_OPTION   = 258;
+
+/**
+ * The number of heap allocations made so far, and their total size in
+ * bytes; they are counted only in programs linked with heapcount.cpp,
+ * and stay zero otherwise.
+ */
+extern std::atomic<long long> g_nHeapAllocations;
+extern std::atomic<long long> g_nHeapBytes;
+
+/**
+ * The number of lines a reader counts before adding them to the shared
+ * totals.
+ */
+const long long STATS_INPUT_BATCH = 1 << 16;
+
+class ToolStats
+{
+public:
+    /**
+     * sTool names the tool in the report and in progress lines.
+     */
+    explicit ToolStats ( const char *sTool );
+    ~ToolStats ();
+
+    ToolStats ( const ToolStats & ) = delete;
+    ToolStats &operator= ( const ToolStats & ) = delete;
+
+    /**
+     * Handles one of the options above, with its argument.  Returns
+     * false, after printing a message, if the argument is invalid.
+     */
+    bool ParseOption ( int         nOption,
+                       const char *sArgument );
+
+    /**
+     * Starts the clock, and the progress thread if --progress was
+     * given.  The first phase is sPhase.
+     */
+    void Start ( const char *sPhase );
+
+    /**
+     * Ends the current phase and starts the phase sName, unless that is
+     * the current phase.
+     */
+    void Phase ( const char *sName );
+
+    /**
+     * Adds to the totals of input read.  Safe to call from any thread.
+     */
+    void
+    AddInput ( long long nLines,
+               long long nBytes )
+    {
+        m_nLines.fetch_add(nLines, std::memory_order_relaxed);
+        m_nBytes.fetch_add(nBytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * Records a value for the report, such as the number of distinct
+     * keys; setting a value again replaces it.
+     */
+    void Set ( const std::string &sName,
+               double             nValue );
+
+    /**
+     * Records the number of distinct keys, slots and bytes of a
+     * counting table.
+     */
+    template<typename TTable>
+    void
+    SetTable ( const TTable &table )
+    {
+        Set("distinct_keys", table.size());
+        Set("table_slots", table.Capacity());
+        Set("load_factor", table.Capacity() ?
+            static_cast<double>(table.size()) / table.Capacity() : 0);
+        Set("table_bytes", table.MemoryUsage());
+    }
+
+    /**
+     * Ends the last phase, stops the progress thread and, if a report
+     * was asked for, writes it.  Returns false, after printing a
+     * message, if the JSON file could not be written.
+     */
+    bool Report ();
+
+private:
+    void   StopProgress ();
+    void   PrintProgress ();
+    double Seconds () const;
+
+    typedef std::chrono::steady_clock Clock;
+
+    std::string                                   m_sTool;
+    bool                                          m_fText;
+    std::string                                   m_sJsonFile;
+    double                                        m_nProgressSeconds;
+    std::atomic<long long>                        m_nLines;
+    std::atomic<long long>                        m_nBytes;
+    Clock::time_point                             m_Start;
+    Clock::time_point                             m_PhaseStart;
+    std::string                                   m_sPhase;
+    std::vector<std::pair<std::string, double> >  m_Phases;
+    std::vector<std::pair<std::string, double> >  m_Values;
+    std::mutex                                    m_Lock;
+    std::condition_variable                       m_Stop;
+    bool                                          m_fStopping;
+    std::thread                                   m_Progress;
+};
+
+#endif // TOOLSTATS_H
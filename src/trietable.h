@@ -0,0 +1,786 @@
+/**
+ * Copyright (c) 2026 Will Roberts
+ * All Rights Reserved.
+ *
+ * Name:          trietable
+ *
+ * Author:        wildwilhelm@gmail.com (WKR)
+ * Creation Date: 17 October 2026
+ *
+ * Purpose:       Prefix-sharing burst trie for counting
+ *
+ * Description:
+ *    TrieCountTable maps byte-string keys to counts like a
+ *    HashCountTable, but stores each shared prefix of its keys only
+ *    once, which makes it much smaller on keys such as URLs, file paths
+ *    and dotted metric names.  It is a burst trie in the style of the
+ *    HAT-trie: trie nodes with 256 children sit over buckets, each of
+ *    which is a small hash table of the keys' remaining bytes (their
+ *    suffixes) packed end to end in a single byte array, as
+ *
+ *        [suffix length, as a varint] [suffix bytes] [count]
+ *
+ *    with a 32-bit offset per hash slot.  Integer counts are varints
+ *    too (zigzag-encoded, for negative sums), so most take one byte; a
+ *    count that outgrows its bytes is moved to the end of the array.  A
+ *    key costs its suffix, a few bytes of length, count and slots,
+ *    instead of a full copy of the key and a 32-byte entry.
+ *
+ *    A bucket may serve a range of a node's children (a hybrid
+ *    bucket), in which case its suffixes start with the byte that
+ *    chose the child.  When a bucket grows past TRIE_BURST_ENTRIES
+ *    keys, a hybrid bucket is split into buckets for smaller ranges,
+ *    and a bucket for a single byte is burst: it is replaced by a new
+ *    node, which takes that byte off every suffix (or by a chain of
+ *    nodes, one for each byte that all of the suffixes share).  So
+ *    nodes only appear where many keys share a prefix, and there are
+ *    few of them.
+ *
+ *    The trie is walked in alphabetical order of key by a Cursor: the
+ *    nodes are visited in byte order, and only each bucket, a few
+ *    thousand keys at a time, needs sorting, so no sort of the whole
+ *    table is ever needed.
+ *
+ * Revision Information:
+ *
+ *    (WKR) 17 October 2026
+ *          - Initial version.
+ *
+ * \file trietable.h
+ */
+
+#ifndef TRIETABLE_H
+#define TRIETABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "counttable.h"
+
+/**
+ * The number of keys in a bucket at which it is split or burst.
+ */
+const uint32_t TRIE_BURST_ENTRIES = 8192;
+
+/**
+ * The size of the data of a bucket of more than one key at which it is
+ * split or burst, which keeps offsets within 32 bits however long the
+ * keys are.
+ */
+const size_t TRIE_BURST_BYTES = size_t(1) << 31;
+
+template<typename TCount>
+class TrieCountTable
+{
+private:
+    struct Container
+    {
+        bool fNode;
+    };
+
+    struct Node : Container
+    {
+        Container *Children[256];
+        bool       fHasValue;
+        TCount     nCount;
+    };
+
+    struct Bucket : Container
+    {
+        unsigned char         nLow;
+        unsigned char         nHigh;
+        uint32_t              nEntries;
+        std::vector<uint32_t> Slots;    // 1 + offset of an entry, or 0
+        std::vector<char>     Data;
+    };
+
+    /**
+     * An entry of a bucket, decoded.
+     */
+    struct BucketEntry
+    {
+        const char *pSuffix;
+        size_t      nLength;
+        const char *pCount;
+    };
+
+public:
+    TrieCountTable ()
+        : m_nSize(0), m_nBytes(0)
+    {
+        m_pRoot = NewNode();
+        SetChildren(m_pRoot, NewBucket(0, 255));
+    }
+
+    ~TrieCountTable ()
+    {
+        Free(m_pRoot);
+    }
+
+    TrieCountTable ( const TrieCountTable & ) = delete;
+    TrieCountTable &operator= ( const TrieCountTable & ) = delete;
+
+    /**
+     * Adds nDelta to the count of the given key, inserting the key if
+     * it is not yet present.
+     */
+    void
+    Add ( const char *pKey,
+          size_t      nLength,
+          TCount      nDelta = 1 )
+    {
+        Node  *pNode  = m_pRoot;
+        size_t nDepth = 0;
+        while (nDepth < nLength)
+        {
+            Container *pChild =
+                pNode->Children[static_cast<unsigned char>(pKey[nDepth])];
+            if (!pChild->fNode)
+            {
+                Bucket *pBucket = static_cast<Bucket *>(pChild);
+                size_t  nBefore = BucketBytes(*pBucket);
+                if (Insert(*pBucket, pKey + nDepth, nLength - nDepth,
+                           nDelta))
+                {
+                    m_nSize++;
+                    if (Overfull(*pBucket))
+                    {
+                        m_nBytes -= nBefore;
+                        Burst(pNode, pBucket);
+                        return;
+                    }
+                }
+                m_nBytes += BucketBytes(*pBucket) - nBefore;
+                return;
+            }
+            pNode = static_cast<Node *>(pChild);
+            nDepth++;
+        }
+        if (pNode->fHasValue)
+        {
+            pNode->nCount += nDelta;
+            return;
+        }
+        pNode->fHasValue = true;
+        pNode->nCount    = nDelta;
+        m_nSize++;
+    }
+
+    /**
+     * The same as Add(): the trie keeps its own copy of each suffix,
+     * so it never points at the caller's bytes.
+     */
+    void
+    AddBorrowed ( const char *pKey,
+                  size_t      nLength,
+                  TCount      nDelta = 1 )
+    {
+        Add(pKey, nLength, nDelta);
+    }
+
+    size_t
+    size () const
+    {
+        return m_nSize;
+    }
+
+    /**
+     * The number of hash slots in all of the buckets.
+     */
+    size_t
+    Capacity () const
+    {
+        return Slots(m_pRoot);
+    }
+
+    /**
+     * Approximate number of bytes held by the nodes and buckets.
+     */
+    size_t
+    MemoryUsage () const
+    {
+        return m_nBytes;
+    }
+
+    /**
+     * Removes every entry, releasing all of the nodes and buckets.
+     */
+    void
+    Clear ()
+    {
+        Free(m_pRoot);
+        m_nSize  = 0;
+        m_nBytes = 0;
+        m_pRoot  = NewNode();
+        SetChildren(m_pRoot, NewBucket(0, 255));
+    }
+
+    /**
+     * Walks the entries of a table in alphabetical order of key.  The
+     * table must not change while a Cursor is in use.
+     */
+    class Cursor
+    {
+    public:
+        explicit Cursor ( const TrieCountTable &table )
+            : m_nNext(0), m_nBucketDepth(0)
+        {
+            m_Stack.push_back(Frame { table.m_pRoot, -1, 0 });
+        }
+
+        /**
+         * Advances to the next entry.  Returns false after the last.
+         */
+        bool
+        Next ()
+        {
+            while (true)
+            {
+                if (m_nNext < m_Entries.size())
+                {
+                    const BucketEntry &entry = m_Entries[m_nNext++];
+                    m_sKey.resize(m_nBucketDepth);
+                    m_sKey.append(entry.pSuffix, entry.nLength);
+                    DecodeCount(entry.pCount, m_nCount);
+                    return true;
+                }
+                if (m_Stack.empty())
+                    return false;
+                Frame &frame = m_Stack.back();
+                if (frame.nNext < 0)
+                {
+                    // a key that ends at a node precedes all of the keys
+                    // below it
+                    frame.nNext = 0;
+                    if (frame.pNode->fHasValue)
+                    {
+                        m_sKey.resize(frame.nDepth);
+                        m_nCount = frame.pNode->nCount;
+                        return true;
+                    }
+                    continue;
+                }
+                if (frame.nNext > 255)
+                {
+                    m_Stack.pop_back();
+                    continue;
+                }
+                unsigned char c      = frame.nNext;
+                Container    *pChild = frame.pNode->Children[c];
+                size_t        nDepth = frame.nDepth;
+                if (pChild->fNode)
+                {
+                    frame.nNext = c + 1;
+                    m_sKey.resize(nDepth);
+                    m_sKey.push_back(static_cast<char>(c));
+                    m_Stack.push_back(Frame { static_cast<Node *>(pChild),
+                                              -1, nDepth + 1 });
+                    continue;
+                }
+                const Bucket *pBucket = static_cast<Bucket *>(pChild);
+                frame.nNext    = pBucket->nHigh + 1;
+                m_nBucketDepth = nDepth;
+                m_nNext        = 0;
+                SortedBucket(*pBucket, m_Entries);
+            }
+        }
+
+        std::string_view
+        Key () const
+        {
+            return m_sKey;
+        }
+
+        TCount
+        Count () const
+        {
+            return m_nCount;
+        }
+
+    private:
+        struct Frame
+        {
+            const Node *pNode;
+            int         nNext;      // next child, or -1 for the node's key
+            size_t      nDepth;
+        };
+
+        std::vector<Frame>       m_Stack;
+        std::vector<BucketEntry> m_Entries;
+        size_t                   m_nNext;
+        size_t                   m_nBucketDepth;
+        std::string              m_sKey;
+        TCount                   m_nCount;
+    };
+
+private:
+    Node *
+    NewNode ()
+    {
+        Node *pNode      = new Node;
+        pNode->fNode     = true;
+        pNode->fHasValue = false;
+        pNode->nCount    = TCount();
+        m_nBytes        += sizeof(Node);
+        return pNode;
+    }
+
+    static Bucket *
+    NewBucket ( unsigned char nLow,
+                unsigned char nHigh )
+    {
+        Bucket *pBucket   = new Bucket;
+        pBucket->fNode    = false;
+        pBucket->nLow     = nLow;
+        pBucket->nHigh    = nHigh;
+        pBucket->nEntries = 0;
+        return pBucket;
+    }
+
+    Bucket *
+    NewEmptyBucket ( unsigned char nLow,
+                     unsigned char nHigh )
+    {
+        Bucket *pBucket = NewBucket(nLow, nHigh);
+        m_nBytes       += BucketBytes(*pBucket);
+        return pBucket;
+    }
+
+    static void
+    SetChildren ( Node   *pNode,
+                  Bucket *pBucket )
+    {
+        for ( int c = pBucket->nLow; c <= pBucket->nHigh; c++ )
+            pNode->Children[c] = pBucket;
+    }
+
+    static bool
+    Overfull ( const Bucket &bucket )
+    {
+        return bucket.nEntries > TRIE_BURST_ENTRIES ||
+            (bucket.nEntries > 1 && bucket.Data.size() > TRIE_BURST_BYTES);
+    }
+
+    static size_t
+    BucketBytes ( const Bucket &bucket )
+    {
+        return sizeof(Bucket) + bucket.Slots.capacity() * sizeof(uint32_t) +
+            bucket.Data.capacity();
+    }
+
+    /**
+     * Frees pNode and everything below it.
+     */
+    static void
+    Free ( Node *pNode )
+    {
+        for ( int c = 0; c < 256; c++ )
+        {
+            Container *pChild = pNode->Children[c];
+            if (pChild->fNode)
+                Free(static_cast<Node *>(pChild));
+            else if (static_cast<Bucket *>(pChild)->nHigh == c)
+                delete static_cast<Bucket *>(pChild);
+        }
+        delete pNode;
+    }
+
+    static size_t
+    Slots ( const Node *pNode )
+    {
+        size_t nSlots = 0;
+        for ( int c = 0; c < 256; c++ )
+        {
+            const Container *pChild = pNode->Children[c];
+            if (pChild->fNode)
+                nSlots += Slots(static_cast<const Node *>(pChild));
+            else if (static_cast<const Bucket *>(pChild)->nHigh == c)
+                nSlots += static_cast<const Bucket *>(pChild)->Slots.size();
+        }
+        return nSlots;
+    }
+
+    static BucketEntry
+    Decode ( const Bucket &bucket,
+             uint32_t      nOffset )
+    {
+        const char *p = bucket.Data.data() + nOffset;
+        uint64_t    nLength;
+        p += DecodeVarint(p, nLength);
+        BucketEntry entry;
+        entry.pSuffix = p;
+        entry.nLength = nLength;
+        entry.pCount  = p + nLength;
+        return entry;
+    }
+
+    /**
+     * Writes nValue to pOut as a varint, seven bits to a byte, and
+     * returns the number of bytes written (at most ten).
+     */
+    static size_t
+    EncodeVarint ( uint64_t  nValue,
+                   char     *pOut )
+    {
+        size_t nBytes = 0;
+        while (nValue >= 0x80)
+        {
+            pOut[nBytes++] = static_cast<char>((nValue & 0x7F) | 0x80);
+            nValue >>= 7;
+        }
+        pOut[nBytes++] = static_cast<char>(nValue);
+        return nBytes;
+    }
+
+    static size_t
+    DecodeVarint ( const char *pIn,
+                   uint64_t   &nValue )
+    {
+        const unsigned char *p      =
+            reinterpret_cast<const unsigned char *>(pIn);
+        int                  nShift = 0;
+        nValue = 0;
+        while (*p & 0x80)
+        {
+            nValue |= static_cast<uint64_t>(*p++ & 0x7F) << nShift;
+            nShift += 7;
+        }
+        nValue |= static_cast<uint64_t>(*p++) << nShift;
+        return p - reinterpret_cast<const unsigned char *>(pIn);
+    }
+
+    /**
+     * Writes a count to pOut and returns the number of bytes written
+     * (at most ten).
+     */
+    static size_t
+    EncodeCount ( TCount  nCount,
+                  char   *pOut )
+    {
+        if (!std::is_integral<TCount>::value)
+        {
+            memcpy(pOut, &nCount, sizeof(TCount));
+            return sizeof(TCount);
+        }
+        int64_t nSigned = static_cast<int64_t>(nCount);
+        return EncodeVarint((static_cast<uint64_t>(nSigned) << 1) ^
+                            static_cast<uint64_t>(nSigned >> 63), pOut);
+    }
+
+    static size_t
+    DecodeCount ( const char *pIn,
+                  TCount     &nCount )
+    {
+        if (!std::is_integral<TCount>::value)
+        {
+            memcpy(&nCount, pIn, sizeof(TCount));
+            return sizeof(TCount);
+        }
+        uint64_t nValue;
+        size_t   nBytes = DecodeVarint(pIn, nValue);
+        nCount = static_cast<TCount>(static_cast<int64_t>(
+            (nValue >> 1) ^ (0 - (nValue & 1))));
+        return nBytes;
+    }
+
+    /**
+     * Appends an entry to the bucket's data, without touching its
+     * slots, and returns its offset.
+     */
+    static uint32_t
+    AppendData ( Bucket     &bucket,
+                 const char *pSuffix,
+                 size_t      nLength,
+                 TCount      nCount )
+    {
+        char   Length[10];
+        char   Count[10];
+        size_t nLengthBytes = EncodeVarint(nLength, Length);
+        size_t nCountBytes  = EncodeCount(nCount, Count);
+        size_t nOffset      = bucket.Data.size();
+        size_t nNeeded      = nOffset + nLengthBytes + nLength + nCountBytes;
+        if (nNeeded > bucket.Data.capacity())
+        {
+            // grow by half rather than doubling, to waste less memory
+            bucket.Data.reserve(std::max(nNeeded, bucket.Data.capacity() +
+                                         bucket.Data.capacity() / 2));
+        }
+        bucket.Data.insert(bucket.Data.end(), Length, Length + nLengthBytes);
+        bucket.Data.insert(bucket.Data.end(), pSuffix, pSuffix + nLength);
+        bucket.Data.insert(bucket.Data.end(), Count, Count + nCountBytes);
+        return nOffset;
+    }
+
+    /**
+     * Doubles the slots of a bucket, rehashing its entries.
+     */
+    static void
+    GrowSlots ( Bucket &bucket )
+    {
+        std::vector<uint32_t> OldSlots(bucket.Slots.size() * 2, 0);
+        OldSlots.swap(bucket.Slots);
+        size_t nMask = bucket.Slots.size() - 1;
+        for (uint32_t nSlotValue : OldSlots)
+        {
+            if (!nSlotValue)
+                continue;
+            BucketEntry entry = Decode(bucket, nSlotValue - 1);
+            size_t      nSlot = HashKey(entry.pSuffix, entry.nLength) & nMask;
+            while (bucket.Slots[nSlot])
+                nSlot = (nSlot + 1) & nMask;
+            bucket.Slots[nSlot] = nSlotValue;
+        }
+    }
+
+    /**
+     * Adds nDelta to the count of a suffix in bucket, inserting it if
+     * it is not yet present.  Returns true if it was inserted.
+     */
+    static bool
+    Insert ( Bucket     &bucket,
+             const char *pSuffix,
+             size_t      nLength,
+             TCount      nDelta )
+    {
+        if (bucket.Slots.empty())
+            bucket.Slots.assign(16, 0);
+        size_t nMask = bucket.Slots.size() - 1;
+        size_t nSlot = HashKey(pSuffix, nLength) & nMask;
+        while (bucket.Slots[nSlot])
+        {
+            BucketEntry entry = Decode(bucket, bucket.Slots[nSlot] - 1);
+            if (entry.nLength == nLength &&
+                memcmp(entry.pSuffix, pSuffix, nLength) == 0)
+            {
+                TCount nCount;
+                size_t nOldBytes = DecodeCount(entry.pCount, nCount);
+                char   Count[10];
+                size_t nNewBytes = EncodeCount(nCount + nDelta, Count);
+                if (nNewBytes == nOldBytes)
+                {
+                    memcpy(bucket.Data.data() +
+                           (entry.pCount - bucket.Data.data()), Count,
+                           nNewBytes);
+                }
+                else
+                {
+                    // the old entry is left unused until the bucket is
+                    // split or burst
+                    bucket.Slots[nSlot] = AppendData(bucket, pSuffix, nLength,
+                                                     nCount + nDelta) + 1;
+                }
+                return false;
+            }
+            nSlot = (nSlot + 1) & nMask;
+        }
+        bucket.Slots[nSlot] =
+            AppendData(bucket, pSuffix, nLength, nDelta) + 1;
+        if (++bucket.nEntries * 4 > bucket.Slots.size() * 3)
+            GrowSlots(bucket);
+        return true;
+    }
+
+    /**
+     * Fills Entries with the entries of bucket, in alphabetical order
+     * of suffix.
+     */
+    static void
+    SortedBucket ( const Bucket             &bucket,
+                   std::vector<BucketEntry> &Entries )
+    {
+        Entries.clear();
+        for (uint32_t nSlotValue : bucket.Slots)
+        {
+            if (nSlotValue)
+                Entries.push_back(Decode(bucket, nSlotValue - 1));
+        }
+        std::sort(Entries.begin(), Entries.end(),
+                  [](const BucketEntry &a, const BucketEntry &b)
+                  {
+                      return CompareKeys(a.pSuffix, a.nLength,
+                                         b.pSuffix, b.nLength) < 0;
+                  });
+    }
+
+    /**
+     * Splits or bursts pBucket, a child of pParent, and whatever
+     * buckets that leaves too full.  pBucket's bytes are no longer
+     * counted in m_nBytes.
+     */
+    void
+    Burst ( Node   *pParent,
+            Bucket *pBucket )
+    {
+        std::vector<std::pair<Node *, Bucket *> > Work;
+        Work.emplace_back(pParent, pBucket);
+        while (!Work.empty())
+        {
+            Node   *pNode = Work.back().first;
+            Bucket *pOld  = Work.back().second;
+            Work.pop_back();
+            if (!Overfull(*pOld))
+            {
+                m_nBytes += BucketBytes(*pOld);
+                continue;
+            }
+            if (pOld->nLow == pOld->nHigh)
+            {
+                // every suffix starts with the same byte, and perhaps
+                // with more: all of the bytes they share move into a
+                // chain of new nodes at once, so that a long common
+                // prefix is not copied over once for each of its bytes
+                const char *pShared = 0;
+                size_t      nShared = 0;
+                ForEachEntry(*pOld, [&pShared, &nShared](
+                                        const BucketEntry &entry)
+                {
+                    if (!pShared)
+                    {
+                        pShared = entry.pSuffix;
+                        nShared = entry.nLength;
+                        return;
+                    }
+                    size_t n = 0;
+                    while (n < nShared && n < entry.nLength &&
+                           pShared[n] == entry.pSuffix[n])
+                        n++;
+                    nShared = n;
+                });
+                Node *pLast = pNode;
+                for ( size_t i = 0; i < nShared; i++ )
+                {
+                    Node *pNew = NewNode();
+                    pLast->Children[static_cast<unsigned char>(pShared[i])] =
+                        pNew;
+                    pLast = pNew;
+                    if (i + 1 == nShared)
+                        break;
+                    // the other children of a node in the chain are empty
+                    int c = static_cast<unsigned char>(pShared[i + 1]);
+                    if (c > 0)
+                        SetChildren(pNew, NewEmptyBucket(0, c - 1));
+                    if (c < 255)
+                        SetChildren(pNew, NewEmptyBucket(c + 1, 255));
+                }
+                Bucket *pRest = NewBucket(0, 255);
+                ForEachEntry(*pOld, [pLast, pRest, nShared](
+                                        const BucketEntry &entry)
+                {
+                    TCount nCount;
+                    DecodeCount(entry.pCount, nCount);
+                    if (entry.nLength == nShared)
+                    {
+                        pLast->fHasValue = true;
+                        pLast->nCount    = nCount;
+                    }
+                    else
+                        Place(*pRest, entry.pSuffix + nShared,
+                              entry.nLength - nShared, nCount);
+                });
+                SetChildren(pLast, pRest);
+                delete pOld;
+                Work.emplace_back(pLast, pRest);
+                continue;
+            }
+            // split the range of first bytes: a byte with more than
+            // half of the suffixes gets a bucket of its own, otherwise
+            // the range is halved by number of suffixes
+            size_t Counts[256] = { 0 };
+            ForEachEntry(*pOld, [&Counts](const BucketEntry &entry)
+            {
+                Counts[static_cast<unsigned char>(entry.pSuffix[0])]++;
+            });
+            int nHeavy = -1;
+            for ( int c = pOld->nLow; c <= pOld->nHigh; c++ )
+            {
+                if (Counts[c] * 2 > pOld->nEntries)
+                    nHeavy = c;
+            }
+            std::vector<std::pair<int, int> > Ranges;
+            if (nHeavy >= 0)
+            {
+                if (nHeavy > pOld->nLow)
+                    Ranges.emplace_back(pOld->nLow, nHeavy - 1);
+                Ranges.emplace_back(nHeavy, nHeavy);
+                if (nHeavy < pOld->nHigh)
+                    Ranges.emplace_back(nHeavy + 1, pOld->nHigh);
+            }
+            else
+            {
+                size_t nLeft  = 0;
+                int    nSplit = pOld->nLow;
+                for ( int c = pOld->nLow; c < pOld->nHigh; c++ )
+                {
+                    nLeft += Counts[c];
+                    nSplit = c;
+                    if (nLeft * 2 >= pOld->nEntries)
+                        break;
+                }
+                Ranges.emplace_back(pOld->nLow, nSplit);
+                Ranges.emplace_back(nSplit + 1, pOld->nHigh);
+            }
+            Bucket *Parts[256];
+            for ( size_t i = 0; i < Ranges.size(); i++ )
+            {
+                Bucket *pPart = NewBucket(Ranges[i].first, Ranges[i].second);
+                SetChildren(pNode, pPart);
+                for ( int c = pPart->nLow; c <= pPart->nHigh; c++ )
+                    Parts[c] = pPart;
+            }
+            ForEachEntry(*pOld, [&Parts](const BucketEntry &entry)
+            {
+                TCount nCount;
+                DecodeCount(entry.pCount, nCount);
+                Place(*Parts[static_cast<unsigned char>(entry.pSuffix[0])],
+                      entry.pSuffix, entry.nLength, nCount);
+            });
+            delete pOld;
+            for ( size_t i = 0; i < Ranges.size(); i++ )
+                Work.emplace_back(pNode, Parts[Ranges[i].first]);
+        }
+    }
+
+    template<typename TFunction>
+    static void
+    ForEachEntry ( const Bucket &bucket,
+                   TFunction     fn )
+    {
+        for (uint32_t nSlotValue : bucket.Slots)
+        {
+            if (nSlotValue)
+                fn(Decode(bucket, nSlotValue - 1));
+        }
+    }
+
+    /**
+     * Inserts a suffix known not to be in bucket yet.
+     */
+    static void
+    Place ( Bucket     &bucket,
+            const char *pSuffix,
+            size_t      nLength,
+            TCount      nCount )
+    {
+        if (bucket.Slots.empty())
+            bucket.Slots.assign(16, 0);
+        size_t nMask = bucket.Slots.size() - 1;
+        size_t nSlot = HashKey(pSuffix, nLength) & nMask;
+        while (bucket.Slots[nSlot])
+            nSlot = (nSlot + 1) & nMask;
+        bucket.Slots[nSlot] =
+            AppendData(bucket, pSuffix, nLength, nCount) + 1;
+        if (++bucket.nEntries * 4 > bucket.Slots.size() * 3)
+            GrowSlots(bucket);
+    }
+
+    Node   *m_pRoot;
+    size_t  m_nSize;
+    size_t  m_nBytes;
+};
+
+#endif // TRIETABLE_H